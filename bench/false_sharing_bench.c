@@ -0,0 +1,107 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * @brief Throughput benchmark for the cache line layout of the hot control blocks.
+ *
+ * The same source is built twice: `false_sharing_bench` with the configured CUTILS_CACHE_LINE_SIZE
+ * and `false_sharing_bench_packed` with CUTILS_CACHE_LINE_SIZE=0, which reproduces the old packed
+ * layout. Run both on the target and compare the numbers.
+ *
+ * The scenario is a ring buffer with one writer and one reader spinning on the lock free offsets.
+ * ts_queue_t is not measured: its fields are only touched under its mutex, so it is not padded.
+ */
+
+#include <cutils/ring_buffer.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_RING_BUFFER_SIZE (4096)
+#define BENCH_RING_BUFFER_MSG_SIZE (64)
+#define BENCH_RING_BUFFER_TOTAL_BYTES (256UL * 1024 * 1024)
+
+static ring_buffer_t s_rb;
+static uint8_t s_rb_data[BENCH_RING_BUFFER_SIZE];
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void *rb_writer(void *arg) {
+  (void)arg;
+  uint8_t msg[BENCH_RING_BUFFER_MSG_SIZE] = {0};
+  unsigned long written = 0;
+  while (written < BENCH_RING_BUFFER_TOTAL_BYTES) {
+    uint32_t n = ring_buffer_write_data(&s_rb, msg, sizeof(msg));
+    if (!n) {
+      // Only matters when the machine has fewer cores than threads.
+      sched_yield();
+    }
+    written += n;
+  }
+  return NULL;
+}
+
+static void *rb_reader(void *arg) {
+  (void)arg;
+  unsigned long read = 0;
+  while (read < BENCH_RING_BUFFER_TOTAL_BYTES) {
+    ring_buffer_data_t data = ring_buffer_get_data(&s_rb, BENCH_RING_BUFFER_MSG_SIZE, false);
+    if (!data.total_bytes) {
+      sched_yield();
+    }
+    read += data.total_bytes;
+  }
+  return NULL;
+}
+
+static void bench_ring_buffer(void) {
+  ring_buffer_create_params_t params = {
+      .buffer = &s_rb, .data = s_rb_data, .size_in_bytes = sizeof(s_rb_data)};
+  create_ring_buffer(&params);
+  ring_buffer_reset_at_offset(&s_rb, 0);
+
+  pthread_t w, r;
+  double start = now_sec();
+  pthread_create(&r, NULL, rb_reader, NULL);
+  pthread_create(&w, NULL, rb_writer, NULL);
+  pthread_join(w, NULL);
+  pthread_join(r, NULL);
+  double elapsed = now_sec() - start;
+  printf("  ring_buffer 1w/1r      %10.1f MB/s\n",
+         (double)BENCH_RING_BUFFER_TOTAL_BYTES / elapsed / (1024.0 * 1024.0));
+}
+
+int main(void) {
+  printf("CUTILS_CACHE_LINE_SIZE=%d sizeof(ring_buffer_t)=%zu\n",
+         CUTILS_CACHE_LINE_SIZE,
+         sizeof(ring_buffer_t));
+  bench_ring_buffer();
+  return 0;
+}
@@ -25,6 +25,7 @@
 #pragma once
 
 #include <cutils/logger.h>
+#include <cutils/mem_report.h>
 #include <cutils/types.h>
 #include <inttypes.h>
 #include <string.h>
@@ -51,7 +52,14 @@ typedef void *accumulator_h;
     uint8_t buffer[size_in_bytes];                                                                 \
   } ACCUMULATOR_STORE_T(name)
 #define ACCUMULATOR_STORE_DEF(name)                                                                \
-  ACCUMULATOR_STORE_T(name) ACCUMULATOR_STORE(name) __attribute__((section(".bss.noinit")))
+  ACCUMULATOR_STORE_T(name) ACCUMULATOR_STORE(name) __attribute__((section(".bss.noinit")));       \
+  MEM_REPORT_RECORD(accumulator_##name,                                                            \
+                    MemReportAccumulator,                                                          \
+                    MemReportAccumulator,                                                          \
+                    #name,                                                                         \
+                    sizeof(ACCUMULATOR_STORE(name)),                                               \
+                    sizeof(ACCUMULATOR_STORE(name).buffer),                                        \
+                    1)
 
 #define ACCUMULATOR_CREATE_PARAMS_INIT(params, name)                                               \
   (params).acc = &ACCUMULATOR_STORE(name).acc;                                                     \
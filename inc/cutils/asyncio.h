@@ -210,9 +210,16 @@ typedef struct _asyncio_create_params_t {
   static uint32_t __tx_max_buf_size_##name = (tx_max_buf_size) ? tx_max_buf_size : buffer_align;
 
 #define ASYNCIO_STORE_DEF(name)                                                                    \
-  POOL_STORE_DEF(name##_tx);                                                                       \
-  POOL_STORE_DEF(name##_rx);                                                                       \
-  ASYNCIO_STORE_T(name) ASYNCIO_STORE(name) = {0}
+  POOL_STORE_DEF_OWNED(name##_tx, MemReportAsyncio);                                               \
+  POOL_STORE_DEF_OWNED(name##_rx, MemReportAsyncio);                                               \
+  ASYNCIO_STORE_T(name) ASYNCIO_STORE(name) = {0};                                                 \
+  MEM_REPORT_RECORD(asyncio_##name,                                                                \
+                    MemReportAsyncio,                                                              \
+                    MemReportAsyncio,                                                              \
+                    #name,                                                                         \
+                    sizeof(ASYNCIO_STORE(name)),                                                   \
+                    1,                                                                             \
+                    sizeof(ASYNCIO_STORE(name)))
 
 #define ASYNCIO_CREATE_PARAMS_INIT(                                                                \
     params, name, st_name, read_fn, write_fn, rx_cb, rx_dq, tx_dq, p_priv)                         \
@@ -113,20 +113,25 @@ static inline int thrd_create(thrd_t *thr, thrd_start_t func, void *arg) {
   return res == ENOMEM ? thrd_nomem : thrd_error;
 }
 
+/* policy is a SCHED_* value taking explicit control of scheduling, or -1 for the build's
+ * CUTILS_PTHREAD_SCHED_POLICY. affinity is a CPU mask, bit n for CPU n, with 0 for any CPU. */
 static inline int thrd_create_ex(thrd_t *thr,
                                  thrd_start_t func,
                                  void *arg,
                                  char *label,
+                                 int policy,
                                  int priority,
+                                 uint64_t affinity,
                                  void *stack,
                                  size_t stack_size) {
   pthread_attr_t attr = {0};
   size_t min_stack_size = 0;
   pthread_attr_init(&attr);
   /* label is stored by the task layer (see task_get_current_name in
-   * src/c11/task.c, which reads a thread-local task pointer); thread naming
-   * via pthread_setname_np was removed for portability since it is a glibc
-   * Linux-only (_GNU_SOURCE) extension. See issue #23. */
+   * src/c11/task.c, which reads a thread-local task pointer). The task layer
+   * also names the thread where CUTILS_HAVE_PTHREAD_NP says
+   * pthread_setname_np exists, since it is a glibc Linux-only (_GNU_SOURCE)
+   * extension. See issue #23. */
   (void)label;
 
   int rval = pthread_attr_getstacksize(&attr, &min_stack_size);
@@ -135,38 +140,57 @@ static inline int thrd_create_ex(thrd_t *thr,
    * PTHREAD_EXPLICIT_SCHED on SCHED_FIFO/SCHED_RR (needs CAP_SYS_NICE on
    * Linux). Under the default SCHED_OTHER, .priority is a no-op and we inherit
    * the parent's scheduling so the build runs unprivileged. See issue #22. */
-#if CUTILS_PTHREAD_SCHED_POLICY == SCHED_FIFO || \
-    CUTILS_PTHREAD_SCHED_POLICY == SCHED_RR
-  rval = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
-  CHECK_RUN(!rval, pthread_attr_destroy(&attr); return rval, "Failed to set scheduling parameter");
-  rval = pthread_attr_setschedpolicy(&attr, SCHEDULING_POLICY);
-  CHECK_RUN(!rval, pthread_attr_destroy(&attr); return rval, "Failed to set scheduling policy");
-  struct sched_param param = {.sched_priority = priority};
-  rval = pthread_attr_setschedparam(&attr, &param);
-  CHECK_RUN(!rval, pthread_attr_destroy(&attr);
-            return rval, "Failed to set priority to %d", param.sched_priority);
+  if (policy < 0 && (SCHEDULING_POLICY == SCHED_FIFO || SCHEDULING_POLICY == SCHED_RR)) {
+    policy = SCHEDULING_POLICY;
+  }
+  if (policy >= 0) {
+    rval = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    CHECK_RUN(!rval, pthread_attr_destroy(&attr); return rval, "Failed to set scheduling parameter");
+    rval = pthread_attr_setschedpolicy(&attr, policy);
+    CHECK_RUN(!rval, pthread_attr_destroy(&attr); return rval, "Failed to set scheduling policy");
+    struct sched_param param = {.sched_priority = priority};
+    if (param.sched_priority < sched_get_priority_min(policy)) {
+      param.sched_priority = sched_get_priority_min(policy);
+    } else if (param.sched_priority > sched_get_priority_max(policy)) {
+      param.sched_priority = sched_get_priority_max(policy);
+    }
+    rval = pthread_attr_setschedparam(&attr, &param);
+    CHECK_RUN(!rval, pthread_attr_destroy(&attr);
+              return rval, "Failed to set priority to %d", param.sched_priority);
+  } else {
+    /* SCHED_OTHER: priority range is 0..0, so .priority is a no-op. Inherit the
+     * creating thread's scheduling to avoid the CAP_SYS_NICE requirement. */
+    rval = pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+    CHECK_RUN(!rval, pthread_attr_destroy(&attr); return rval, "Failed to set inherit scheduling");
+  }
+  if (affinity) {
+#ifdef CUTILS_HAVE_PTHREAD_NP
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (unsigned int cpu = 0; cpu < 64; cpu++) {
+      if (affinity & ((uint64_t)1 << cpu)) {
+        CPU_SET(cpu, &cpus);
+      }
+    }
+    rval = pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
 #else
-  /* SCHED_OTHER: priority range is 0..0, so .priority is a no-op. Inherit the
-   * creating thread's scheduling to avoid the CAP_SYS_NICE requirement. */
-  (void)priority;
-  rval = pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
-  CHECK_RUN(!rval, pthread_attr_destroy(&attr); return rval, "Failed to set inherit scheduling");
+    rval = ENOTSUP;
 #endif
+    CHECK_RUN(!rval, pthread_attr_destroy(&attr); return rval,
+              "Failed to set CPU affinity 0x%llx", (unsigned long long)affinity);
+  }
   if (stack && stack_size >= min_stack_size) {
     rval = pthread_attr_setstack(&attr, stack, stack_size);
     CHECK_RUN(!rval, pthread_attr_destroy(&attr);
               return rval, "Failed to set stack", stack);
   }
-  CHECK_RUN(!rval, pthread_attr_destroy(&attr);
-            return rval,
-                   "Failed to set scheduling priority between (%d, %d)",
-                   sched_get_priority_min(SCHEDULING_POLICY),
-                   sched_get_priority_max(SCHEDULING_POLICY));
   int res = c11threads_pthread_create(thr, &attr, func, arg);
   pthread_attr_destroy(&attr);
   if (res == 0) {
     return thrd_success;
   } else {
+    // EPERM: a real time policy without CAP_SYS_NICE. EINVAL: no allowed CPU is online.
+    CLOG("Couldn't create thread, error %d", res);
     return thrd_error;
   }
 }
@@ -99,10 +99,16 @@ static inline bool event_flag_wait(event_flag_t *p_flags,
       clock_gettime(CLOCK_REALTIME, &ts);
       ts.tv_sec += wait_ms / 1000;
       ts.tv_nsec += (wait_ms % 1000) * 1000000;
+      if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+      }
     }
     int rval = 0;
     if (wait_ms == NO_SLEEP) {
       rval = mtx_trylock(&p_flags->mtx);
+    } else if (wait_ms == WAIT_FOREVER) {
+      rval = mtx_lock(&p_flags->mtx);
     } else {
       rval = mtx_timedlock(&p_flags->mtx, &ts);
     }
@@ -112,19 +118,22 @@ static inline bool event_flag_wait(event_flag_t *p_flags,
         clock_gettime(CLOCK_REALTIME, &ts);
         ts.tv_sec += wait_ms / 1000;
         ts.tv_nsec += (wait_ms % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+          ts.tv_sec++;
+          ts.tv_nsec -= 1000000000;
+        }
         rval = cnd_timedwait(&p_flags->cv, &p_flags->mtx, &ts);
       } else {
         rval = cnd_wait(&p_flags->cv, &p_flags->mtx);
       }
-      CHECK_RUN(!rval || (rval != thrd_timedout && rval != thrd_error), mtx_unlock(&p_flags->mtx);
-                return retval;
-                , "Condition Variable wait failed due to error: %d", rval);
       if (rval) {
         break;
       }
     }
     mtx_unlock(&p_flags->mtx);
-    retval = true;
+    // Running out of time is how a timed wait normally fails, so only other errors are logged.
+    CLOG_IF(rval && rval != thrd_timedout, "Condition Variable wait failed due to error: %d", rval);
+    retval = !rval;
   }
   return retval;
 }
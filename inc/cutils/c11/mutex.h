@@ -34,6 +34,12 @@ typedef struct _mutex_t {
   mtx_t mtx;
 } mutex_t;
 
+/**
+ * @brief Static initializer for a mutex_t, equivalent to mutex_new(). mtx_t is a pthread mutex in
+ * the c11threads shim.
+ */
+#define MUTEX_STATIC_INIT {.mtx = PTHREAD_MUTEX_INITIALIZER}
+
 static inline bool mutex_new(mutex_t *mutex) {
   bool retval = false;
   if (mutex && !mtx_init(&mutex->mtx, mtx_timed)) {
@@ -58,6 +64,10 @@ static inline bool mutex_lock(mutex_t *mutex, uint32_t wait_ms) {
       clock_gettime(CLOCK_REALTIME, &tm);
       tm.tv_sec += wait_ms / 1000;
       tm.tv_nsec += 1000000 * (wait_ms % 1000);
+      if (tm.tv_nsec >= 1000000000) {
+        tm.tv_sec++;
+        tm.tv_nsec -= 1000000000;
+      }
       retval = (!mtx_timedlock(&mutex->mtx, &tm));
     }
   }
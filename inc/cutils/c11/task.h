@@ -24,6 +24,7 @@
 #pragma once
 
 #include <cutils/c11/c11threads.h>
+#include <cutils/mem_report.h>
 #include <cutils/os_types.h>
 
 #ifdef __cplusplus
@@ -71,7 +72,7 @@ typedef struct _task_t {
 } task_t;
 
 /**
- * @brief Parameters used to initialize a task.
+ * @brief Parameters used to initialize a task. The optional fields behave as on the pthread port.
  */
 typedef struct _task_create_params_t {
   task_t *task;
@@ -81,6 +82,9 @@ typedef struct _task_create_params_t {
   void *ctx;
   void *stack;
   uint32_t stack_size;
+  /* CPUs the task may run on, bit n for CPU n. 0 leaves it to the OS. */
+  uint64_t affinity;
+  task_sched_policy_e sched_policy;
 } task_create_params_t;
 
 /**
@@ -102,8 +106,18 @@ typedef struct _task_create_params_t {
   } TASK_STATIC_STORE_T(name)
 
 /** @brief Defines the static store in a special section to persist across soft resets if supported. */
-#define TASK_STATIC_STORE_DEF(name)                                                                \
-  TASK_STATIC_STORE_T(name) TASK_STATIC_STORE(name) __attribute__((section(".bss.noinit"), used))
+#define TASK_STATIC_STORE_DEF(name) TASK_STATIC_STORE_DEF_OWNED(name, MemReportTask)
+
+/** @brief As above, registering the store with mem_report under an enclosing `owner` kind. */
+#define TASK_STATIC_STORE_DEF_OWNED(name, owner)                                                   \
+  TASK_STATIC_STORE_T(name) TASK_STATIC_STORE(name) __attribute__((section(".bss.noinit"), used)); \
+  MEM_REPORT_RECORD(task_##name,                                                                   \
+                    MemReportTask,                                                                 \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(TASK_STATIC_STORE(name)),                                               \
+                    1,                                                                             \
+                    sizeof(TASK_STATIC_STORE(name).stack))
 
 /** @brief Internal helper to map a static store to task create parameters. */
 #define TASK_INIT_CREATE_PARAMS_FROM_STORE(params, store_ptr, lbl, pri, fn, context)               \
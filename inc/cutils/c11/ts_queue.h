@@ -26,6 +26,7 @@
 #define CUTILS_C11_TS_QUEUE_H
 
 #include <cutils/c11/c11threads.h>
+#include <cutils/mem_report.h>
 #include <cutils/mutex.h>
 
 #ifdef __cplusplus
@@ -46,13 +47,55 @@ typedef struct {
 #define TS_QUEUE_STORE(name) _ts_queue_store_##name
 #define TS_QUEUE_STORE_T(name) _ts_queue_store_##name##_t
 #define TS_QUEUE_STORE_DECL(name, size)                                                            \
-  static size_t _ts_queue_store_num_elements_##name = size;                                        \
+  enum { _ts_queue_store_num_elements_##name = (size) };                                           \
   typedef struct {                                                                                 \
     void *ptr_array[size];                                                                         \
     ts_queue_t queue;                                                                              \
   } TS_QUEUE_STORE_T(name)
 
-#define TS_QUEUE_STORE_DEF(name) static TS_QUEUE_STORE_T(name) TS_QUEUE_STORE(name)
+#define TS_QUEUE_STORE_DEF(name) TS_QUEUE_STORE_DEF_OWNED(name, MemReportTsQueue)
+
+/** @brief As above, registering the store with mem_report under an enclosing `owner` kind. */
+#define TS_QUEUE_STORE_DEF_OWNED(name, owner)                                                      \
+  static TS_QUEUE_STORE_T(name) TS_QUEUE_STORE(name);                                              \
+  MEM_REPORT_RECORD(ts_queue_##name,                                                               \
+                    MemReportTsQueue,                                                              \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(TS_QUEUE_STORE(name)),                                                  \
+                    GetArraySize(TS_QUEUE_STORE(name).ptr_array),                                  \
+                    sizeof(void *))
+
+/**
+ * @brief Defines the static storage with the queue already initialized, so that it can be used
+ * through TS_QUEUE_STATIC(name) without calling ts_queue_init(). The size must be a power of 2.
+ */
+#define TS_QUEUE_STORE_DEF_STATIC(name) TS_QUEUE_STORE_DEF_STATIC_OWNED(name, MemReportTsQueue)
+
+/** @brief As above, registering the store with mem_report under an enclosing `owner` kind. */
+#define TS_QUEUE_STORE_DEF_STATIC_OWNED(name, owner)                                               \
+  _Static_assert(                                                                                  \
+      !(_ts_queue_store_num_elements_##name & (_ts_queue_store_num_elements_##name - 1)),          \
+      "Queue Size must be a power of 2");                                                          \
+  static TS_QUEUE_STORE_T(name) TS_QUEUE_STORE(name) = {                                           \
+      .queue = {.pp_ptr_array = TS_QUEUE_STORE(name).ptr_array,                                    \
+                .size = _ts_queue_store_num_elements_##name,                                       \
+                .mtx = MUTEX_STATIC_INIT,                                                          \
+                .cnd = PTHREAD_COND_INITIALIZER,                                                   \
+                .full_cnd = PTHREAD_COND_INITIALIZER}};                                            \
+  MEM_REPORT_RECORD(ts_queue_##name,                                                               \
+                    MemReportTsQueue,                                                              \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(TS_QUEUE_STORE(name)),                                                  \
+                    GetArraySize(TS_QUEUE_STORE(name).ptr_array),                                  \
+                    sizeof(void *))
+
+/** @brief The queue of a store defined with TS_QUEUE_STORE_DEF_STATIC(). */
+#define TS_QUEUE_STATIC(name) (&TS_QUEUE_STORE(name).queue)
+
+/** @brief Set on ports that support TS_QUEUE_STORE_DEF_STATIC(). */
+#define CUTILS_TS_QUEUE_HAS_STATIC_INIT (1)
 
 typedef struct {
   ts_queue_t *p_queue;
@@ -101,6 +144,10 @@ static inline bool ts_queue_enqueue(ts_queue_t *p_queue, void *p_item, uint32_t
   if (wait_ms != WAIT_FOREVER) {
     ts.tv_sec += wait_ms / 1000;
     ts.tv_nsec += ((long)wait_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
   }
   if (p_queue && p_item) {
     mutex_lock(&p_queue->mtx, WAIT_FOREVER);
@@ -132,6 +179,10 @@ static inline bool ts_queue_dequeue(ts_queue_t *p_queue, void **pp_item, uint32_
   if (wait_ms != WAIT_FOREVER) {
     ts.tv_sec += wait_ms / 1000;
     ts.tv_nsec += ((long)wait_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
   }
   if (p_queue && pp_item) {
     int rval = 0;
@@ -157,6 +208,122 @@ static inline bool ts_queue_dequeue(ts_queue_t *p_queue, void **pp_item, uint32_
   return retval;
 }
 
+/**
+ * @brief Enqueues up to `num_items` items under a single lock acquisition, waiting up to
+ * `wait_ms` for space whenever the queue is full.
+ * @return the number of items enqueued, in order from the front of `pp_items`.
+ */
+static inline size_t
+ts_queue_enqueue_batch(ts_queue_t *p_queue, void **pp_items, size_t num_items, uint32_t wait_ms) {
+  struct timespec ts = {0};
+  size_t retval = 0;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  if (wait_ms != WAIT_FOREVER) {
+    ts.tv_sec += wait_ms / 1000;
+    ts.tv_nsec += ((long)wait_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
+  }
+  if (p_queue && pp_items) {
+    mutex_lock(&p_queue->mtx, WAIT_FOREVER);
+    int rval = 0;
+    while (retval < num_items && rval != thrd_timedout) {
+      if (p_queue->tail + p_queue->size <= p_queue->head) {
+        // Wake the consumer for the items already in before waiting for it to free space.
+        cnd_broadcast(&p_queue->cnd);
+        if (wait_ms == WAIT_FOREVER) {
+          rval = cnd_wait(&p_queue->full_cnd, &p_queue->mtx.mtx);
+        } else {
+          rval = cnd_timedwait(&p_queue->full_cnd, &p_queue->mtx.mtx, &ts);
+        }
+      } else {
+        p_queue->pp_ptr_array[atomic_fetch_add(&p_queue->head, 1UL) & (p_queue->size - 1)] =
+            pp_items[retval++];
+        p_queue->count++;
+      }
+    }
+    if (retval) {
+      cnd_broadcast(&p_queue->cnd);
+    }
+    mutex_unlock(&p_queue->mtx);
+  }
+  return retval;
+}
+
+/**
+ * @brief Dequeues every queued item, up to `max_items`, under a single lock acquisition. Waits up
+ * to `wait_ms` for the first item.
+ * @return the number of items written to `pp_items`, 0 on timeout.
+ */
+static inline size_t
+ts_queue_dequeue_batch(ts_queue_t *p_queue, void **pp_items, size_t max_items, uint32_t wait_ms) {
+  size_t retval = 0;
+  struct timespec ts = {0};
+  clock_gettime(CLOCK_REALTIME, &ts);
+
+  if (wait_ms != WAIT_FOREVER) {
+    ts.tv_sec += wait_ms / 1000;
+    ts.tv_nsec += ((long)wait_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
+  }
+  if (p_queue && pp_items && max_items) {
+    int rval = 0;
+    mutex_lock(&p_queue->mtx, WAIT_FOREVER);
+    while (p_queue->tail >= p_queue->head && rval != thrd_timedout) {
+      if (wait_ms == WAIT_FOREVER) {
+        rval = cnd_wait(&p_queue->cnd, &p_queue->mtx.mtx);
+      } else {
+        rval = cnd_timedwait(&p_queue->cnd, &p_queue->mtx.mtx, &ts);
+      }
+    }
+    if (rval == thrd_success) {
+      size_t tail = p_queue->tail;
+      size_t available = p_queue->head - tail;
+      retval = (available < max_items) ? available : max_items;
+      for (size_t i = 0; i < retval; i++) {
+        pp_items[i] = p_queue->pp_ptr_array[(tail + i) & (p_queue->size - 1)];
+      }
+      atomic_fetch_add(&p_queue->tail, retval);
+      p_queue->count -= retval;
+      cnd_broadcast(&p_queue->full_cnd);
+    }
+    mutex_unlock(&p_queue->mtx);
+  }
+  return retval;
+}
+
+/**
+ * @brief Dequeues the head item under the queue's lock if `take` accepts it. Never blocks.
+ * @return true if the head was dequeued.
+ */
+static inline bool ts_queue_dequeue_if(ts_queue_t *p_queue,
+                                       bool (*take)(void *p_item, void *ctx),
+                                       void *ctx,
+                                       void **pp_item) {
+  bool retval = false;
+  if (p_queue && take && pp_item) {
+    mutex_lock(&p_queue->mtx, WAIT_FOREVER);
+    if (p_queue->tail < p_queue->head) {
+      void *p_item = p_queue->pp_ptr_array[p_queue->tail & (p_queue->size - 1)];
+      if (take(p_item, ctx)) {
+        atomic_fetch_add(&p_queue->tail, 1);
+        p_queue->count--;
+        cnd_signal(&p_queue->full_cnd);
+        *pp_item = p_item;
+        retval = true;
+      }
+    }
+    mutex_unlock(&p_queue->mtx);
+  }
+  return retval;
+}
+
 static inline size_t ts_queue_get_count(ts_queue_t *p_queue) { return p_queue->count; }
 
 #ifdef __cplusplus
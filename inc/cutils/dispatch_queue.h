@@ -24,20 +24,241 @@
 
 #pragma once
 
+#include <cutils/event_flag.h>
+#include <cutils/mutex.h>
 #include <cutils/os_types.h>
 #include <cutils/pool.h>
 #include <cutils/signal.h>
 #include <cutils/task.h>
 #include <cutils/ts_queue.h>
 #include <stdatomic.h>
+#include <stddef.h>
+
+/**
+ * @brief Used internally to pass data asynchronously between the queue worker thread and the post
+ * routines. Every record of every queue pays for it, 56 bytes on 64-bit targets. Cancellation, QoS
+ * and profiling can be used on any queue at run time, so their fields live here. What only some
+ * queues need lives behind the record, see dispatch_edf_post_data_t and dispatch_async_copy_f().
+ */
+typedef struct _dispatch_queue_post_data_t {
+  dispatch_function_t fn;
+  void *arg1;
+  void *arg2;
+  uint32_t flags;
+  /* Generation of the record, see dispatch_cancel(). Even while an item may still run, odd once
+   * it has been cancelled. Bumped as a cancellable item is run or skipped, so old tokens expire. */
+  atomic_uint seq;
+  /* Left once the item has run, if it was posted with dispatch_group_async_f(). */
+  struct _dispatch_group_t *p_group;
+  /* Links the items a serial worker has taken but not run yet, one list per QoS class. */
+  struct _dispatch_queue_post_data_t *p_next;
+  /* When the item was posted, 0 unless its queue is being profiled. */
+  cutils_ticks_t posted_at;
+} dispatch_queue_post_data_t;
+
+#define DISPATCH_QUEUE_ALIGN_UP(size)                                                              \
+  (((size) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1))
+
+/**
+ * @brief Where dispatch_async_copy_f() puts its copy: right behind the record, aligned for any
+ * type. Only the records of queues declared with an inline size have room there.
+ */
+#define DISPATCH_QUEUE_INLINE_OFFSET DISPATCH_QUEUE_ALIGN_UP(sizeof(dispatch_queue_post_data_t))
+
+/** @brief Size and alignment of the post records of a queue declared with `inline_size`. */
+#define DISPATCH_QUEUE_RECORD_SIZE(inline_size)                                                    \
+  ((inline_size) ? DISPATCH_QUEUE_INLINE_OFFSET + DISPATCH_QUEUE_ALIGN_UP(inline_size)             \
+                 : sizeof(dispatch_queue_post_data_t))
+#define DISPATCH_QUEUE_RECORD_ALIGN(inline_size)                                                   \
+  ((inline_size) ? alignof(max_align_t) : alignof(dispatch_queue_post_data_t))
+
+/** @brief The post record of an EDF queue, which carries the deadline behind the common part. */
+typedef struct _dispatch_edf_post_data_t {
+  dispatch_queue_post_data_t post;
+  /* Absolute task_get_ms() deadline, and the order the worker took the item in to break ties. */
+  uint32_t deadline_ms;
+  uint32_t order;
+} dispatch_edf_post_data_t;
+
+/** @brief The item must run alone on a concurrent queue. */
+#define DISPATCH_POST_FLAG_BARRIER (1 << 0)
+/** @brief Someone waits on the item, so DISPATCH_OVERFLOW_DROP_OLDEST must not discard it. */
+#define DISPATCH_POST_FLAG_NO_DROP (1 << 1)
+/** @brief The item was posted with dispatch_async_cancellable_f(). */
+#define DISPATCH_POST_FLAG_CANCELLABLE (1 << 2)
+/** @brief The item was posted with dispatch_async_deadline_f(). */
+#define DISPATCH_POST_FLAG_DEADLINE (1 << 3)
+
+/** @brief Service classes of the items of a serial queue, see dispatch_async_qos_f(). */
+typedef enum {
+  DISPATCH_QOS_DEFAULT,    /**< What every other post uses. */
+  DISPATCH_QOS_HIGH,       /**< Latency sensitive work, such as control events. */
+  DISPATCH_QOS_BACKGROUND, /**< Bulk work that can wait, such as log flushes. */
+  DISPATCH_QOS_COUNT,
+} dispatch_qos_e;
+
+#define DISPATCH_POST_QOS_SHIFT (8)
+/** @brief Carries a dispatch_qos_e in the post flags. */
+#define DISPATCH_POST_FLAG_QOS(qos) ((uint32_t)(qos) << DISPATCH_POST_QOS_SHIFT)
+#define DISPATCH_POST_QOS(flags) ((dispatch_qos_e)(((flags) >> DISPATCH_POST_QOS_SHIFT) & 0x3))
+
+/**
+ * @brief How many times in a row a waiting class can be passed over for a higher one before it
+ * gets the next turn.
+ */
+#ifndef DISPATCH_QOS_STARVATION_LIMIT
+#define DISPATCH_QOS_STARVATION_LIMIT (8)
+#endif
+
+/** @brief What a post does when the queue has no free post record. */
+typedef enum {
+  DISPATCH_OVERFLOW_DEFAULT,     /**< Use the queue's policy, see dispatch_queue_set_overflow(). */
+  DISPATCH_OVERFLOW_ASSERT,      /**< Treat it as a fatal error. What a queue does by default. */
+  DISPATCH_OVERFLOW_FAIL,        /**< Refuse the post and return false. */
+  DISPATCH_OVERFLOW_BLOCK,       /**< Wait up to the timeout for an item to finish. */
+  DISPATCH_OVERFLOW_DROP_OLDEST, /**< Discard the oldest queued item and post in its place. */
+  DISPATCH_OVERFLOW_RUN_INLINE,  /**< Run the item on the caller instead. */
+} dispatch_overflow_policy_e;
+
+/** @brief Overflow outcome counts of a queue, see dispatch_queue_get_overflow(). */
+typedef struct _dispatch_queue_overflow_stats_t {
+  uint32_t rejected;   /**< Posts refused, by policy or because nothing could be dropped. */
+  uint32_t blocked;    /**< Posts that waited for room and got it. */
+  uint32_t timed_out;  /**< Posts that waited for room and gave up. */
+  uint32_t dropped;    /**< Queued items discarded to make room. */
+  uint32_t ran_inline; /**< Posts run on the caller instead. */
+  uint32_t cancelled;  /**< Cancelled items the queue skipped. */
+} dispatch_queue_overflow_stats_t;
+
+/** @brief Deadline counts of an EDF queue, see dispatch_queue_get_deadlines(). */
+typedef struct _dispatch_deadline_stats_t {
+  uint32_t ran;             /**< Items posted with a deadline that have run. */
+  uint32_t missed;          /**< Those that finished after their deadline. */
+  uint32_t max_lateness_ms; /**< How late the latest of them finished. */
+} dispatch_deadline_stats_t;
+
+/** @brief A poll budget that never runs out, see dispatch_queue_set_poll(). */
+#define DISPATCH_POLL_FOREVER ((cutils_ticks_t)-1)
+
+/**
+ * @brief Checks a polling worker makes between yields, so posters sharing its core still run.
+ */
+#ifndef DISPATCH_POLL_YIELD_SPINS
+#define DISPATCH_POLL_YIELD_SPINS (64)
+#endif
+
+/** @brief What polling has cost a serial queue, see dispatch_queue_get_poll(). */
+typedef struct _dispatch_poll_stats_t {
+  cutils_ticks_t spent; /**< Time the worker spent polling, in cutils_ticks_t. */
+  uint32_t hits;        /**< Polls that saw an item posted. */
+  uint32_t misses;      /**< Polls whose budget ran out, after which the worker blocked. */
+} dispatch_poll_stats_t;
+
+/**
+ * @brief One worker of a concurrent dispatch queue. Each worker owns a bounded deque of posted
+ * items: the owner runs items from the top (oldest first) and idle workers steal from the bottom.
+ */
+typedef struct _dispatch_worker_t {
+  CUTILS_CACHE_ALIGNED mutex_t mtx;
+  dispatch_queue_post_data_t **pp_items;
+  uint32_t mask;
+  uint32_t top;
+  uint32_t bottom;
+  event_flag_t flags;
+  task_t *p_task;
+  struct _dispatch_queue_t *p_queue;
+  uint32_t index;
+} dispatch_worker_t;
+
+/** @brief The worker set behind a concurrent dispatch queue. */
+typedef struct _dispatch_workers_t {
+  dispatch_worker_t *p_workers;
+  uint32_t num_workers;
+  /* Round robin cursor for posts, written by every poster. */
+  CUTILS_CACHE_ALIGNED atomic_uint next;
+  /* One bit per parked worker. */
+  CUTILS_CACHE_ALIGNED atomic_uint idle_mask;
+  /* Items handed to workers and not finished yet, counted by posters and workers. */
+  CUTILS_CACHE_ALIGNED atomic_uint inflight;
+  /* Barriers posted and not finished yet. While non-zero, posts go through the gate. */
+  CUTILS_CACHE_ALIGNED atomic_uint barriers_pending;
+  /* Items held back behind a barrier, in post order. Protected by gate_mtx. */
+  mutex_t gate_mtx;
+  dispatch_queue_post_data_t **pp_held;
+  uint32_t held_mask;
+  uint32_t held_head;
+  uint32_t held_tail;
+  bool barrier_running;
+} dispatch_workers_t;
+
+#define DISPATCH_QUEUE_MAX_WORKERS (32)
+
+/**
+ * @brief Most items a serial queue worker takes off its queue at once. Items of one batch run back
+ * to back under one hold of the execution lock and their records go back to the pool together.
+ * A queue can lower its own cap through `batch_max` in its create params.
+ */
+#ifndef DISPATCH_QUEUE_BATCH_MAX
+#define DISPATCH_QUEUE_BATCH_MAX (16)
+#endif
+
+/**
+ * @brief Most items a serial queue worker keeps on its local run list, see dispatch_async_f().
+ * Posts beyond that take the shared queue.
+ */
+#ifndef DISPATCH_QUEUE_LOCAL_MAX
+#define DISPATCH_QUEUE_LOCAL_MAX (8)
+#endif
 
 typedef struct _dispatch_queue_t {
-  atomic_bool destroying;
+  /* Read by every poster. */
   ts_queue_t *queue;
-  task_t *p_task;
   pool_t *p_pool;
+  task_t *p_task;
   char *label;
+  /* Set for concurrent queues, which have no queue or task of their own. */
+  dispatch_workers_t *p_workers;
+  /* Set for targeted serial queues, which run their items on this queue instead of a task. */
+  struct _dispatch_queue_t *p_target;
+  /* The drain of a targeted queue, reserved on the target for as long as the queue lives. */
+  struct _dispatch_queue_post_data_t *p_drain;
+  /* The task running the drain of a targeted queue, NULL between drains. */
+  _Atomic(task_t *) p_drain_task;
+  uint32_t batch_max;
+  /* Set by dispatch_queue_set_profile(), NULL while the queue is not profiled. */
+  _Atomic(struct _dispatch_profile_t *) p_profile;
+  /* How long the worker polls before it blocks, 0 to block right away. */
+  _Atomic(cutils_ticks_t) poll_budget;
+  /* Set by the first post with a QoS class, after which the worker orders items by class. */
+  atomic_bool uses_qos;
+  /* The worker's local run list while it runs a FIFO batch, NULL otherwise. */
+  _Atomic(struct _dispatch_local_runs_t *) p_local;
+  /* Set for earliest deadline first queues: the heap of items the worker has taken, by deadline. */
+  struct _dispatch_queue_post_data_t **pp_deadline_heap;
+  uint32_t deadline_heap_size;
+  atomic_uint deadlines_ran;
+  atomic_uint deadlines_missed;
+  atomic_uint deadlines_max_lateness;
+  /* Items posted to a serial or targeted queue and not finished yet. */
+  CUTILS_CACHE_ALIGNED atomic_uint pending;
+  /* Held by whoever runs an item of a serial queue, the worker or a dispatch_sync_f() caller. */
+  CUTILS_CACHE_ALIGNED mutex_t exec_mtx;
+  /* Set on destroy and checked by every post. */
+  atomic_bool destroying;
   signal_t signal;
+  /* Only looked at once the pool is exhausted. */
+  dispatch_overflow_policy_e overflow_policy;
+  uint32_t overflow_timeout_ms;
+  atomic_uint overflow_rejected;
+  atomic_uint overflow_blocked;
+  atomic_uint overflow_timed_out;
+  atomic_uint overflow_dropped;
+  atomic_uint overflow_ran_inline;
+  atomic_uint cancelled;
+  /* Written by the worker as it polls. */
+  _Atomic(cutils_ticks_t) poll_spent;
+  atomic_uint poll_hits;
+  atomic_uint poll_misses;
 } dispatch_queue_t;
 
 typedef struct _dispatch_queue_create_params_t {
@@ -45,34 +266,55 @@ typedef struct _dispatch_queue_create_params_t {
   task_create_params_t task_params;
   pool_create_params_t pool_params;
   ts_queue_create_params_t queue_params;
+  /* Most items run per batch, 0 for DISPATCH_QUEUE_BATCH_MAX. */
+  uint32_t batch_max;
+  /* Heap storage of an earliest deadline first queue, NULL for a FIFO queue. */
+  dispatch_queue_post_data_t **pp_deadline_heap;
+  uint32_t deadline_heap_size;
+  /* Initial poll budget, see dispatch_queue_set_poll(). */
+  cutils_ticks_t poll_budget;
 } dispatch_queue_create_params_t;
 
-/**
- * @brief Used internally to pass data asynchronously between the queue worker thread and the post
- * routines
- */
-typedef struct _dispatch_queue_post_data_t {
-  dispatch_function_t fn;
-  void *arg1;
-  void *arg2;
-} dispatch_queue_post_data_t;
-
 #define DISPATCH_QUEUE_STORE(name) _dispatch_queue_##name
 #define DISPATCH_QUEUE_STORE_T(name) dispatch_queue_store_##name##_t
 
 #define DISPATCH_QUEUE_STORE_DECL(name, queue_size, stack_size)                                    \
+  DISPATCH_QUEUE_STORE_DECL_INLINE(name, queue_size, stack_size, 0)
+
+/**
+ * @brief Same as DISPATCH_QUEUE_STORE_DECL() but every post record of the queue has room for
+ * `inline_size` bytes of context, see dispatch_async_copy_f().
+ */
+#define DISPATCH_QUEUE_STORE_DECL_INLINE(name, queue_size, stack_size, inline_size)                \
+  DISPATCH_QUEUE_STORE_DECL_RECORDS(name,                                                          \
+                                    queue_size,                                                    \
+                                    stack_size,                                                    \
+                                    DISPATCH_QUEUE_RECORD_SIZE(inline_size),                       \
+                                    DISPATCH_QUEUE_RECORD_ALIGN(inline_size))
+
+/** @brief Used internally to declare a serial queue's storage with records of any layout. */
+#define DISPATCH_QUEUE_STORE_DECL_RECORDS(name, queue_size, stack_size, record_size, record_align) \
   TASK_STATIC_STORE_DECL(dispatch_queue_##name, stack_size);                                       \
-  POOL_STORE_DECL(dispatch_queue_##name, queue_size, sizeof(dispatch_queue_post_data_t), 4);       \
+  POOL_STORE_DECL(dispatch_queue_##name, queue_size, record_size, record_align);                   \
   TS_QUEUE_STORE_DECL(dispatch_queue_##name, queue_size);                                          \
   typedef struct {                                                                                 \
     dispatch_queue_t queue;                                                                        \
   } DISPATCH_QUEUE_STORE_T(name)
 
-#define DISPATCH_QUEUE_STORE_DEF(name)                                                             \
+#define DISPATCH_QUEUE_STORE_DEF(name) DISPATCH_QUEUE_STORE_DEF_OWNED(name, MemReportDispatchQueue)
+
+#define DISPATCH_QUEUE_STORE_DEF_OWNED(name, owner)                                                \
   DISPATCH_QUEUE_STORE_T(name) DISPATCH_QUEUE_STORE(name);                                         \
-  TASK_STATIC_STORE_DEF(dispatch_queue_##name);                                                    \
-  POOL_STORE_DEF(dispatch_queue_##name);                                                           \
-  TS_QUEUE_STORE_DEF(dispatch_queue_##name)
+  TASK_STATIC_STORE_DEF_OWNED(dispatch_queue_##name, owner);                                       \
+  POOL_STORE_DEF_OWNED(dispatch_queue_##name, owner);                                              \
+  TS_QUEUE_STORE_DEF_OWNED(dispatch_queue_##name, owner);                                          \
+  MEM_REPORT_RECORD(dispatch_queue_##name,                                                         \
+                    MemReportDispatchQueue,                                                        \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(DISPATCH_QUEUE_STORE(name)),                                            \
+                    GetArraySize(POOL_STORE(dispatch_queue_##name).elements),                      \
+                    sizeof(POOL_STORE(dispatch_queue_##name).elements[0].data))
 
 #define DISPATCH_QUEUE_CREATE_PARAMS_INIT(params, name, task_name, pri)                            \
   memset(&(params), 0, sizeof(params));                                                            \
@@ -84,8 +326,302 @@ typedef struct _dispatch_queue_post_data_t {
 
 dispatch_queue_t *dispatch_queue_create(dispatch_queue_create_params_t *create_params);
 
+#define DISPATCH_EDF_HEAP_STORE(name) _dispatch_edf_heap_##name
+#define DISPATCH_EDF_HEAP_STORE_T(name) dispatch_edf_heap_store_##name##_t
+
+/**
+ * @brief Declares the storage for an earliest deadline first queue. It is a serial queue whose
+ * worker always runs the waiting item with the earliest deadline, see dispatch_async_deadline_f().
+ * On top of a serial queue's storage it holds a heap with room for every record, and its records
+ * carry a deadline.
+ */
+#define DISPATCH_EDF_QUEUE_STORE_DECL(name, queue_size, stack_size)                                \
+  DISPATCH_QUEUE_STORE_DECL_RECORDS(name,                                                          \
+                                    queue_size,                                                    \
+                                    stack_size,                                                    \
+                                    sizeof(dispatch_edf_post_data_t),                              \
+                                    alignof(dispatch_edf_post_data_t));                            \
+  typedef struct {                                                                                 \
+    dispatch_queue_post_data_t *p_items[(queue_size)];                                             \
+  } DISPATCH_EDF_HEAP_STORE_T(name)
+
+#define DISPATCH_EDF_QUEUE_STORE_DEF(name)                                                         \
+  DISPATCH_EDF_QUEUE_STORE_DEF_OWNED(name, MemReportDispatchQueue)
+
+#define DISPATCH_EDF_QUEUE_STORE_DEF_OWNED(name, owner)                                            \
+  DISPATCH_QUEUE_STORE_DEF_OWNED(name, owner);                                                     \
+  DISPATCH_EDF_HEAP_STORE_T(name) DISPATCH_EDF_HEAP_STORE(name);                                   \
+  MEM_REPORT_RECORD(dispatch_edf_heap_##name,                                                      \
+                    MemReportDispatchQueue,                                                        \
+                    owner,                                                                         \
+                    #name "_heap",                                                                 \
+                    sizeof(DISPATCH_EDF_HEAP_STORE(name)),                                         \
+                    GetArraySize(DISPATCH_EDF_HEAP_STORE(name).p_items),                           \
+                    sizeof(dispatch_queue_post_data_t *))
+
+/** @brief Initializes create params for dispatch_queue_create() from an EDF queue's storage. */
+#define DISPATCH_EDF_QUEUE_CREATE_PARAMS_INIT(params, name, task_name, pri)                        \
+  DISPATCH_QUEUE_CREATE_PARAMS_INIT(params, name, task_name, pri);                                 \
+  (params).pp_deadline_heap = DISPATCH_EDF_HEAP_STORE(name).p_items;                               \
+  (params).deadline_heap_size = GetArraySize(DISPATCH_EDF_HEAP_STORE(name).p_items)
+
+#define DISPATCH_CONCURRENT_QUEUE_STORE(name) _dispatch_concurrent_queue_##name
+#define DISPATCH_CONCURRENT_QUEUE_STORE_T(name) dispatch_concurrent_queue_store_##name##_t
+
+/**
+ * @brief Declares the storage for a concurrent dispatch queue run by `num_workers` tasks. Up to
+ * `queue_size` items can be pending across all workers, and `queue_size` must be a power of 2.
+ */
+#define DISPATCH_CONCURRENT_QUEUE_STORE_DECL(name, num_workers, queue_size, stack_size)            \
+  DISPATCH_CONCURRENT_QUEUE_STORE_DECL_INLINE(name, num_workers, queue_size, stack_size, 0)
+
+/** @brief Same as DISPATCH_CONCURRENT_QUEUE_STORE_DECL() with `inline_size` bytes per record. */
+#define DISPATCH_CONCURRENT_QUEUE_STORE_DECL_INLINE(                                               \
+    name, num_workers, queue_size, stack_size, inline_size)                                        \
+  TASK_STATIC_STORE_DECL(dispatch_cq_##name, stack_size);                                          \
+  POOL_STORE_DECL(dispatch_cq_##name,                                                              \
+                  queue_size,                                                                      \
+                  DISPATCH_QUEUE_RECORD_SIZE(inline_size),                                         \
+                  DISPATCH_QUEUE_RECORD_ALIGN(inline_size));                                       \
+  typedef struct {                                                                                 \
+    dispatch_queue_t queue;                                                                        \
+    dispatch_workers_t workers;                                                                    \
+    dispatch_worker_t worker[num_workers];                                                         \
+    dispatch_queue_post_data_t *deques[num_workers][queue_size];                                   \
+    dispatch_queue_post_data_t *held[queue_size];                                                  \
+    task_create_params_t task_params[num_workers];                                                 \
+    TASK_STATIC_STORE_T(dispatch_cq_##name) tasks[num_workers];                                    \
+  } DISPATCH_CONCURRENT_QUEUE_STORE_T(name)
+
+#define DISPATCH_CONCURRENT_QUEUE_STORE_DEF(name)                                                  \
+  DISPATCH_CONCURRENT_QUEUE_STORE_DEF_OWNED(name, MemReportDispatchQueue)
+
+#define DISPATCH_CONCURRENT_QUEUE_STORE_DEF_OWNED(name, owner)                                     \
+  DISPATCH_CONCURRENT_QUEUE_STORE_T(name) DISPATCH_CONCURRENT_QUEUE_STORE(name);                   \
+  POOL_STORE_DEF_OWNED(dispatch_cq_##name, owner);                                                 \
+  MEM_REPORT_RECORD(dispatch_cq_##name,                                                            \
+                    MemReportDispatchQueue,                                                        \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(DISPATCH_CONCURRENT_QUEUE_STORE(name)),                                 \
+                    GetArraySize(POOL_STORE(dispatch_cq_##name).elements),                         \
+                    sizeof(POOL_STORE(dispatch_cq_##name).elements[0].data))
+
+typedef struct _dispatch_concurrent_queue_create_params_t {
+  dispatch_queue_t *p_queue;
+  dispatch_workers_t *p_workers;
+  dispatch_worker_t *p_worker_array;
+  uint32_t num_workers;
+  /* num_workers consecutive deques of deque_size entries each. */
+  dispatch_queue_post_data_t **pp_deques;
+  uint32_t deque_size;
+  /* deque_size entries for items held back behind barriers. */
+  dispatch_queue_post_data_t **pp_held;
+  task_create_params_t *p_task_params;
+  pool_create_params_t pool_params;
+} dispatch_concurrent_queue_create_params_t;
+
+#define DISPATCH_CONCURRENT_QUEUE_CREATE_PARAMS_INIT(params, name, task_name, pri)                 \
+  memset(&(params), 0, sizeof(params));                                                            \
+  (params).p_queue = &DISPATCH_CONCURRENT_QUEUE_STORE(name).queue;                                 \
+  (params).p_workers = &DISPATCH_CONCURRENT_QUEUE_STORE(name).workers;                             \
+  (params).p_worker_array = DISPATCH_CONCURRENT_QUEUE_STORE(name).worker;                          \
+  (params).num_workers = GetArraySize(DISPATCH_CONCURRENT_QUEUE_STORE(name).worker);               \
+  (params).pp_deques = &DISPATCH_CONCURRENT_QUEUE_STORE(name).deques[0][0];                        \
+  (params).deque_size = GetArraySize(DISPATCH_CONCURRENT_QUEUE_STORE(name).deques[0]);             \
+  (params).pp_held = DISPATCH_CONCURRENT_QUEUE_STORE(name).held;                                   \
+  (params).p_task_params = DISPATCH_CONCURRENT_QUEUE_STORE(name).task_params;                      \
+  for (uint32_t _i = 0; _i < (params).num_workers; _i++) {                                         \
+    TASK_INIT_CREATE_PARAMS_FROM_STORE((params).p_task_params[_i],                                 \
+                                       &DISPATCH_CONCURRENT_QUEUE_STORE(name).tasks[_i],           \
+                                       task_name,                                                  \
+                                       pri,                                                        \
+                                       NULL,                                                       \
+                                       NULL);                                                      \
+  }                                                                                                \
+  POOL_CREATE_INIT((params).pool_params, dispatch_cq_##name)
+
+/**
+ * @brief Creates a concurrent dispatch queue. Items posted to it with dispatch_async_f() run in
+ * parallel on the queue's workers, in no particular order relative to each other. Posts are
+ * spread round robin over the workers' deques and a worker that runs out of work steals from the
+ * others before it parks.
+ * @return - the queue, usable with the same API as a serial queue
+ */
+dispatch_queue_t *
+dispatch_concurrent_queue_create(dispatch_concurrent_queue_create_params_t *create_params);
+
+#define DISPATCH_TARGETED_QUEUE_STORE(name) _dispatch_targeted_queue_##name
+#define DISPATCH_TARGETED_QUEUE_STORE_T(name) dispatch_targeted_queue_store_##name##_t
+
+/**
+ * @brief Declares the storage for a targeted serial queue holding up to `queue_size` items. There
+ * is no task or stack: the queue borrows a worker of its target queue while it has items.
+ */
+#define DISPATCH_TARGETED_QUEUE_STORE_DECL(name, queue_size)                                       \
+  DISPATCH_TARGETED_QUEUE_STORE_DECL_INLINE(name, queue_size, 0)
+
+/** @brief Same as DISPATCH_TARGETED_QUEUE_STORE_DECL() with `inline_size` bytes per record. */
+#define DISPATCH_TARGETED_QUEUE_STORE_DECL_INLINE(name, queue_size, inline_size)                   \
+  POOL_STORE_DECL(dispatch_tq_##name,                                                              \
+                  queue_size,                                                                      \
+                  DISPATCH_QUEUE_RECORD_SIZE(inline_size),                                         \
+                  DISPATCH_QUEUE_RECORD_ALIGN(inline_size));                                       \
+  TS_QUEUE_STORE_DECL(dispatch_tq_##name, queue_size);                                             \
+  typedef struct {                                                                                 \
+    dispatch_queue_t queue;                                                                        \
+  } DISPATCH_TARGETED_QUEUE_STORE_T(name)
+
+#define DISPATCH_TARGETED_QUEUE_STORE_DEF(name)                                                    \
+  DISPATCH_TARGETED_QUEUE_STORE_DEF_OWNED(name, MemReportDispatchQueue)
+
+#define DISPATCH_TARGETED_QUEUE_STORE_DEF_OWNED(name, owner)                                       \
+  DISPATCH_TARGETED_QUEUE_STORE_T(name) DISPATCH_TARGETED_QUEUE_STORE(name);                       \
+  POOL_STORE_DEF_OWNED(dispatch_tq_##name, owner);                                                 \
+  TS_QUEUE_STORE_DEF_OWNED(dispatch_tq_##name, owner);                                             \
+  MEM_REPORT_RECORD(dispatch_tq_##name,                                                            \
+                    MemReportDispatchQueue,                                                        \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(DISPATCH_TARGETED_QUEUE_STORE(name)),                                   \
+                    GetArraySize(POOL_STORE(dispatch_tq_##name).elements),                         \
+                    sizeof(POOL_STORE(dispatch_tq_##name).elements[0].data))
+
+typedef struct _dispatch_targeted_queue_create_params_t {
+  dispatch_queue_t *p_queue;
+  dispatch_queue_t *p_target;
+  char *label;
+  pool_create_params_t pool_params;
+  ts_queue_create_params_t queue_params;
+  /* Most items run per turn on the target, 0 for DISPATCH_QUEUE_BATCH_MAX. */
+  uint32_t batch_max;
+} dispatch_targeted_queue_create_params_t;
+
+#define DISPATCH_TARGETED_QUEUE_CREATE_PARAMS_INIT(params, name, queue_label, target)              \
+  memset(&(params), 0, sizeof(params));                                                            \
+  (params).p_queue = &DISPATCH_TARGETED_QUEUE_STORE(name).queue;                                   \
+  (params).p_target = (target);                                                                    \
+  (params).label = (queue_label);                                                                  \
+  POOL_CREATE_INIT((params).pool_params, dispatch_tq_##name);                                      \
+  TS_QUEUE_STORE_CREATE_PARAMS_INIT((params).queue_params, dispatch_tq_##name)
+
+/**
+ * @brief Creates a serial queue without a task of its own. Its items run one at a time, in post
+ * order, but on the target queue, which is usually a concurrent queue shared by many such queues.
+ * While the queue has items, exactly one drain item of it is posted on the target. The drain runs
+ * up to `batch_max` items and then posts itself again behind whatever else the target has queued.
+ * So the number of threads tracks the target's workers, not the number of serial queues.
+ *
+ * The queue reserves one record of the target's pool for its drain while it lives, so reposting
+ * the drain is never refused. Destroy targeted queues before their target.
+ * @return - the queue, usable with the same API as a serial queue. NULL if the target has no
+ * record to spare
+ */
+dispatch_queue_t *
+dispatch_targeted_queue_create(dispatch_targeted_queue_create_params_t *create_params);
+
+/**
+ * @brief Destroys a serial, concurrent or targeted queue. Items already posted run before it
+ * returns.
+ */
 void dispatch_queue_destroy(dispatch_queue_t *p_queue);
 
+/** @brief Internal. Hands a post record to one of the workers of a concurrent queue. */
+bool dispatch_workers_post(dispatch_queue_t *p_queue, dispatch_queue_post_data_t *p_data);
+
+/** @brief Internal. Queues a post record on a targeted queue, scheduling a drain if it was idle. */
+void dispatch_targeted_post(dispatch_queue_t *p_queue, dispatch_queue_post_data_t *p_data);
+
+/**
+ * @brief Internal. Puts `fn` on the local run list when called from the queue's own worker and
+ * nothing is waiting in the shared queue.
+ * @return false if the item has to take the shared queue
+ */
+bool dispatch_queue_post_local(dispatch_queue_t *p_queue,
+                               dispatch_function_t fn,
+                               void *arg1,
+                               void *arg2);
+
+/** @brief Internal. Hands a filled in post record to the queue. */
+static inline void dispatch_queue_post_submit(dispatch_queue_t *p_queue,
+                                              dispatch_queue_post_data_t *p_data) {
+  p_data->posted_at =
+      atomic_load_explicit(&p_queue->p_profile, memory_order_relaxed) ? task_get_ticks() : 0;
+  if (p_queue->p_workers) {
+    CUTILS_ASSERT(dispatch_workers_post(p_queue, p_data));
+  } else if (p_queue->p_target) {
+    dispatch_targeted_post(p_queue, p_data);
+  } else {
+    atomic_fetch_add_explicit(&p_queue->pending, 1, memory_order_relaxed);
+    CUTILS_ASSERT(ts_queue_enqueue(p_queue->queue, p_data, NO_SLEEP));
+  }
+}
+
+/**
+ * @brief Internal. Takes a post record of `p_queue` ahead of time, for an item that has to be
+ * posted later without any chance of being refused. The record is filled in with `fn`, `arg1` and
+ * `arg2` now and is never dropped. It must be posted with dispatch_queue_post_reserved() or given
+ * back with dispatch_queue_unreserve() before the queue is destroyed. Never blocks and ignores the
+ * overflow policy.
+ * @return - the record, NULL if the queue is being destroyed or has no free record
+ */
+dispatch_queue_post_data_t *dispatch_queue_reserve_post(dispatch_queue_t *p_queue,
+                                                        dispatch_function_t fn,
+                                                        void *arg1,
+                                                        void *arg2);
+
+/**
+ * @brief Internal. Posts a record taken with dispatch_queue_reserve_post(). The reservation is used
+ * up either way.
+ * @return - true, unless the queue is being destroyed, in which case the record is given back
+ */
+bool dispatch_queue_post_reserved(dispatch_queue_t *p_queue, dispatch_queue_post_data_t *p_data);
+
+/** @brief Internal. Gives back a record taken with dispatch_queue_reserve_post() unposted. */
+void dispatch_queue_unreserve(dispatch_queue_t *p_queue, dispatch_queue_post_data_t *p_data);
+
+/**
+ * @brief Internal. Posts with an explicit overflow policy. dispatch_queue_post() only calls this
+ * once the pool is exhausted.
+ */
+bool dispatch_queue_post_ex(dispatch_queue_t *p_queue,
+                            dispatch_function_t fn,
+                            void *arg1,
+                            void *arg2,
+                            uint32_t flags,
+                            struct _dispatch_group_t *p_group,
+                            dispatch_overflow_policy_e policy,
+                            uint32_t timeout_ms);
+
+/** @brief Internal. Fills in a post record and hands it to the queue. */
+static inline bool dispatch_queue_post(dispatch_queue_t *p_queue,
+                                       dispatch_function_t fn,
+                                       void *arg1,
+                                       void *arg2,
+                                       uint32_t flags,
+                                       struct _dispatch_group_t *p_group) {
+  bool retval = false;
+  if (p_queue && !atomic_load(&p_queue->destroying)) {
+    dispatch_queue_post_data_t *p_data = NULL;
+    if (!flags && !p_group && atomic_load_explicit(&p_queue->p_local, memory_order_relaxed) &&
+        dispatch_queue_post_local(p_queue, fn, arg1, arg2)) {
+      retval = true;
+    } else if ((p_data = pool_alloc(p_queue->p_pool))) {
+      p_data->fn = fn;
+      p_data->arg1 = arg1;
+      p_data->arg2 = arg2;
+      p_data->flags = flags;
+      p_data->p_group = p_group;
+      dispatch_queue_post_submit(p_queue, p_data);
+      retval = true;
+    } else {
+      retval = dispatch_queue_post_ex(
+          p_queue, fn, arg1, arg2, flags, p_group, DISPATCH_OVERFLOW_DEFAULT, 0);
+    }
+  }
+  return retval;
+}
+
 /**
  * @brief The function will post the dispatch_function_f callback onto the dispatch queue. The
  * client can supply up to two arguments. The client is responsible for object life time maintenance
@@ -94,26 +630,351 @@ void dispatch_queue_destroy(dispatch_queue_t *p_queue);
  * @param fn - callback to be executed asynchronously
  * @param arg1 - client argument 1. Client maintains object lifecycle
  * @param arg2 - client argument 2. Client maintains object lifecycle
+ *
+ * Posting from the worker of a serial queue to its own queue skips the shared queue and its post
+ * records: the item goes on the worker's local run list, which runs once the current batch is done.
+ * Items still run in posting order.
  * @return true if the action is posted on the queue. False otherwise. Indicates queue is destroyed.
  */
 static inline bool
 dispatch_async_f(dispatch_queue_t *p_queue, dispatch_function_t fn, void *arg1, void *arg2) {
+  return dispatch_queue_post(p_queue, fn, arg1, arg2, 0, NULL);
+}
+
+/**
+ * @brief Posts `fn` to a serial queue in the service class `qos`. The queue still runs one item at
+ * a time, but it picks the next item from the highest class that has one waiting. Items of the
+ * same class run in the order they were posted. A class that has been passed over
+ * DISPATCH_QOS_STARVATION_LIMIT times in a row gets the next turn, so background work keeps
+ * moving under a steady stream of high priority items. Concurrent and targeted queues accept the
+ * class but run the item in their usual order.
+ * @return true if the action was posted, false otherwise.
+ */
+static inline bool dispatch_async_qos_f(
+    dispatch_queue_t *p_queue, dispatch_qos_e qos, dispatch_function_t fn, void *arg1, void *arg2) {
+  CUTILS_ASSERT(qos < DISPATCH_QOS_COUNT);
+  if (p_queue && qos != DISPATCH_QOS_DEFAULT &&
+      !atomic_load_explicit(&p_queue->uses_qos, memory_order_relaxed)) {
+    atomic_store_explicit(&p_queue->uses_qos, true, memory_order_relaxed);
+  }
+  return dispatch_queue_post(p_queue, fn, arg1, arg2, DISPATCH_POST_FLAG_QOS(qos), NULL);
+}
+
+/**
+ * @brief Posts `fn` like dispatch_async_f(), but applies `policy` instead of the queue's policy if
+ * the queue is full. `timeout_ms` is only used by DISPATCH_OVERFLOW_BLOCK.
+ *
+ * DISPATCH_OVERFLOW_DROP_OLDEST only discards items that nobody waits on. A serial queue only
+ * discards the item at its head, so its order never changes. It is not supported on targeted
+ * queues, whose drains own their FIFO, nor on EDF queues and serial queues that have been posted a
+ * QoS class, whose worker takes items ahead of running them. A post that finds nothing to drop
+ * counts as rejected and leaves the queue untouched. A discarded item still leaves its group.
+ * DISPATCH_OVERFLOW_RUN_INLINE takes the execution lock of a serial or targeted queue, so the item
+ * still runs alone. An item of that queue already holds the lock, and what it posts to its own
+ * queue runs right away, nested in it. On a concurrent queue the item runs unless a barrier is
+ * pending. DISPATCH_OVERFLOW_BLOCK must not be used from an item running on the same serial queue.
+ * @return true if the action was posted or run, false if it was refused or the queue is destroyed.
+ */
+bool dispatch_async_ex(dispatch_queue_t *p_queue,
+                       dispatch_function_t fn,
+                       void *arg1,
+                       void *arg2,
+                       dispatch_overflow_policy_e policy,
+                       uint32_t timeout_ms);
+
+/**
+ * @brief Posts `fn` to an earliest deadline first queue, to finish by `deadline_ms`, an absolute
+ * task_get_ms() time. The worker runs the waiting item with the earliest deadline first, and items
+ * with equal deadlines in the order it took them. Items posted any other way, such as
+ * dispatch_sync_f(), count as due when the worker takes them. An item that is running is never
+ * interrupted. Deadlines must lie within 2^31 ms of each other. Other queues ignore the deadline.
+ * @return true if the action was posted or run, false if it was refused or the queue is destroyed.
+ */
+bool dispatch_async_deadline_f(dispatch_queue_t *p_queue,
+                               uint32_t deadline_ms,
+                               dispatch_function_t fn,
+                               void *arg1,
+                               void *arg2);
+
+/** @brief Reads the deadline counters of an earliest deadline first queue. */
+void dispatch_queue_get_deadlines(dispatch_queue_t *p_queue, dispatch_deadline_stats_t *p_stats);
+
+/** @brief Identifies an item posted with dispatch_async_cancellable_f(). */
+typedef struct _dispatch_work_token_t {
+  dispatch_queue_post_data_t *p_item;
+  unsigned int seq;
+} dispatch_work_token_t;
+
+#define DISPATCH_WORK_TOKEN_INVALID ((dispatch_work_token_t){.p_item = NULL, .seq = 0})
+
+/**
+ * @brief Posts `fn` like dispatch_async_f(), and fills `*p_token` so dispatch_cancel() can revoke
+ * it while it is still queued. If the queue is full and its policy runs the item on the caller,
+ * the token is DISPATCH_WORK_TOKEN_INVALID. The token refers to the queue's storage, so it must
+ * not be used once the queue has been destroyed.
+ * @return true if the action was posted or run, false if it was refused or the queue is destroyed.
+ */
+bool dispatch_async_cancellable_f(dispatch_queue_t *p_queue,
+                                  dispatch_function_t fn,
+                                  void *arg1,
+                                  void *arg2,
+                                  dispatch_work_token_t *p_token);
+
+/**
+ * @brief Revokes an item posted with dispatch_async_cancellable_f(). O(1) and lock free: it only
+ * marks the item, and the queue skips it when it reaches it. The record is freed then and a
+ * dispatch group it belongs to is still left. A token whose item has started, finished or been
+ * cancelled already is stale, however its record has been reused since.
+ * @return true if the item will not run, false if it has run, is running or was already cancelled
+ */
+static inline bool dispatch_cancel(dispatch_work_token_t token) {
   bool retval = false;
-  if (p_queue && !atomic_load(&p_queue->destroying)) {
-    dispatch_queue_post_data_t *p_data = pool_alloc(p_queue->p_pool);
-    CUTILS_ASSERT(p_data);
-    p_data->fn = fn;
-    p_data->arg1 = arg1;
-    p_data->arg2 = arg2;
-    CUTILS_ASSERT(ts_queue_enqueue(p_queue->queue, p_data, NO_SLEEP));
-    retval = true;
+  if (token.p_item) {
+    unsigned int expected = token.seq;
+    retval = atomic_compare_exchange_strong(&token.p_item->seq, &expected, token.seq + 1);
   }
   return retval;
 }
 
+/**
+ * @brief Makes the worker of a serial queue poll for new items for up to `budget` ticks before it
+ * blocks, so a post made meanwhile needs no wakeup. DISPATCH_POLL_FOREVER never blocks, which
+ * suits a worker that has a core to itself. The worker yields every DISPATCH_POLL_YIELD_SPINS
+ * checks, so anything sharing the core still runs. 0, the default, blocks right away. A worker
+ * that is polling picks up the new budget right away.
+ */
+void dispatch_queue_set_poll(dispatch_queue_t *p_queue, cutils_ticks_t budget);
+
+/** @brief Reads how much polling has cost the queue's worker, see dispatch_queue_set_poll(). */
+void dispatch_queue_get_poll(dispatch_queue_t *p_queue, dispatch_poll_stats_t *p_stats);
+
+/**
+ * @brief Sets the policy that dispatch_async_f() and every other post to the queue applies when the
+ * queue is full, including posts made on the caller's behalf by timers and group notifications.
+ * Call it before the queue is shared.
+ */
+void dispatch_queue_set_overflow(dispatch_queue_t *p_queue,
+                                 dispatch_overflow_policy_e policy,
+                                 uint32_t timeout_ms);
+
+/** @brief Reads the queue's overflow counters. */
+void dispatch_queue_get_overflow(dispatch_queue_t *p_queue,
+                                 dispatch_queue_overflow_stats_t *p_stats);
+
+/**
+ * @brief Number of distinct functions a dispatch_profile_t keeps apart. Calls of functions beyond
+ * that are only counted in `untracked`.
+ */
+#ifndef DISPATCH_PROFILE_MAX_FUNCTIONS
+#define DISPATCH_PROFILE_MAX_FUNCTIONS (32)
+#endif
+
+/**
+ * @brief What a profile has seen of one posted function. Times are in cutils_ticks_t, nanoseconds
+ * on the host ports and RTOS ticks on FreeRTOS.
+ */
+typedef struct _dispatch_profile_entry_t {
+  dispatch_function_t fn;
+  uint32_t calls;
+  cutils_ticks_t total_run;
+  cutils_ticks_t max_run;
+  cutils_ticks_t total_delay; /**< Time from post to start, summed over the calls. */
+  cutils_ticks_t max_delay;
+} dispatch_profile_entry_t;
+
+/**
+ * @brief Per-function execution times of the queues it is attached to, see
+ * dispatch_queue_set_profile(). Entries are hashed by function pointer into a fixed table.
+ */
+typedef struct _dispatch_profile_t {
+  mutex_t mtx;
+  dispatch_profile_entry_t entries[DISPATCH_PROFILE_MAX_FUNCTIONS];
+  uint32_t num_entries;
+  uint32_t untracked; /**< Calls of functions that found the table full. */
+} dispatch_profile_t;
+
+/** @brief Initializes an empty profile. */
+bool dispatch_profile_new(dispatch_profile_t *p_profile);
+
+/** @brief Releases a profile. Detach it from every queue first. */
+void dispatch_profile_free(dispatch_profile_t *p_profile);
+
+/** @brief Forgets everything the profile has recorded. */
+void dispatch_profile_reset(dispatch_profile_t *p_profile);
+
+/**
+ * @brief Starts recording every item the queue's workers run into `p_profile`, or stops if it is
+ * NULL. Several queues can share a profile. Items that run inline on a dispatch_sync_f() caller
+ * are not recorded. Queueing delay is only known for items posted while the profile was attached.
+ */
+void dispatch_queue_set_profile(dispatch_queue_t *p_queue, dispatch_profile_t *p_profile);
+
+/**
+ * @brief Copies up to `max` entries into `p_entries`, most total run time first.
+ * @return number of entries copied.
+ */
+size_t dispatch_profile_sorted(dispatch_profile_t *p_profile,
+                               dispatch_profile_entry_t *p_entries,
+                               size_t max);
+
+/**
+ * @brief Logs the profile, most total run time first. Functions are named when the platform can
+ * look the symbol up, and printed as addresses otherwise.
+ */
+void dispatch_profile_log(dispatch_profile_t *p_profile);
+
+/**
+ * @brief Bytes of context dispatch_async_copy_f() can carry on `p_queue`, 0 unless the queue was
+ * declared with an inline size. An EDF queue keeps its deadlines there, so it has none.
+ */
+static inline size_t dispatch_queue_inline_size(dispatch_queue_t *p_queue) {
+  size_t element_size = p_queue->p_pool->element_size;
+  return !p_queue->pp_deadline_heap && element_size > DISPATCH_QUEUE_INLINE_OFFSET
+             ? element_size - DISPATCH_QUEUE_INLINE_OFFSET
+             : 0;
+}
+
+/**
+ * @brief Posts `fn` with a private copy of `len` bytes of `ctx`. The copy lives inside the post
+ * record, so no second allocation is needed to carry context the caller cannot keep alive. `fn`
+ * gets a pointer to the copy as arg1, aligned for any type, and NULL as arg2. The copy is only
+ * valid until `fn` returns. Only queues declared with an inline size have room for a copy.
+ * @return true if the action is posted on the queue. False if the queue is destroyed or `len` is
+ * larger than dispatch_queue_inline_size().
+ */
+bool dispatch_async_copy_f(dispatch_queue_t *p_queue,
+                           dispatch_function_t fn,
+                           const void *ctx,
+                           size_t len);
+
+/**
+ * @brief Runs `fn` on the queue and returns once it has completed. Items posted before the call
+ * run first. When the queue has nothing pending (or for a concurrent queue, no barrier pending)
+ * `fn` runs inline on the calling thread while holding the queue, so there is no allocation and
+ * no context switch. Otherwise `fn` is posted and the caller blocks on a completion signal that
+ * lives on its stack.
+ *
+ * Calling this from an item running on the same serial queue deadlocks.
+ * @return true if `fn` ran, false if the queue is being destroyed.
+ */
+bool dispatch_sync_f(dispatch_queue_t *p_queue, dispatch_function_t fn, void *arg1, void *arg2);
+
+/**
+ * @brief Posts `fn` as a barrier. On a concurrent queue, the barrier waits for every item posted
+ * before it to finish, runs on its own, and only then lets items posted after it start. On a serial
+ * queue every item already runs alone, so this is the same as dispatch_async_f().
+ * @return true if the action is posted on the queue. False otherwise. Indicates queue is destroyed.
+ */
+bool dispatch_barrier_async_f(
+    dispatch_queue_t *p_queue, dispatch_function_t fn, void *arg1, void *arg2);
+
+#ifndef DISPATCH_GROUP_MAX_NOTIFY
+#define DISPATCH_GROUP_MAX_NOTIFY (4)
+#endif
+
+typedef struct _dispatch_group_notify_t {
+  dispatch_queue_t *p_queue;
+  dispatch_function_t fn;
+  void *arg1;
+  void *arg2;
+} dispatch_group_notify_t;
+
+/**
+ * @brief Tracks a set of items, possibly spread over several queues, so that a caller can wait for
+ * all of them or have an action posted once they are done. A group is reusable: once it drains,
+ * new items can be added and waited on again.
+ */
+typedef struct _dispatch_group_t {
+  /* Items entered and not left yet, touched by every post and every completion. */
+  CUTILS_CACHE_ALIGNED atomic_uint count;
+  /* Serializes the empty/non-empty transitions and the notify list. */
+  mutex_t mtx;
+  event_flag_t flags;
+  dispatch_group_notify_t notify[DISPATCH_GROUP_MAX_NOTIFY];
+  uint32_t num_notify;
+} dispatch_group_t;
+
+/** @brief Initializes an empty group. */
+bool dispatch_group_new(dispatch_group_t *p_group);
+
+/** @brief Releases the group's resources. The group must be empty. */
+void dispatch_group_free(dispatch_group_t *p_group);
+
+/**
+ * @brief Adds an outstanding unit of work to the group, for work that is not posted with
+ * dispatch_group_async_f(). Each call must be balanced by dispatch_group_leave().
+ */
+void dispatch_group_enter(dispatch_group_t *p_group);
+
+/** @brief Marks a unit of work added with dispatch_group_enter() as done. */
+void dispatch_group_leave(dispatch_group_t *p_group);
+
+/**
+ * @brief Posts `fn` on the queue as part of the group. The group stays non-empty until `fn` has
+ * run. The group is carried in the post record, so this costs nothing over dispatch_async_f().
+ * @return true if the action is posted on the queue. False otherwise. Indicates queue is destroyed.
+ */
+bool dispatch_group_async_f(dispatch_group_t *p_group,
+                            dispatch_queue_t *p_queue,
+                            dispatch_function_t fn,
+                            void *arg1,
+                            void *arg2);
+
+/**
+ * @brief Waits until every item in the group has finished.
+ * @return true if the group is empty, false if `timeout_ms` elapsed first.
+ */
+bool dispatch_group_wait(dispatch_group_t *p_group, uint32_t timeout_ms);
+
+/**
+ * @brief Posts `fn` on `p_queue` once every item currently in the group has finished, or right
+ * away if the group is already empty. Up to DISPATCH_GROUP_MAX_NOTIFY actions can be pending at
+ * once.
+ * @return true if the action was posted or registered, false if the notify list is full or the
+ * queue is destroyed.
+ */
+bool dispatch_group_notify_f(dispatch_group_t *p_group,
+                             dispatch_queue_t *p_queue,
+                             dispatch_function_t fn,
+                             void *arg1,
+                             void *arg2);
+
+/** @brief Body of a dispatch_apply_f() loop, called once per index. */
+typedef void (*dispatch_apply_function_t)(void *ctx, size_t index);
+
+/**
+ * @brief Calls `fn(ctx, index)` for every index in [0, iterations) and returns once all of them
+ * have completed.
+ *
+ * On a concurrent queue the range is split between the caller and one helper per worker. Each
+ * participant repeatedly claims a chunk of the remaining range, sized so that about two chunks are
+ * left per participant. The chunks start large and shrink towards the end, so the work balances
+ * without a claim per index. On a serial queue the loop runs on the queue, as with
+ * dispatch_sync_f(). With a NULL queue it runs on the calling thread.
+ *
+ * The caller waits for every helper it posted. Do not call it from an item of the same queue
+ * unless other workers are free to run the helpers.
+ */
+void dispatch_apply_f(size_t iterations,
+                      dispatch_queue_t *p_queue,
+                      void *ctx,
+                      dispatch_apply_function_t fn);
+
+/**
+ * @brief Posts `fn` onto the dispatch queue once `delay_ms` has elapsed. Timers are kept on the
+ * system timer wheel (see timer_wheel.h), so this neither blocks nor uses a task per timer.
+ * @return true if the action was posted or armed, false if the system wheel has no free timers.
+ */
 bool dispatch_after_f(
     dispatch_queue_t *p_queue, uint32_t delay_ms, dispatch_function_t fn, void *arg1, void *arg2);
 
+/**
+ * @brief Posts `fn` onto the dispatch queue after `initial_ms` and every `reload_ms` after that.
+ * An `initial_ms` of 0 posts the first action immediately. Periods missed because the system is
+ * overloaded are skipped rather than posted back to back.
+ * @return a handle for dispatch_stop_repeated_f(), 0 if the timer could not be armed. Stop the
+ * action before destroying the queue it posts to.
+ */
 dispatch_queue_timed_action_h dispatch_start_repeated_f(dispatch_queue_t *p_queue,
                                                         uint32_t initial_ms,
                                                         uint32_t reload_ms,
@@ -121,4 +982,8 @@ dispatch_queue_timed_action_h dispatch_start_repeated_f(dispatch_queue_t *p_queu
                                                         void *arg1,
                                                         void *arg2);
 
+/**
+ * @brief Stops a repeated action. Nothing new is posted once this returns, but an action posted
+ * just before may still be pending on the queue. Stopping an action twice is harmless.
+ */
 void dispatch_stop_repeated_f(dispatch_queue_timed_action_h h_action);
@@ -0,0 +1,147 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2020> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cutils/dispatch_queue.h>
+#include <cutils/handle_table.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Data sources coalesce events raised by producers into one handler run on a dispatch
+ * queue. They are available on every port.
+ */
+
+/** @brief How a data source combines merged values. */
+typedef enum {
+  DISPATCH_SOURCE_DATA_ADD, /**< The handler gets the sum of the values merged since its last run. */
+  DISPATCH_SOURCE_DATA_OR,  /**< The handler gets their bitwise OR. */
+} dispatch_source_data_op_e;
+
+/** @brief Called on the source's queue with the accumulated value, which is never 0. */
+typedef void (*dispatch_source_data_handler_t)(void *ctx, uintptr_t data);
+
+typedef struct _dispatch_data_source_t {
+  dispatch_queue_t *p_queue;
+  dispatch_source_data_handler_t fn;
+  void *ctx;
+  dispatch_source_data_op_e op;
+  /* Reserved for the action of dispatch_data_source_cancel(). */
+  dispatch_queue_post_data_t *p_cancelled;
+  /* Written by every producer, kept off the line the configuration lives on. */
+  CUTILS_CACHE_ALIGNED atomic_uintptr_t data;
+  atomic_uint state;
+} dispatch_data_source_t;
+
+/**
+ * @brief Binds a data source to `p_queue`. The caller owns the storage, which must stay valid
+ * until the source has been cancelled.
+ */
+void dispatch_data_source_init(dispatch_data_source_t *p_source,
+                               dispatch_source_data_op_e op,
+                               dispatch_queue_t *p_queue,
+                               dispatch_source_data_handler_t fn,
+                               void *ctx);
+
+/**
+ * @brief Merges `value` into the source. Lock free. The first merge after the handler has started
+ * posts it again, and later merges only update the accumulated value, so any number of merges
+ * costs one post record. Merging 0 does nothing.
+ */
+void dispatch_source_merge_data(dispatch_data_source_t *p_source, uintptr_t value);
+
+/**
+ * @brief Stops the source. Later merges are ignored, and a handler that is already pending is
+ * skipped. Once no handler is running or can run any more, `on_cancelled(arg1, arg2)` is posted to
+ * the source's queue, if given. So even on a concurrent queue it never overlaps a handler. After
+ * that the storage can be reused, provided the producers have stopped.
+ * A post record for `on_cancelled` is reserved before anything else, so its post is never refused.
+ * @return - false if the queue had no record to spare for `on_cancelled`, in which case the source
+ * is left running
+ */
+bool dispatch_data_source_cancel(dispatch_data_source_t *p_source,
+                                 dispatch_function_t on_cancelled,
+                                 void *arg1,
+                                 void *arg2);
+
+#ifdef CUTILS_HAVE_EPOLL
+
+/**
+ * @brief File descriptor sources turn readiness into items on a dispatch queue. Every source is
+ * watched by one shared monitor task blocked in epoll_wait(), so any number of descriptors cost a
+ * single thread. The monitor is created on first use, with room for CUTILS_SYSTEM_SOURCES sources.
+ * Only available on Linux.
+ *
+ * Descriptors are registered one-shot. When one becomes ready, the monitor posts the handler and
+ * stops watching it until the handler has returned. A source therefore never has more than one
+ * handler pending, however often its descriptor becomes ready in the meantime. If the descriptor
+ * is still ready once the handler returns, the handler is posted again.
+ */
+
+/** @brief Readable, for the mask and for the events passed to the handler. */
+#define DISPATCH_SOURCE_READ (1u << 0)
+/** @brief Writable, for the mask and for the events passed to the handler. */
+#define DISPATCH_SOURCE_WRITE (1u << 1)
+/** @brief Only passed to the handler: the descriptor hung up or has an error pending. */
+#define DISPATCH_SOURCE_ERROR (1u << 2)
+
+/** @brief Handle of a dispatch source. Stale handles are rejected rather than reused. */
+typedef handle_t dispatch_source_h;
+
+#define DISPATCH_SOURCE_INVALID HANDLE_INVALID
+
+/** @brief Called on the source's queue with the DISPATCH_SOURCE_* events that were seen. */
+typedef void (*dispatch_source_handler_t)(void *ctx, uint32_t events);
+
+/**
+ * @brief Starts watching `fd` for the events in `mask`, posting `fn(ctx, events)` to `p_queue`
+ * whenever it is ready.
+ * @return - a handle for dispatch_source_cancel(), DISPATCH_SOURCE_INVALID if every source is in
+ * use or the descriptor cannot be watched
+ */
+dispatch_source_h dispatch_source_create(
+    int fd, uint32_t mask, dispatch_queue_t *p_queue, dispatch_source_handler_t fn, void *ctx);
+
+/**
+ * @brief Stops watching the source's descriptor. A handler that is already pending or running
+ * still completes. Once it has, `on_cancelled(arg1, arg2)` is posted to the source's queue, if
+ * given. The handler never runs after that, so `on_cancelled` is the place to close the
+ * descriptor. Safe to call from the source's own handler. A post record for `on_cancelled` is
+ * reserved on the queue before the source is cancelled, so its post is never refused.
+ * @return - true if the source was live and is now cancelled. False if it was not live, or if the
+ * queue had no record to spare for `on_cancelled`, in which case the source stays live
+ */
+bool dispatch_source_cancel(dispatch_source_h h_source,
+                            dispatch_function_t on_cancelled,
+                            void *arg1,
+                            void *arg2);
+
+#endif // CUTILS_HAVE_EPOLL
+
+#ifdef __cplusplus
+}
+#endif
@@ -26,6 +26,7 @@
 #define CUTILS_FREE_LIST_H
 
 #include <cutils/klist.h>
+#include <cutils/mem_report.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,6 +38,8 @@ typedef struct {
   size_t item_size;
   size_t item_count;
   size_t current_available;
+  /* Items at or past this index have never been handed out and are not on the list yet. */
+  size_t next_fresh;
 } free_list_t;
 
 #define FREE_LIST_STORE(name) _free_list_store_##name
@@ -47,7 +50,38 @@ typedef struct {
     free_list_t list;                                                                              \
   } FREE_LIST_STORE_T(name)
 
-#define FREE_LIST_STORE_DEF(name) FREE_LIST_STORE_T(name) FREE_LIST_STORE(name)
+#define FREE_LIST_STORE_DEF(name)                                                                  \
+  FREE_LIST_STORE_T(name) FREE_LIST_STORE(name);                                                   \
+  MEM_REPORT_RECORD(free_list_##name,                                                              \
+                    MemReportFreeList,                                                             \
+                    MemReportFreeList,                                                             \
+                    #name,                                                                         \
+                    sizeof(FREE_LIST_STORE(name)),                                                 \
+                    GetArraySize(FREE_LIST_STORE(name).store),                                     \
+                    sizeof(FREE_LIST_STORE(name).store[0]))
+
+/**
+ * @brief Defines the store with the list already usable through FREE_LIST_STATIC(name), with no
+ * call to free_list_init(). Items are handed out from the store in order on first use, and only
+ * items that have been put back are linked into the list.
+ */
+#define FREE_LIST_STORE_DEF_STATIC(name)                                                           \
+  FREE_LIST_STORE_T(name) FREE_LIST_STORE(name) = {                                                \
+      .list = {.data_store = FREE_LIST_STORE(name).store,                                          \
+               .item_size = sizeof(FREE_LIST_STORE(name).store[0]),                                \
+               .item_count = GetArraySize(FREE_LIST_STORE(name).store),                            \
+               .current_available = GetArraySize(FREE_LIST_STORE(name).store),                     \
+               .next_fresh = 0}};                                                                  \
+  MEM_REPORT_RECORD(free_list_##name,                                                              \
+                    MemReportFreeList,                                                             \
+                    MemReportFreeList,                                                             \
+                    #name,                                                                         \
+                    sizeof(FREE_LIST_STORE(name)),                                                 \
+                    GetArraySize(FREE_LIST_STORE(name).store),                                     \
+                    sizeof(FREE_LIST_STORE(name).store[0]))
+
+/** @brief The list of a store defined with FREE_LIST_STORE_DEF_STATIC(). */
+#define FREE_LIST_STATIC(name) (&FREE_LIST_STORE(name).list)
 
 typedef struct {
   free_list_t *list;
@@ -70,6 +104,7 @@ static inline free_list_t *free_list_init(free_list_create_params_t *p_params) {
     p_params->list->item_count = p_params->item_count;
     p_params->list->head = 0;
     p_params->list->current_available = 0;
+    p_params->list->next_fresh = p_params->item_count;
     for (size_t i = 0; i < p_params->item_count; i++) {
       KLIST_HEAD_PREPEND(p_params->list->head,
                          ((char *)p_params->data_store + (p_params->item_size * i)));
@@ -85,6 +120,10 @@ static inline KListElem *free_list_get(free_list_t *list) {
   if (list->head && list->current_available > 0) {
     KLIST_HEAD_POP(list->head, item);
     list->current_available--;
+  } else if (list->next_fresh < list->item_count) {
+    item = (KListElem *)((char *)list->data_store + (list->item_size * list->next_fresh++));
+    item->next = item->prev = 0;
+    list->current_available--;
   }
   return item;
 }
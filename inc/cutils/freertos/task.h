@@ -24,6 +24,7 @@
 #pragma once
 
 #include <FreeRTOS.h>
+#include <cutils/mem_report.h>
 #include <cutils/os_types.h>
 
 #include <stdalign.h>
@@ -92,6 +93,11 @@ typedef struct _task_create_params_t {
   void *ctx;
   void *stack;
   size_t stack_size;
+  /* Cores the task may run on, bit n for core n. Applied on SMP builds with
+   * configUSE_CORE_AFFINITY, ignored otherwise. 0 leaves it to the scheduler. */
+  uint64_t affinity;
+  /* Ignored, FreeRTOS has a single policy. */
+  task_sched_policy_e sched_policy;
 } task_create_params_t;
 
 /**
@@ -113,8 +119,18 @@ typedef struct _task_create_params_t {
   } TASK_STATIC_STORE_T(name)
 
 /** @brief Defines the static store as a used symbol. */
-#define TASK_STATIC_STORE_DEF(name)                                                                \
-  TASK_STATIC_STORE_T(name) TASK_STATIC_STORE(name) __attribute__((used))
+#define TASK_STATIC_STORE_DEF(name) TASK_STATIC_STORE_DEF_OWNED(name, MemReportTask)
+
+/** @brief As above, registering the store with mem_report under an enclosing `owner` kind. */
+#define TASK_STATIC_STORE_DEF_OWNED(name, owner)                                                   \
+  TASK_STATIC_STORE_T(name) TASK_STATIC_STORE(name) __attribute__((used));                         \
+  MEM_REPORT_RECORD(task_##name,                                                                   \
+                    MemReportTask,                                                                 \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(TASK_STATIC_STORE(name)),                                               \
+                    1,                                                                             \
+                    sizeof(TASK_STATIC_STORE(name).stack))
 
 /** @brief Internal helper to map a static store to task create parameters. */
 #define TASK_INIT_CREATE_PARAMS_FROM_STORE(params, store_ptr, lbl, pri, fn, context)               \
@@ -24,9 +24,11 @@
 #pragma once
 
 #include <FreeRTOS.h>
+#include <cutils/mem_report.h>
 #include <cutils/os_types.h>
 #include <queue.h>
 #include <string.h>
+#include <task.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,7 +48,25 @@ typedef struct _ts_queue_t {
     ts_queue_t queue;                                                                              \
   } TS_QUEUE_STORE_T(name)
 
-#define TS_QUEUE_STORE_DEF(name) static TS_QUEUE_STORE_T(name) TS_QUEUE_STORE(name)
+#define TS_QUEUE_STORE_DEF(name) TS_QUEUE_STORE_DEF_OWNED(name, MemReportTsQueue)
+
+#define TS_QUEUE_STORE_DEF_OWNED(name, owner)                                                      \
+  static TS_QUEUE_STORE_T(name) TS_QUEUE_STORE(name);                                              \
+  MEM_REPORT_RECORD(ts_queue_##name,                                                               \
+                    MemReportTsQueue,                                                              \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(TS_QUEUE_STORE(name)),                                                  \
+                    sizeof(TS_QUEUE_STORE(name).storage_array) / sizeof(void *),                   \
+                    sizeof(void *))
+
+/**
+ * @brief Static initialization is not available on this port, the kernel queue has to be created
+ * at runtime with ts_queue_init().
+ */
+#define TS_QUEUE_STORE_DEF_STATIC(name) TS_QUEUE_STORE_DEF_STATIC_OWNED(name, MemReportTsQueue)
+#define TS_QUEUE_STORE_DEF_STATIC_OWNED(name, owner)                                               \
+  _Static_assert(0, "TS_QUEUE_STORE_DEF_STATIC is not supported on FreeRTOS")
 
 typedef struct {
   ts_queue_t *queue;
@@ -95,6 +115,43 @@ static inline bool ts_queue_dequeue(ts_queue_t *queue, void **item, uint32_t wai
   return false;
 }
 
+/**
+ * @brief Enqueues up to `num_items` items, waiting up to `wait_ms` for space for each.
+ * @return the number of items enqueued, in order from the front of `pp_items`.
+ */
+static inline size_t
+ts_queue_enqueue_batch(ts_queue_t *queue, void **pp_items, size_t num_items, uint32_t wait_ms) {
+  size_t retval = 0;
+  if (queue && queue->handle && pp_items) {
+    TickType_t wait_ticks = (wait_ms == WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms);
+    while (retval < num_items &&
+           xQueueSend(queue->handle, &pp_items[retval], wait_ticks) == pdPASS) {
+      retval++;
+    }
+  }
+  return retval;
+}
+
+/**
+ * @brief Dequeues every queued item, up to `max_items`. Waits up to `wait_ms` for the first item,
+ * the rest are only taken if already queued.
+ * @return the number of items written to `pp_items`, 0 on timeout.
+ */
+static inline size_t
+ts_queue_dequeue_batch(ts_queue_t *queue, void **pp_items, size_t max_items, uint32_t wait_ms) {
+  size_t retval = 0;
+  if (queue && queue->handle && pp_items && max_items) {
+    TickType_t wait_ticks = (wait_ms == WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms);
+    if (xQueueReceive(queue->handle, &pp_items[0], wait_ticks) == pdPASS) {
+      retval = 1;
+      while (retval < max_items && xQueueReceive(queue->handle, &pp_items[retval], 0) == pdPASS) {
+        retval++;
+      }
+    }
+  }
+  return retval;
+}
+
 /**
  * @brief Attempts to enqueue an item on the queue from an ISR.
  *
@@ -208,6 +265,28 @@ ts_queue_dequeue_from_isr(ts_queue_t *queue, void **item, bool *higher_priority_
   return false;
 }
 
+/**
+ * @brief Dequeues the head item if `take` accepts it. Never blocks. The scheduler is suspended
+ * between the peek and the receive, so no other task can take the head in between. Consumers
+ * running in an ISR are not excluded.
+ * @return true if the head was dequeued.
+ */
+static inline bool ts_queue_dequeue_if(ts_queue_t *queue,
+                                       bool (*take)(void *p_item, void *ctx),
+                                       void *ctx,
+                                       void **item) {
+  bool retval = false;
+  if (queue && queue->handle && take && item) {
+    void *p_head = NULL;
+    vTaskSuspendAll();
+    if (xQueuePeek(queue->handle, &p_head, 0) == pdPASS && take(p_head, ctx)) {
+      retval = (xQueueReceive(queue->handle, item, 0) == pdPASS);
+    }
+    (void)xTaskResumeAll();
+  }
+  return retval;
+}
+
 static inline size_t ts_queue_get_count(ts_queue_t *queue) {
   return (queue && queue->handle) ? uxQueueMessagesWaiting(queue->handle) : 0;
 }
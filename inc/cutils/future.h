@@ -0,0 +1,125 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cutils/dispatch_queue.h>
+#include <cutils/event_flag.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A future holds a value that a dispatch work item produces later. The consumer either
+ * blocks in future_wait(), or attaches a continuation with future_then_f() that is posted to a
+ * queue once the value is there, so no thread sits idle waiting for another queue to answer.
+ *
+ * Futures come from a process-wide pool of CUTILS_SYSTEM_FUTURES entries, created on first use.
+ * They are reference counted: future_new() returns one reference, future_retain() adds one and
+ * future_release() drops one. A future goes back to the pool when its last reference is dropped.
+ * Work items and continuations that are in flight hold their own references.
+ */
+
+/** @brief A continuation. Runs on its queue with the value of the future it was attached to. */
+typedef void *(*future_function_t)(void *ctx, void *value);
+
+/** @brief A work item that produces the value of a future. */
+typedef void *(*future_work_t)(void *arg1, void *arg2);
+
+typedef struct _future_t {
+  void *value;
+  /* FUTURE_* bits, see future.c. */
+  atomic_uint state;
+  /* What produces the value: work(arg1, arg2) for dispatch_async_future_f(), then(arg1, value of
+   * the preceding future) for future_then_f(). */
+  future_work_t work;
+  future_function_t then;
+  void *arg1;
+  void *arg2;
+  /* The continuation's queue and the record reserved there to post it, so that the post cannot be
+   * refused. Written before the THEN bit is set, read once it is seen. */
+  dispatch_queue_t *p_queue;
+  struct _dispatch_queue_post_data_t *p_then;
+  /* Set once the value is there, and never cleared, so every waiter wakes. */
+  event_flag_t done;
+} future_t;
+
+/**
+ * @brief Takes an unfulfilled future from the pool.
+ * @return - the future holding one reference, NULL if every future is in use
+ */
+future_t *future_new(void);
+
+/** @brief Adds a reference to `p_future`. */
+void future_retain(future_t *p_future);
+
+/** @brief Drops a reference to `p_future`. It must not be used after its last one is dropped. */
+void future_release(future_t *p_future);
+
+/**
+ * @brief Sets the value of the future, wakes its waiters and posts its continuation, if one is
+ * attached. Lock free apart from waking the waiters. Only the first call has an effect.
+ * @return - true if this call fulfilled the future
+ */
+bool future_fulfill(future_t *p_future, void *value);
+
+/** @brief Whether the future has been fulfilled. Never blocks. */
+bool future_is_ready(future_t *p_future);
+
+/**
+ * @brief Waits up to `timeout_ms` for the future to be fulfilled. Any number of tasks can wait on
+ * the same future. Should not be called from a dispatch work item: attach a continuation instead.
+ * @param p_value - receives the value, may be NULL
+ * @return - true if the future was fulfilled in time
+ */
+bool future_wait(future_t *p_future, uint32_t timeout_ms, void **p_value);
+
+/**
+ * @brief Attaches a continuation. Once `p_future` is fulfilled, `fn(ctx, value)` is posted to
+ * `p_queue`, or at once if it already has been. A future takes one continuation. The continuation
+ * keeps `p_future` alive until it has run, so the caller can release its own reference right away.
+ * A post record of `p_queue` is reserved for the continuation right away, so posting it later
+ * cannot be refused.
+ * @return - a new future, fulfilled with what `fn` returns. NULL if the pool is exhausted or
+ * `p_queue` has no free record, in which case nothing is attached
+ */
+future_t *future_then_f(future_t *p_future,
+                        dispatch_queue_t *p_queue,
+                        future_function_t fn,
+                        void *ctx);
+
+/**
+ * @brief Posts `fn(arg1, arg2)` to `p_queue` and returns a future fulfilled with its result.
+ * @return - the future, NULL if the pool is exhausted or the item could not be posted
+ */
+future_t *dispatch_async_future_f(dispatch_queue_t *p_queue,
+                                  future_work_t fn,
+                                  void *arg1,
+                                  void *arg2);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,239 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cutils/logger.h>
+#include <cutils/mem_report.h>
+#include <cutils/os_types.h>
+#include <cutils/ts_queue.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A static generational handle table. Objects are registered in the table and clients are
+ * given an opaque 64 bit handle made of a 32 bit slot index and a 32 bit generation instead of a
+ * raw pointer. Releasing a handle bumps the generation of its slot, so any copy of the old handle
+ * held elsewhere stops resolving immediately instead of aliasing whatever is registered next.
+ *
+ * Allocation and release are O(1). Like pool_t, free slots are kept in a ts_queue_t, so the table
+ * size must be a power of 2. Lookup is O(1) and lock free: it only reads the slot's generation
+ * and object pointer.
+ *
+ * A generation is odd while the slot is live and even while it is free, so a valid handle is
+ * never 0 and HANDLE_INVALID can be used as a sentinel.
+ *
+ * Lookup validates the handle at the time of the call. It does not keep the object alive; if a
+ * handle can be released concurrently with its use, the object needs its own lifetime
+ * management, e.g. pool_retain().
+ */
+
+typedef uint64_t handle_t;
+
+#define HANDLE_INVALID ((handle_t)0)
+#define HANDLE_MAKE(index, generation) (((handle_t)(generation) << 32) | (uint32_t)(index))
+#define HANDLE_INDEX(handle) ((uint32_t)((handle) & 0xFFFFFFFFu))
+#define HANDLE_GENERATION(handle) ((uint32_t)((handle) >> 32))
+
+typedef struct _handle_table_slot_t {
+  atomic_uint generation;
+  _Atomic(void *) p_object;
+} handle_table_slot_t;
+
+typedef struct _handle_table_t {
+  handle_table_slot_t *p_slots;
+  uint32_t num_slots;
+  ts_queue_t *free_slots;
+} handle_table_t;
+
+#define HANDLE_TABLE_STORE(name) _handle_table_store_##name
+#define HANDLE_TABLE_STORE_T(name) handle_table_store_##name##_t
+
+/**
+ * @brief Declares the storage type for a handle table that can hold `num_handles` live handles at
+ * once. `num_handles` must be a power of 2.
+ */
+#define HANDLE_TABLE_STORE_DECL(name, num_handles)                                                 \
+  TS_QUEUE_STORE_DECL(handle_table_##name, num_handles);                                           \
+  typedef struct {                                                                                 \
+    handle_table_slot_t slots[num_handles];                                                        \
+    handle_table_t table;                                                                          \
+  } HANDLE_TABLE_STORE_T(name)
+
+/** @brief Defines the storage declared with HANDLE_TABLE_STORE_DECL(). */
+#define HANDLE_TABLE_STORE_DEF(name) HANDLE_TABLE_STORE_DEF_OWNED(name, MemReportHandleTable)
+
+/** @brief As above, registering the store with mem_report under an enclosing `owner` kind. */
+#define HANDLE_TABLE_STORE_DEF_OWNED(name, owner)                                                  \
+  HANDLE_TABLE_STORE_T(name) HANDLE_TABLE_STORE(name);                                             \
+  TS_QUEUE_STORE_DEF_OWNED(handle_table_##name, owner);                                            \
+  MEM_REPORT_RECORD(handle_table_##name,                                                           \
+                    MemReportHandleTable,                                                          \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(HANDLE_TABLE_STORE(name)),                                              \
+                    GetArraySize(HANDLE_TABLE_STORE(name).slots),                                  \
+                    sizeof(handle_table_slot_t))
+
+typedef struct _handle_table_create_params_t {
+  handle_table_t *p_table;
+  handle_table_slot_t *p_slots;
+  uint32_t num_slots;
+  ts_queue_create_params_t queue_params;
+} handle_table_create_params_t;
+
+/** @brief Fills in `params` for handle_table_create() from a named static store. */
+#define HANDLE_TABLE_CREATE_PARAMS_INIT(params, name)                                              \
+  memset(&(params), 0, sizeof((params)));                                                          \
+  (params).p_table = &HANDLE_TABLE_STORE(name).table;                                              \
+  (params).p_slots = HANDLE_TABLE_STORE(name).slots;                                               \
+  (params).num_slots = GetArraySize(HANDLE_TABLE_STORE(name).slots);                               \
+  TS_QUEUE_STORE_CREATE_PARAMS_INIT((params).queue_params, handle_table_##name)
+
+/**
+ * @brief Creates a handle table on static storage. Generations survive a destroy/create cycle of
+ * the same store, so handles issued before the table was recreated remain invalid.
+ * @param p_params - parameters filled in with HANDLE_TABLE_CREATE_PARAMS_INIT()
+ * @return - the table if successful, NULL otherwise
+ */
+static inline handle_table_t *handle_table_create(handle_table_create_params_t *p_params) {
+  handle_table_t *retval = 0;
+  if (p_params && p_params->p_table && p_params->p_slots && p_params->num_slots) {
+    handle_table_t *p_table = p_params->p_table;
+    p_table->free_slots = ts_queue_init(&p_params->queue_params);
+    CHECK_RUN(p_table->free_slots, return retval, "%s(): Couldn't create slot queue", __FUNCTION__);
+    p_table->p_slots = p_params->p_slots;
+    p_table->num_slots = p_params->num_slots;
+    for (uint32_t i = 0; i < p_table->num_slots; i++) {
+      handle_table_slot_t *p_slot = &p_table->p_slots[i];
+      uint32_t generation = atomic_load_explicit(&p_slot->generation, memory_order_relaxed);
+      // Retire anything that was live before, keeping the count monotonic.
+      atomic_store_explicit(
+          &p_slot->generation, generation + (generation & 1), memory_order_relaxed);
+      atomic_store_explicit(&p_slot->p_object, NULL, memory_order_relaxed);
+      ts_queue_enqueue(p_table->free_slots, p_slot, NO_SLEEP);
+    }
+    retval = p_table;
+  }
+  return retval;
+}
+
+/**
+ * @brief Releases the resources of the table. All outstanding handles become invalid.
+ */
+static inline void handle_table_destroy(handle_table_t *p_table) {
+  if (p_table) {
+    for (uint32_t i = 0; i < p_table->num_slots; i++) {
+      uint32_t generation =
+          atomic_load_explicit(&p_table->p_slots[i].generation, memory_order_relaxed);
+      atomic_store_explicit(
+          &p_table->p_slots[i].generation, generation + (generation & 1), memory_order_release);
+    }
+    ts_queue_destroy(p_table->free_slots);
+    p_table->free_slots = 0;
+  }
+}
+
+/**
+ * @brief Registers `p_object` and returns a handle to it.
+ * @param p_table - a valid table
+ * @param p_object - the object to register, must not be NULL
+ * @return - a new handle, or HANDLE_INVALID if the table is full
+ */
+static inline handle_t handle_table_alloc(handle_table_t *p_table, void *p_object) {
+  handle_t retval = HANDLE_INVALID;
+  handle_table_slot_t *p_slot = 0;
+  if (p_table && p_object && ts_queue_dequeue(p_table->free_slots, (void **)&p_slot, NO_SLEEP)) {
+    atomic_store_explicit(&p_slot->p_object, p_object, memory_order_relaxed);
+    // Publishing the odd generation makes the slot live, and orders the object store before it.
+    uint32_t generation =
+        atomic_fetch_add_explicit(&p_slot->generation, 1, memory_order_release) + 1;
+    retval = HANDLE_MAKE(p_slot - p_table->p_slots, generation);
+  }
+  return retval;
+}
+
+/**
+ * @brief Resolves a handle to its object without taking any locks.
+ * @param p_table - a valid table
+ * @param handle - any handle value
+ * @return - the registered object if the handle is live, NULL otherwise
+ */
+static inline void *handle_table_lookup(handle_table_t *p_table, handle_t handle) {
+  void *retval = 0;
+  uint32_t index = HANDLE_INDEX(handle);
+  uint32_t generation = HANDLE_GENERATION(handle);
+  if (p_table && (generation & 1) && index < p_table->num_slots) {
+    handle_table_slot_t *p_slot = &p_table->p_slots[index];
+    if (atomic_load_explicit(&p_slot->generation, memory_order_acquire) == generation) {
+      void *p_object = atomic_load_explicit(&p_slot->p_object, memory_order_relaxed);
+      // Recheck in case the slot was released (and possibly reused) while reading the object.
+      atomic_thread_fence(memory_order_acquire);
+      if (atomic_load_explicit(&p_slot->generation, memory_order_relaxed) == generation) {
+        retval = p_object;
+      }
+    }
+  }
+  return retval;
+}
+
+/** @brief Returns true if `handle` currently resolves to an object. */
+static inline bool handle_table_is_valid(handle_table_t *p_table, handle_t handle) {
+  return handle_table_lookup(p_table, handle) != 0;
+}
+
+/**
+ * @brief Invalidates `handle` and returns its slot to the table. Releasing a stale handle, or the
+ * same handle twice, fails without side effects.
+ * @param p_table - a valid table
+ * @param handle - a handle returned by handle_table_alloc()
+ * @return - true if the handle was live and has been released
+ */
+static inline bool handle_table_release(handle_table_t *p_table, handle_t handle) {
+  bool retval = false;
+  uint32_t index = HANDLE_INDEX(handle);
+  uint32_t generation = HANDLE_GENERATION(handle);
+  if (p_table && (generation & 1) && index < p_table->num_slots) {
+    handle_table_slot_t *p_slot = &p_table->p_slots[index];
+    uint32_t expected = generation;
+    // Only one releaser can move the generation on, so the slot is recycled exactly once.
+    if (atomic_compare_exchange_strong_explicit(&p_slot->generation,
+                                                &expected,
+                                                generation + 1,
+                                                memory_order_acq_rel,
+                                                memory_order_relaxed)) {
+      atomic_store_explicit(&p_slot->p_object, NULL, memory_order_relaxed);
+      ts_queue_enqueue(p_table->free_slots, p_slot, NO_SLEEP);
+      retval = true;
+    }
+  }
+  return retval;
+}
+
+#ifdef __cplusplus
+}
+#endif
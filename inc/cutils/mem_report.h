@@ -0,0 +1,136 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cutils/types.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Static memory footprint registration.
+ *
+ * Every `*_STORE_DEF` macro in cutils drops a mem_report_record_t describing the store it defines
+ * into the `cutils_mem_records` linker section. The records are plain data (no pointers) so they
+ * can be read back either at runtime through the API below, or offline from the linked ELF by the
+ * `cutils_mem_report` host tool.
+ *
+ * Each record describes only the bytes of the object its own macro defines. Composite stores
+ * (dispatch queues, notifiers, asyncio, state event loops) register their nested pools, queues
+ * and tasks as separate records, tagging them with the composite as their `owner`. Summing records
+ * by owner therefore gives the full footprint of a subsystem without double counting.
+ */
+
+#define MEM_REPORT_KIND_E(XX)                                                                      \
+  XX(MemReportPool, )                                                                              \
+  XX(MemReportTsQueue, )                                                                           \
+  XX(MemReportTask, )                                                                              \
+  XX(MemReportDispatchQueue, )                                                                     \
+  XX(MemReportNotifier, )                                                                          \
+  XX(MemReportAsyncio, )                                                                           \
+  XX(MemReportRingBuffer, )                                                                        \
+  XX(MemReportAccumulator, )                                                                       \
+  XX(MemReportFreeList, )                                                                          \
+  XX(MemReportStateEventLoop, )                                                                    \
+  XX(MemReportHandleTable, )                                                                       \
+  XX(MemReportTimerWheel, )                                                                        \
+  XX(MemReportTaskGraph, )                                                                         \
+  XX(MemReportFuture, )                                                                            \
+  XX(MemReportKindCount, )
+
+DECLARE_ENUM(mem_report_kind_e, MEM_REPORT_KIND_E)
+
+#define MEM_REPORT_NAME_LEN (64)
+#define MEM_REPORT_SECTION "cutils_mem_records"
+
+/**
+ * @brief A single store registration. Only fixed width fields are used so the layout is identical
+ * on 32 and 64 bit targets and the host tool can parse the section of a cross compiled image.
+ */
+typedef struct _mem_report_record_t {
+  uint32_t kind;         /**< mem_report_kind_e of the store itself */
+  uint32_t owner;        /**< mem_report_kind_e of the top level store this one belongs to */
+  uint32_t size;         /**< bytes occupied by this store, excluding nested stores */
+  uint32_t count;        /**< number of elements (pool blocks, queue slots, bytes, ...) */
+  uint32_t element_size; /**< size of each element in bytes */
+  char name[MEM_REPORT_NAME_LEN];
+} mem_report_record_t;
+
+/**
+ * @brief Used by the `*_STORE_DEF` macros to register a store. `sym` must be unique per
+ * translation unit, so callers combine the kind with the store name.
+ */
+#define MEM_REPORT_RECORD(sym, kind, owner, name, bytes, num, elem_size)                           \
+  static const mem_report_record_t _mem_report_record_##sym                                        \
+      __attribute__((section(MEM_REPORT_SECTION), used, aligned(4))) = {                           \
+          (uint32_t)(kind),                                                                        \
+          (uint32_t)(owner),                                                                       \
+          (uint32_t)(bytes),                                                                       \
+          (uint32_t)(num),                                                                         \
+          (uint32_t)(elem_size),                                                                   \
+          name}
+
+/**
+ * @brief Callback used to walk all registered records.
+ */
+typedef void (*mem_report_record_f)(const mem_report_record_t *p_record, void *ctx);
+
+/**
+ * @brief Number of stores registered in the linked image.
+ */
+size_t mem_report_record_count(void);
+
+/**
+ * @brief Returns the registration at `index`, NULL if out of range.
+ */
+const mem_report_record_t *mem_report_record_at(size_t index);
+
+/**
+ * @brief Calls `fn` on every registered store.
+ * @return number of records visited.
+ */
+size_t mem_report_foreach(mem_report_record_f fn, void *ctx);
+
+/**
+ * @brief Total bytes of all stores whose owner is `owner`, ie the full footprint of a subsystem.
+ */
+uint64_t mem_report_subsystem_bytes(mem_report_kind_e owner);
+
+/**
+ * @brief Total bytes of all stores of the given kind regardless of which subsystem owns them.
+ */
+uint64_t mem_report_kind_bytes(mem_report_kind_e kind);
+
+/**
+ * @brief Logs a per-subsystem summary to the console. If `verbose` every record is listed too.
+ */
+void mem_report_log(bool verbose);
+
+#ifdef __cplusplus
+}
+#endif
@@ -114,9 +114,18 @@ typedef struct _notifier_create_params_t {
   size_t _notif_registration_size_##name = notif_reg_size;                                         \
   uint32_t _notif_num_of_registrations_##name = max_regs
 
-#define NOTIFIER_STORE_DEF(name)                                                                   \
+#define NOTIFIER_STORE_DEF(name) NOTIFIER_STORE_DEF_OWNED(name, MemReportNotifier)
+
+#define NOTIFIER_STORE_DEF_OWNED(name, owner)                                                      \
   NOTIFIER_STORE_T(name) NOTIFIER_STORE(name);                                                     \
-  POOL_STORE_DEF(notif_pool_##name)
+  POOL_STORE_DEF_OWNED(notif_pool_##name, owner);                                                  \
+  MEM_REPORT_RECORD(notifier_##name,                                                               \
+                    MemReportNotifier,                                                             \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(NOTIFIER_STORE(name)),                                                  \
+                    GetArraySize(NOTIFIER_STORE(name).notifierArray),                              \
+                    sizeof(KListHead *))
 
 // Use this macro to initialize a notifier_create_params_t if you created storage using the above
 // DECL/DEF macros.
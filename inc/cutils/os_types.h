@@ -54,7 +54,22 @@ typedef void (*dispatch_function_t)(void *arg1, void *arg2);
  */
 typedef atomic_uint dispatch_predicate_t;
 
-typedef void *dispatch_queue_timed_action_h;
+/**
+ * @brief Handle of a repeated action. A generational handle into the timer wheel, so a stale one
+ * never stops another action. 0 is never a valid handle.
+ */
+typedef uint64_t dispatch_queue_timed_action_h;
+
+/**
+ * @brief Per task override of the scheduling policy, see task_create_params_t::sched_policy.
+ * Ports without scheduling policies ignore it.
+ */
+typedef enum {
+  TASK_SCHED_DEFAULT, /**< The build's CUTILS_PTHREAD_SCHED_POLICY. */
+  TASK_SCHED_OTHER,   /**< Time shared. `priority` is ignored. */
+  TASK_SCHED_FIFO,    /**< Real time, run to completion. Needs CAP_SYS_NICE on Linux. */
+  TASK_SCHED_RR,      /**< Real time, round robin. Needs CAP_SYS_NICE on Linux. */
+} task_sched_policy_e;
 
 typedef struct _dispatch_queue_t dispatch_queue_t;
 
@@ -26,9 +26,11 @@
 
 #include <cutils/logger.h>
 #include <cutils/os_types.h>
+#include <cutils/pool_ops.h>
 #include <cutils/ts_queue.h>
 #include <stdalign.h>
 #include <stdatomic.h>
+#include <stddef.h>
 #include <string.h>
 
 #ifdef __cplusplus
@@ -47,11 +49,18 @@ extern "C" {
  */
 typedef void (*pool_element_destructor_f)(void *mem, void *private);
 
-typedef struct {
+typedef struct _pool_t {
   ts_queue_t *q;
   size_t num_of_elements;
   size_t element_size;
   size_t offset_data_from_header;
+  uint8_t *p_backing_begin;
+  uint8_t *p_backing_end;
+  size_t total_element_size;
+  /* Index of the first element that has never been handed out. Pools built by pool_create() link
+   * every element up front and start with this at num_of_elements; statically initialized pools
+   * start at 0 and hand out fresh elements lazily. */
+  atomic_size_t fresh_index;
 } pool_t;
 
 typedef struct _pool_header_t {
@@ -61,6 +70,7 @@ typedef struct _pool_header_t {
   void *destructor_private;
 } pool_header_t;
 
+#define POOL_ELEMENT_TYPE(name) pool_static_element_##name##_t
 #define POOL_STORE_TYPE(name) pool_static_backing_store_##name##_t
 #define POOL_STORE_PTR_TYPE(name) POOL_STORE_TYPE(name) *
 #define POOL_STORE(name) _pool_backing_store_##name
@@ -75,11 +85,12 @@ typedef struct _pool_header_t {
 #define POOL_STORE_DECL(name, num_elemens, element_size, align)                                    \
   TS_QUEUE_STORE_DECL(pool_##name, num_elemens);                                                   \
   typedef struct {                                                                                 \
-    struct {                                                                                       \
-      pool_header_t header;                                                                        \
-      alignas(align) uint8_t data[element_size];                                                   \
-      uint32_t trailer_sanity;                                                                     \
-    } elements[num_elemens];                                                                       \
+    pool_header_t header;                                                                          \
+    alignas(align) uint8_t data[element_size];                                                     \
+    uint32_t trailer_sanity;                                                                       \
+  } POOL_ELEMENT_TYPE(name);                                                                       \
+  typedef struct {                                                                                 \
+    POOL_ELEMENT_TYPE(name) elements[num_elemens];                                                 \
     pool_t pool;                                                                                   \
   } POOL_STORE_TYPE(name)
 
@@ -88,9 +99,54 @@ typedef struct _pool_header_t {
  * needed by a pool. Use this macro after declaring a pool storage as above. Continuing with the
  * above example, POOL_STORE_DEF(someMacroIdentifier)
  */
-#define POOL_STORE_DEF(name)                                                                       \
+#define POOL_STORE_DEF(name) POOL_STORE_DEF_OWNED(name, MemReportPool)
+
+/**
+ * @brief Same as POOL_STORE_DEF() but the pool is registered with mem_report as part of an
+ * enclosing store of kind `owner`. Used by the composite store macros.
+ */
+#define POOL_STORE_DEF_OWNED(name, owner)                                                          \
   POOL_STORE_TYPE(name) POOL_STORE(name);                                                          \
-  TS_QUEUE_STORE_DEF(pool_##name)
+  TS_QUEUE_STORE_DEF_OWNED(pool_##name, owner);                                                    \
+  MEM_REPORT_RECORD(pool_##name,                                                                   \
+                    MemReportPool,                                                                 \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(POOL_STORE(name)),                                                      \
+                    GetArraySize(POOL_STORE(name).elements),                                       \
+                    sizeof(POOL_STORE(name).elements[0].data))
+
+/**
+ * @brief Defines the pool storage with the pool already usable through POOL_STATIC(name), with no
+ * call to pool_create(). Nothing is linked at startup: elements that have never been allocated are
+ * handed out in order on first use and only recycled elements go through the free queue. Not
+ * available on ports whose queues need runtime creation (FreeRTOS).
+ */
+#define POOL_STORE_DEF_STATIC(name) POOL_STORE_DEF_STATIC_OWNED(name, MemReportPool)
+
+/** @brief As above, registering the store with mem_report under an enclosing `owner` kind. */
+#define POOL_STORE_DEF_STATIC_OWNED(name, owner)                                                   \
+  TS_QUEUE_STORE_DEF_STATIC_OWNED(pool_##name, owner);                                             \
+  POOL_STORE_TYPE(name) POOL_STORE(name) = {                                                       \
+      .pool = {.q = TS_QUEUE_STATIC(pool_##name),                                                  \
+               .num_of_elements = GetArraySize(POOL_STORE(name).elements),                         \
+               .element_size = sizeof(POOL_STORE(name).elements[0].data),                          \
+               .offset_data_from_header = offsetof(POOL_ELEMENT_TYPE(name), data),                 \
+               .p_backing_begin = (uint8_t *)POOL_STORE(name).elements,                            \
+               .p_backing_end = (uint8_t *)(POOL_STORE(name).elements +                            \
+                                            GetArraySize(POOL_STORE(name).elements)),              \
+               .total_element_size = sizeof(POOL_ELEMENT_TYPE(name)),                              \
+               .fresh_index = 0}};                                                                 \
+  MEM_REPORT_RECORD(pool_##name,                                                                   \
+                    MemReportPool,                                                                 \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(POOL_STORE(name)),                                                      \
+                    GetArraySize(POOL_STORE(name).elements),                                       \
+                    sizeof(POOL_STORE(name).elements[0].data))
+
+/** @brief The pool of a store defined with POOL_STORE_DEF_STATIC(). */
+#define POOL_STATIC(name) (&POOL_STORE(name).pool)
 
 typedef struct _pool_create_params_t {
   pool_t *p_pool;
@@ -146,6 +202,12 @@ static inline pool_t *pool_create(pool_create_params_t *create_params) {
       create_params->p_pool->num_of_elements = create_params->num_of_elements;
       create_params->p_pool->element_size = create_params->element_size_requested;
       create_params->p_pool->offset_data_from_header = create_params->offset_data_from_header;
+      create_params->p_pool->p_backing_begin = create_params->p_backing;
+      create_params->p_pool->p_backing_end =
+          create_params->p_backing +
+          (create_params->num_of_elements * create_params->total_element_size);
+      create_params->p_pool->total_element_size = create_params->total_element_size;
+      atomic_init(&create_params->p_pool->fresh_index, create_params->num_of_elements);
       for (uint32_t i = 0; i < create_params->num_of_elements; i++) {
         uint8_t *data = create_params->p_backing + (i * create_params->total_element_size) +
                         create_params->offset_data_from_header;
@@ -175,6 +237,46 @@ static inline void pool_destroy(pool_t *p_pool) {
   }
 }
 
+/**
+ * @brief Internal. Hands out an element of a statically initialized pool that has never been
+ * allocated before, initializing its sanity words on the way.
+ * @return - the data block, NULL once every element has been handed out at least once
+ */
+static inline void *pool_alloc_fresh(pool_t *p_pool) {
+  void *retval = 0;
+  size_t index = atomic_load_explicit(&p_pool->fresh_index, memory_order_relaxed);
+  while (index < p_pool->num_of_elements) {
+    if (atomic_compare_exchange_weak_explicit(&p_pool->fresh_index,
+                                              &index,
+                                              index + 1,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed)) {
+      pool_header_t *p_header =
+          (pool_header_t *)(p_pool->p_backing_begin + (index * p_pool->total_element_size));
+      retval = (uint8_t *)p_header + p_pool->offset_data_from_header;
+      p_header->sanity = POOL_ELEMENT_HEADER_SANITY;
+      atomic_init(&p_header->retain_count, 0);
+      p_header->destructor = 0;
+      p_header->destructor_private = 0;
+      *((uint32_t *)((uint8_t *)retval + p_pool->element_size)) = POOL_ELEMENT_TRAILER_SANITY;
+      break;
+    }
+  }
+  return retval;
+}
+
+/**
+ * @brief Checks whether `p_mem` lies within the backing storage of the pool. This does not imply
+ * the block is currently allocated, only that it was handed out by this pool at some point.
+ * @param p_pool - a valid pool
+ * @param p_mem - any pointer
+ * @return - true if the pointer belongs to the pool's storage
+ */
+static inline bool pool_owns(const pool_t *p_pool, const void *p_mem) {
+  return p_pool && ((const uint8_t *)p_mem >= p_pool->p_backing_begin) &&
+         ((const uint8_t *)p_mem < p_pool->p_backing_end);
+}
+
 /**
  * @brief Will allocate a fixed size block from the pool. Will block for `wait_ms` if the pool is
  * empty.
@@ -191,7 +293,14 @@ static inline void *pool_alloc_blocking(pool_t *p_pool,
   void *retval = 0;
   if (p_pool) {
     pool_header_t *p_header = 0;
-    if (ts_queue_dequeue(p_pool->q, &retval, wait_ms)) {
+    bool got = ts_queue_dequeue(p_pool->q, &retval, NO_SLEEP);
+    if (!got && (retval = pool_alloc_fresh(p_pool))) {
+      got = true;
+    }
+    if (!got && wait_ms != NO_SLEEP) {
+      got = ts_queue_dequeue(p_pool->q, &retval, wait_ms);
+    }
+    if (got) {
       p_header = (pool_header_t *)((uint8_t *)retval - p_pool->offset_data_from_header);
       CUTILS_ASSERT(p_header->sanity == POOL_ELEMENT_HEADER_SANITY);
       CUTILS_ASSERT(*((uint32_t *)(retval + p_pool->element_size)) == POOL_ELEMENT_TRAILER_SANITY);
@@ -228,6 +337,23 @@ static inline void pool_retain(pool_t *p_pool, void *p_mem) {
   }
 }
 
+/**
+ * @brief Internal. Drops one reference to the block and runs its destructor if that was the last.
+ * @return - true if the block is now unreferenced and should go back to the free queue
+ */
+static inline bool pool_release(pool_t *p_pool, void *p_mem) {
+  pool_header_t *p_header = p_mem - p_pool->offset_data_from_header;
+  uint32_t old_retain_count;
+  CUTILS_ASSERT(p_header->sanity == POOL_ELEMENT_HEADER_SANITY);
+  CUTILS_ASSERT(*((uint32_t *)(p_mem + p_pool->element_size)) == POOL_ELEMENT_TRAILER_SANITY);
+  old_retain_count = atomic_fetch_sub_explicit(&p_header->retain_count, 1, memory_order_acq_rel);
+  CUTILS_ASSERT(old_retain_count != 0);
+  if (old_retain_count == 1 && p_header->destructor) {
+    p_header->destructor(p_mem, p_header->destructor_private);
+  }
+  return (old_retain_count == 1);
+}
+
 /**
  * @brief - Returns the supplied block back to the pool if the reference count hits zero. Otherwise
  * simply lowers the reference count of the supplied allocation. Clients should not use the supplied
@@ -236,17 +362,28 @@ static inline void pool_retain(pool_t *p_pool, void *p_mem) {
  * @param p_mem - Block Allocation to return to the pool
  */
 static inline void pool_free(pool_t *p_pool, void *p_mem) {
+  if (p_pool && pool_release(p_pool, p_mem)) {
+    ts_queue_enqueue(p_pool->q, p_mem, NO_SLEEP);
+  }
+}
+
+/**
+ * @brief Calls pool_free() on each of `count` blocks, but returns the blocks whose count hits zero
+ * to the pool with a single queue operation. `pp_mem` is reordered in the process.
+ * @param p_pool - a valid pool
+ * @param pp_mem - Block allocations to return to the pool
+ * @param count - number of entries in `pp_mem`
+ */
+static inline void pool_free_batch(pool_t *p_pool, void **pp_mem, size_t count) {
   if (p_pool) {
-    pool_header_t *p_header = p_mem - p_pool->offset_data_from_header;
-    uint32_t old_retain_count;
-    CUTILS_ASSERT(p_header->sanity == POOL_ELEMENT_HEADER_SANITY);
-    CUTILS_ASSERT(*((uint32_t *)(p_mem + p_pool->element_size)) == POOL_ELEMENT_TRAILER_SANITY);
-    old_retain_count = atomic_fetch_sub_explicit(&p_header->retain_count, 1, memory_order_acq_rel);
-    CUTILS_ASSERT(old_retain_count != 0);
-    if (old_retain_count == 1) {
-      if (p_header->destructor)
-        p_header->destructor(p_mem, p_header->destructor_private);
-      ts_queue_enqueue(p_pool->q, p_mem, NO_SLEEP);
+    size_t released = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (pool_release(p_pool, pp_mem[i])) {
+        pp_mem[released++] = pp_mem[i];
+      }
+    }
+    if (released) {
+      ts_queue_enqueue_batch(p_pool->q, pp_mem, released, NO_SLEEP);
     }
   }
 }
@@ -0,0 +1,56 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Out of line pool operations. pool.h is implemented inline on top of C11 atomics and can
+ * only be consumed from C. These entry points only need an incomplete pool_t, so they can be
+ * declared from languages that cannot include pool.h, such as the C++ adapters in
+ * pool_resource.hpp. Pools themselves are still defined and created from C.
+ */
+typedef struct _pool_t pool_t;
+
+/** @brief Non-blocking pool_alloc(). Returns NULL if the pool is exhausted. */
+void *pool_ops_alloc(pool_t *p_pool);
+
+/** @brief pool_free() */
+void pool_ops_free(pool_t *p_pool, void *p_mem);
+
+/** @brief Usable size in bytes of each block of the pool. */
+size_t pool_ops_element_size(const pool_t *p_pool);
+
+/** @brief pool_owns() */
+bool pool_ops_owns(const pool_t *p_pool, const void *p_mem);
+
+#ifdef __cplusplus
+}
+#endif
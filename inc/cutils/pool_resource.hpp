@@ -0,0 +1,167 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error "cutils/pool_resource.hpp requires C++17"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cutils/pool_ops.h>
+#include <memory_resource>
+
+/**
+ * @brief std::pmr::memory_resource adapters over cutils pools so that STL containers can allocate
+ * out of static storage.
+ *
+ * The pools are declared, defined and created in C as usual (POOL_STORE_DECL/POOL_STORE_DEF/
+ * pool_create()) and the resulting pool_t pointers are handed to the adapters. Allocation never
+ * blocks. When a request can not be served from a pool it is forwarded to the upstream resource,
+ * which defaults to std::pmr::null_memory_resource() so that exhaustion raises std::bad_alloc
+ * rather than silently falling back to the heap. The adapters add no locking of their own; pools
+ * are already thread safe.
+ */
+namespace cutils {
+
+namespace detail {
+inline bool is_aligned(const void *p, std::size_t alignment) noexcept {
+  return (reinterpret_cast<std::uintptr_t>(p) & (alignment - 1)) == 0;
+}
+
+/* Try to serve a request out of `p_pool`. Every block of a pool shares the same alignment, so a
+ * misaligned block means the pool can never satisfy this alignment. */
+inline void *try_pool_alloc(pool_t *p_pool, std::size_t bytes, std::size_t alignment) noexcept {
+  if (bytes > pool_ops_element_size(p_pool)) {
+    return nullptr;
+  }
+  void *p = pool_ops_alloc(p_pool);
+  if (p && !is_aligned(p, alignment)) {
+    pool_ops_free(p_pool, p);
+    p = nullptr;
+  }
+  return p;
+}
+} // namespace detail
+
+/**
+ * @brief Memory resource backed by a single fixed block size pool. Requests up to the pool's
+ * element size are served from the pool, anything larger goes to the upstream resource.
+ */
+class pool_resource : public std::pmr::memory_resource {
+public:
+  explicit pool_resource(
+      pool_t *p_pool,
+      std::pmr::memory_resource *p_upstream = std::pmr::null_memory_resource()) noexcept
+      : p_pool_(p_pool), p_upstream_(p_upstream) {}
+
+  pool_resource(const pool_resource &) = delete;
+  pool_resource &operator=(const pool_resource &) = delete;
+
+  pool_t *pool() const noexcept { return p_pool_; }
+  std::pmr::memory_resource *upstream_resource() const noexcept { return p_upstream_; }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    void *p = detail::try_pool_alloc(p_pool_, bytes, alignment);
+    return p ? p : p_upstream_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+    if (pool_ops_owns(p_pool_, p)) {
+      pool_ops_free(p_pool_, p);
+    } else {
+      p_upstream_->deallocate(p, bytes, alignment);
+    }
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  pool_t *p_pool_;
+  std::pmr::memory_resource *p_upstream_;
+};
+
+/**
+ * @brief Memory resource for general sizes backed by a set of pools acting as size classes. A
+ * request is served by the smallest class that fits it; if that class is exhausted it spills into
+ * the next larger one before going upstream. The pools are ordered by element size at
+ * construction, so they may be supplied in any order.
+ */
+template <std::size_t N> class size_class_resource : public std::pmr::memory_resource {
+  static_assert(N > 0, "size_class_resource needs at least one pool");
+
+public:
+  explicit size_class_resource(
+      const std::array<pool_t *, N> &pools,
+      std::pmr::memory_resource *p_upstream = std::pmr::null_memory_resource()) noexcept
+      : pools_(pools), p_upstream_(p_upstream) {
+    std::sort(pools_.begin(), pools_.end(), [](const pool_t *a, const pool_t *b) {
+      return pool_ops_element_size(a) < pool_ops_element_size(b);
+    });
+  }
+
+  size_class_resource(const size_class_resource &) = delete;
+  size_class_resource &operator=(const size_class_resource &) = delete;
+
+  /** @brief Largest request that can be served out of the pools. */
+  std::size_t max_block_size() const noexcept { return pool_ops_element_size(pools_[N - 1]); }
+  std::pmr::memory_resource *upstream_resource() const noexcept { return p_upstream_; }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    for (pool_t *p_pool : pools_) {
+      void *p = detail::try_pool_alloc(p_pool, bytes, alignment);
+      if (p) {
+        return p;
+      }
+    }
+    return p_upstream_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+    for (pool_t *p_pool : pools_) {
+      if (pool_ops_owns(p_pool, p)) {
+        pool_ops_free(p_pool, p);
+        return;
+      }
+    }
+    p_upstream_->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  std::array<pool_t *, N> pools_;
+  std::pmr::memory_resource *p_upstream_;
+};
+
+} // namespace cutils
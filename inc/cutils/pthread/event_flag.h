@@ -96,10 +96,16 @@ static inline bool event_flag_wait(event_flag_t *p_flags,
       clock_gettime(CLOCK_REALTIME, &ts);
       ts.tv_sec += wait_ms / 1000;
       ts.tv_nsec += (wait_ms % 1000) * 1000000;
+      if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+      }
     }
     int rval = 0;
     if (wait_ms == NO_SLEEP) {
       rval = pthread_mutex_trylock(&p_flags->mtx);
+    } else if (wait_ms == WAIT_FOREVER) {
+      rval = pthread_mutex_lock(&p_flags->mtx);
     } else {
       rval = pthread_mutex_timedlock(&p_flags->mtx, &ts);
     }
@@ -109,20 +115,22 @@ static inline bool event_flag_wait(event_flag_t *p_flags,
         clock_gettime(CLOCK_REALTIME, &ts);
         ts.tv_sec += wait_ms / 1000;
         ts.tv_nsec += (wait_ms % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+          ts.tv_sec++;
+          ts.tv_nsec -= 1000000000;
+        }
         rval = pthread_cond_timedwait(&p_flags->cv, &p_flags->mtx, &ts);
       } else {
         rval = pthread_cond_wait(&p_flags->cv, &p_flags->mtx);
       }
-      CHECK_RUN(!rval || (rval != ETIMEDOUT && rval != EINVAL && rval != EPERM),
-                pthread_mutex_unlock(&p_flags->mtx);
-                return retval;
-                , "Condition Variable wait failed due to error: %d", rval);
       if (rval) {
         break;
       }
     }
     pthread_mutex_unlock(&p_flags->mtx);
-    retval = true;
+    // Running out of time is how a timed wait normally fails, so only other errors are logged.
+    CLOG_IF(rval && rval != ETIMEDOUT, "Condition Variable wait failed due to error: %d", rval);
+    retval = !rval;
   }
   return retval;
 }
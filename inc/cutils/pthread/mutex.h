@@ -35,6 +35,9 @@ typedef struct _mutex_t {
   pthread_mutex_t mtx;
 } mutex_t;
 
+/** @brief Static initializer for a mutex_t, equivalent to mutex_new(). */
+#define MUTEX_STATIC_INIT {.mtx = PTHREAD_MUTEX_INITIALIZER}
+
 static inline bool mutex_new(mutex_t *mutex) {
   bool res = false;
   pthread_mutexattr_t attr;
@@ -68,6 +71,10 @@ static inline bool mutex_lock(mutex_t *mutex, uint32_t wait_ms) {
       clock_gettime(CLOCK_REALTIME, &tm);
       tm.tv_sec += wait_ms / 1000;
       tm.tv_nsec += 1000000 * (wait_ms % 1000);
+      if (tm.tv_nsec >= 1000000000) {
+        tm.tv_sec++;
+        tm.tv_nsec -= 1000000000;
+      }
       retval = (!pthread_mutex_timedlock(&mutex->mtx, &tm));
     }
   }
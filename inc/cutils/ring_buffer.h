@@ -34,6 +34,7 @@ using namespace std;
 extern "C" {
 #endif
 
+#include <cutils/mem_report.h>
 #include <cutils/types.h>
 #include <stdio.h>
 #include <string.h>
@@ -108,7 +109,14 @@ typedef struct ring_buffer *ring_buffer_ref;
 typedef void (*data_changed_at_range_f)(ring_buffer_ref buffer, void *ctx, data_range_t range);
 
 typedef struct ring_buffer {
+  /* Read only after creation, apart from the callback setters. */
   uint32_t size;
+  // ptr to the mapped region
+  uint8_t *data;
+  // callbacks;
+  void *ctx;
+  data_changed_at_range_f on_data_read_at_range;
+  data_changed_at_range_f on_data_written_at_range;
 
   /*
    Sequentially consistent is the default type for classic C-style operations on _Atomic()
@@ -117,28 +125,29 @@ typedef struct ring_buffer {
    a++; // <- This is sequentially consistent
    http://www.informit.com/articles/article.aspx?p=1832575&seqNum=4
    */
-  atomic_ullong read_offset; // start offset for available data. these monotonically increase and do
-                             // not wrap around
-  atomic_ullong write_offset;
-
-  // ptr to the mapped region
-  uint8_t *data;
-
-  // callbacks;
-  void *ctx;
-  data_changed_at_range_f on_data_read_at_range;
-  data_changed_at_range_f on_data_written_at_range;
+  // start offset for available data. these monotonically increase and do not wrap around. The
+  // reader owns read_offset and the writer owns write_offset, so they live on separate lines.
+  CUTILS_CACHE_ALIGNED atomic_ullong read_offset;
+  CUTILS_CACHE_ALIGNED atomic_ullong write_offset;
 } ring_buffer_t;
 
 #define MEM_RING_BUFFER_STORE(name) __mem_ring_buffer_store_##name
 #define MEM_RING_BUFFER_STORE_T(name) __mem_ring_buffer_store_##name##_t
 #define MEM_RING_BUFFER_STORE_DECL(name, sizeInBytes)                                              \
   typedef struct {                                                                                 \
-    ring_buffer rb;                                                                                \
+    struct ring_buffer rb;                                                                         \
     uint8_t buffer[sizeInBytes];                                                                   \
   } MEM_RING_BUFFER_STORE_T(name)
 
-#define MEM_RING_BUFFER_STORE_DEF(name) MEM_RING_BUFFER_STORE_T(name) MEM_RING_BUFFER_STORE(name)
+#define MEM_RING_BUFFER_STORE_DEF(name)                                                            \
+  MEM_RING_BUFFER_STORE_T(name) MEM_RING_BUFFER_STORE(name);                                       \
+  MEM_REPORT_RECORD(ring_buffer_##name,                                                            \
+                    MemReportRingBuffer,                                                           \
+                    MemReportRingBuffer,                                                           \
+                    #name,                                                                         \
+                    sizeof(MEM_RING_BUFFER_STORE(name)),                                           \
+                    sizeof(MEM_RING_BUFFER_STORE(name).buffer),                                    \
+                    1)
 
 typedef struct {
   struct ring_buffer *buffer;
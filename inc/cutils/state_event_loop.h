@@ -143,10 +143,17 @@ typedef struct {
   } STATE_EVENT_LOOP_STORE_T(name);
 
 #define STATE_EVENT_LOOP_STORE_DEF(name)                                                           \
-  static DISPATCH_QUEUE_STORE_DEF(name);                                                           \
-  static NOTIFIER_STORE_DEF(name);                                                                 \
-  static POOL_STORE_DEF(name);                                                                     \
-  static STATE_EVENT_LOOP_STORE_T(name) STATE_EVENT_LOOP_STORE(name)
+  static DISPATCH_QUEUE_STORE_DEF_OWNED(name, MemReportStateEventLoop);                            \
+  static NOTIFIER_STORE_DEF_OWNED(name, MemReportStateEventLoop);                                  \
+  static POOL_STORE_DEF_OWNED(name, MemReportStateEventLoop);                                      \
+  static STATE_EVENT_LOOP_STORE_T(name) STATE_EVENT_LOOP_STORE(name);                              \
+  MEM_REPORT_RECORD(state_event_loop_##name,                                                       \
+                    MemReportStateEventLoop,                                                       \
+                    MemReportStateEventLoop,                                                       \
+                    #name,                                                                         \
+                    sizeof(STATE_EVENT_LOOP_STORE(name)),                                          \
+                    GetArraySize(STATE_EVENT_LOOP_STORE(name).sm),                                 \
+                    sizeof(state_machine_t))
 
 #define STATE_EVENT_LOOP_CREATE_PARAMS_INIT(                                                       \
     params, nm, task_name, task_priority, notifier_f, sm_names, start_states, client_data)         \
@@ -0,0 +1,187 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <cutils/dispatch_queue.h>
+#include <cutils/mem_report.h>
+#include <cutils/signal.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A static task graph runs a fixed set of functions, each on its own dispatch queue, in an
+ * order given by the edges between them. A node is posted to its queue once every node it depends
+ * on has completed, so independent branches run in parallel across queues.
+ *
+ * Nodes and edges live in storage sized by TASKGRAPH_STORE_DECL(). Each node keeps an atomic count
+ * of the predecessors it still waits for. A node that completes decrements the counts of its
+ * successors and posts the ones that reach zero. Running the graph again only resets those counts,
+ * so a graph can be run once per frame without allocating anything.
+ */
+
+#define TASKGRAPH_NODE_INVALID (UINT32_MAX)
+
+typedef struct _taskgraph_node_t {
+  dispatch_function_t fn;
+  void *arg1;
+  void *arg2;
+  dispatch_queue_t *p_queue;
+  struct _taskgraph_t *p_graph;
+  /* Outgoing edges in the order they were added, TASKGRAPH_NODE_INVALID terminated. */
+  uint32_t first_edge;
+  uint32_t last_edge;
+  uint32_t num_predecessors;
+  /* Reserved on the node's queue when a run starts, posted once the predecessors are done. */
+  struct _dispatch_queue_post_data_t *p_post;
+  /* Predecessors not completed yet in the current run, decremented by each of them. */
+  CUTILS_CACHE_ALIGNED atomic_uint waiting;
+} taskgraph_node_t;
+
+typedef struct _taskgraph_edge_t {
+  uint32_t to;
+  uint32_t next;
+} taskgraph_edge_t;
+
+typedef struct _taskgraph_t {
+  taskgraph_node_t *p_nodes;
+  uint32_t max_nodes;
+  uint32_t num_nodes;
+  taskgraph_edge_t *p_edges;
+  uint32_t max_edges;
+  uint32_t num_edges;
+  /* Scratch for the cycle check, which runs again after the graph has changed. */
+  uint32_t *p_order;
+  bool checked;
+  bool acyclic;
+  /* Where the current run reports completion, see taskgraph_run_async(). */
+  dispatch_queue_t *p_done_queue;
+  struct _dispatch_queue_post_data_t *p_done_post;
+  signal_t done;
+  /* Nodes of the current run that have not completed yet. */
+  CUTILS_CACHE_ALIGNED atomic_uint remaining;
+  atomic_bool running;
+} taskgraph_t;
+
+#define TASKGRAPH_STORE(name) _taskgraph_store_##name
+#define TASKGRAPH_STORE_T(name) taskgraph_store_##name##_t
+
+/** @brief Declares the storage for a graph of up to `max_nodes` nodes and `max_edges` edges. */
+#define TASKGRAPH_STORE_DECL(name, max_nodes, max_edges)                                           \
+  typedef struct {                                                                                 \
+    taskgraph_t graph;                                                                             \
+    taskgraph_node_t nodes[max_nodes];                                                             \
+    taskgraph_edge_t edges[max_edges];                                                             \
+    uint32_t order[max_nodes];                                                                     \
+  } TASKGRAPH_STORE_T(name)
+
+/** @brief Defines the storage declared with TASKGRAPH_STORE_DECL(). */
+#define TASKGRAPH_STORE_DEF(name) TASKGRAPH_STORE_DEF_OWNED(name, MemReportTaskGraph)
+
+/** @brief As above, registering the store with mem_report under an enclosing `owner` kind. */
+#define TASKGRAPH_STORE_DEF_OWNED(name, owner)                                                     \
+  TASKGRAPH_STORE_T(name) TASKGRAPH_STORE(name);                                                   \
+  MEM_REPORT_RECORD(taskgraph_##name,                                                              \
+                    MemReportTaskGraph,                                                            \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(TASKGRAPH_STORE(name)),                                                 \
+                    GetArraySize(TASKGRAPH_STORE(name).nodes),                                     \
+                    sizeof(taskgraph_node_t))
+
+typedef struct _taskgraph_create_params_t {
+  taskgraph_t *p_graph;
+  taskgraph_node_t *p_nodes;
+  uint32_t max_nodes;
+  taskgraph_edge_t *p_edges;
+  uint32_t max_edges;
+  uint32_t *p_order;
+} taskgraph_create_params_t;
+
+/** @brief Fills in `params` for taskgraph_create() from a named static store. */
+#define TASKGRAPH_CREATE_PARAMS_INIT(params, name)                                                 \
+  memset(&(params), 0, sizeof(params));                                                            \
+  (params).p_graph = &TASKGRAPH_STORE(name).graph;                                                 \
+  (params).p_nodes = TASKGRAPH_STORE(name).nodes;                                                  \
+  (params).max_nodes = GetArraySize(TASKGRAPH_STORE(name).nodes);                                  \
+  (params).p_edges = TASKGRAPH_STORE(name).edges;                                                  \
+  (params).max_edges = GetArraySize(TASKGRAPH_STORE(name).edges);                                  \
+  (params).p_order = TASKGRAPH_STORE(name).order
+
+/**
+ * @brief Creates an empty graph on static storage.
+ * @return - the graph if successful, NULL otherwise
+ */
+taskgraph_t *taskgraph_create(taskgraph_create_params_t *p_params);
+
+/** @brief Releases a graph. It must not be running. */
+void taskgraph_destroy(taskgraph_t *p_graph);
+
+/**
+ * @brief Adds a node that runs `fn(arg1, arg2)` on `p_queue`. The graph must not be running.
+ * @return - the node's id for taskgraph_add_edge(), TASKGRAPH_NODE_INVALID if the graph is full
+ */
+uint32_t taskgraph_add_node(taskgraph_t *p_graph,
+                            dispatch_queue_t *p_queue,
+                            dispatch_function_t fn,
+                            void *arg1,
+                            void *arg2);
+
+/**
+ * @brief Makes node `to` wait for node `from` to complete. The graph must not be running.
+ * @return - false if the graph has no room for another edge or the ids are not valid
+ */
+bool taskgraph_add_edge(taskgraph_t *p_graph, uint32_t from, uint32_t to);
+
+/**
+ * @brief Starts a run of the graph and returns. Nodes without predecessors are posted right away.
+ * Once every node has completed, `fn(arg1, arg2)` is posted to `p_queue`, and the graph can be run
+ * again. A run reserves one post record per node on the node's queue, and one for `fn`, before it
+ * starts, so none of its posts can be refused later.
+ * @return - false if the graph is already running, has a cycle, or its queues have too few free
+ * records
+ */
+bool taskgraph_run_async(taskgraph_t *p_graph,
+                         dispatch_queue_t *p_queue,
+                         dispatch_function_t fn,
+                         void *arg1,
+                         void *arg2);
+
+/**
+ * @brief Runs the graph and waits for every node to complete. Must not be called from the worker of
+ * a queue one of the nodes runs on, or the graph cannot complete. Reserves records like
+ * taskgraph_run_async(). The graph counts as running until this returns, so another run cannot
+ * start in between and take this run's completion for its own.
+ * @return - false if the graph is already running, has a cycle, or its queues have too few free
+ * records
+ */
+bool taskgraph_run(taskgraph_t *p_graph);
+
+#ifdef __cplusplus
+}
+#endif
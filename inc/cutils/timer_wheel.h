@@ -0,0 +1,222 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cutils/event_flag.h>
+#include <cutils/handle_table.h>
+#include <cutils/klist.h>
+#include <cutils/mem_report.h>
+#include <cutils/mutex.h>
+#include <cutils/os_types.h>
+#include <cutils/pool.h>
+#include <cutils/task.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A hierarchical timing wheel serviced by a single task. Timers post their action to a
+ * dispatch queue with dispatch_async_f() when they expire, so the callback runs on the target
+ * queue. The task takes the due timers off the wheel under its lock and posts them after dropping
+ * it, so the overflow policy of a full target queue never holds up arming or cancelling timers.
+ * Expiries a queue refuses are counted in `refused` and logged.
+ *
+ * The wheel has TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots. Level 0 slots are one tick
+ * (CUTILS_TIMER_WHEEL_TICK_MS) wide, and every level above is TIMER_WHEEL_SLOTS times coarser.
+ * A timer is linked into the slot covering its expiry and is moved down a level each time its
+ * slot comes around, so arming and cancelling are O(1) and each tick only touches the timers that
+ * are due. Timers further out than the wheel spans are parked in the top level and re-filed until
+ * they are in range.
+ *
+ * Timer entries come from a static pool sized by TIMER_WHEEL_STORE_DECL(). Clients get a
+ * generational handle instead of the entry, so a stale handle stops resolving once its timer has
+ * fired or been cancelled, and never cancels a timer that reused the entry. The timer task only
+ * wakes for the next due slot or the next cascade, not on every tick.
+ */
+
+#ifndef CUTILS_TIMER_WHEEL_TICK_MS
+#define CUTILS_TIMER_WHEEL_TICK_MS (1)
+#endif
+
+#define TIMER_WHEEL_LEVELS (4)
+#define TIMER_WHEEL_SLOT_BITS (6)
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+/** @brief Handle of an armed timer. */
+typedef handle_t timer_wheel_h;
+
+#define TIMER_WHEEL_INVALID HANDLE_INVALID
+
+typedef struct _timer_wheel_entry_t {
+  KListElem elem;
+  uint32_t expires;
+  uint32_t reload;
+  uint8_t level;
+  uint8_t slot;
+  /* Live while the timer is armed. */
+  timer_wheel_h handle;
+  dispatch_queue_t *p_queue;
+  dispatch_function_t fn;
+  void *arg1;
+  void *arg2;
+} timer_wheel_entry_t;
+
+/** @brief An expiry taken off the wheel, posted once the wheel lock is dropped. */
+typedef struct _timer_wheel_fire_t {
+  /* The handle of a repeating timer, checked again before posting. TIMER_WHEEL_INVALID for a one
+   * shot timer, whose handle is released when it fires. */
+  timer_wheel_h handle;
+  dispatch_queue_t *p_queue;
+  dispatch_function_t fn;
+  void *arg1;
+  void *arg2;
+} timer_wheel_fire_t;
+
+typedef struct _timer_wheel_t {
+  KListHead *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  /* One bit per non-empty slot, used to find the next wake up without scanning slots. */
+  uint64_t occupied[TIMER_WHEEL_LEVELS];
+  /* Last tick processed, and the millisecond clock reading it corresponds to. */
+  uint32_t now;
+  uint32_t now_ms;
+  /* Tick the timer task is sleeping until. Only meaningful while `sleeping` is set. */
+  uint32_t wake_tick;
+  bool sleeping;
+  uint32_t count;
+  pool_t *p_pool;
+  handle_table_t *p_handles;
+  /* Expiries collected under the lock by the timer task, one per timer at most per tick. */
+  timer_wheel_fire_t *p_fired;
+  uint32_t max_fired;
+  uint32_t num_fired;
+  /* The repeating timer whose expiry the task is posting, TIMER_WHEEL_INVALID otherwise. */
+  timer_wheel_h posting;
+  /* Expiries the target queue refused to take. */
+  atomic_uint refused;
+  task_t *p_task;
+  mutex_t mtx;
+  event_flag_t flags;
+  atomic_bool destroying;
+} timer_wheel_t;
+
+#define TIMER_WHEEL_STORE(name) _timer_wheel_store_##name
+#define TIMER_WHEEL_STORE_T(name) timer_wheel_store_##name##_t
+
+/**
+ * @brief Declares the storage for a timer wheel with up to `max_timers` timers armed at once.
+ * `max_timers` must be a power of 2.
+ */
+#define TIMER_WHEEL_STORE_DECL(name, max_timers, stack_size)                                       \
+  TASK_STATIC_STORE_DECL(timer_wheel_##name, stack_size);                                          \
+  POOL_STORE_DECL(timer_wheel_##name, max_timers, sizeof(timer_wheel_entry_t), alignof(void *));   \
+  HANDLE_TABLE_STORE_DECL(timer_wheel_##name, max_timers);                                         \
+  typedef struct {                                                                                 \
+    timer_wheel_t wheel;                                                                           \
+    timer_wheel_fire_t fired[max_timers];                                                          \
+  } TIMER_WHEEL_STORE_T(name)
+
+/** @brief Defines the storage declared with TIMER_WHEEL_STORE_DECL(). */
+#define TIMER_WHEEL_STORE_DEF(name) TIMER_WHEEL_STORE_DEF_OWNED(name, MemReportTimerWheel)
+
+/** @brief As above, registering the store with mem_report under an enclosing `owner` kind. */
+#define TIMER_WHEEL_STORE_DEF_OWNED(name, owner)                                                   \
+  TIMER_WHEEL_STORE_T(name) TIMER_WHEEL_STORE(name);                                               \
+  TASK_STATIC_STORE_DEF_OWNED(timer_wheel_##name, owner);                                          \
+  POOL_STORE_DEF_OWNED(timer_wheel_##name, owner);                                                 \
+  HANDLE_TABLE_STORE_DEF_OWNED(timer_wheel_##name, owner);                                         \
+  MEM_REPORT_RECORD(timer_wheel_##name,                                                            \
+                    MemReportTimerWheel,                                                           \
+                    owner,                                                                         \
+                    #name,                                                                         \
+                    sizeof(TIMER_WHEEL_STORE(name)),                                               \
+                    GetArraySize(POOL_STORE(timer_wheel_##name).elements),                         \
+                    sizeof(timer_wheel_entry_t))
+
+typedef struct _timer_wheel_create_params_t {
+  timer_wheel_t *p_wheel;
+  task_create_params_t task_params;
+  pool_create_params_t pool_params;
+  handle_table_create_params_t handle_params;
+  timer_wheel_fire_t *p_fired;
+  uint32_t max_fired;
+} timer_wheel_create_params_t;
+
+/** @brief Fills in `params` for timer_wheel_create() from a named static store. */
+#define TIMER_WHEEL_CREATE_PARAMS_INIT(params, name, task_name, pri)                               \
+  memset(&(params), 0, sizeof(params));                                                            \
+  (params).p_wheel = &TIMER_WHEEL_STORE(name).wheel;                                               \
+  (params).p_fired = TIMER_WHEEL_STORE(name).fired;                                                \
+  (params).max_fired = GetArraySize(TIMER_WHEEL_STORE(name).fired);                                \
+  TASK_STATIC_INIT_CREATE_PARAMS((params).task_params, timer_wheel_##name, task_name, pri, 0, 0);  \
+  POOL_CREATE_INIT((params).pool_params, timer_wheel_##name);                                      \
+  HANDLE_TABLE_CREATE_PARAMS_INIT((params).handle_params, timer_wheel_##name)
+
+/**
+ * @brief Creates the wheel on static storage and starts its timer task.
+ * @return - the wheel if successful, NULL otherwise
+ */
+timer_wheel_t *timer_wheel_create(timer_wheel_create_params_t *p_params);
+
+/**
+ * @brief Stops the timer task and releases the wheel. Timers still armed are dropped without
+ * firing.
+ */
+void timer_wheel_destroy(timer_wheel_t *p_wheel);
+
+/**
+ * @brief Arms a timer that posts `fn(arg1, arg2)` to `p_queue` after `delay_ms`, and then every
+ * `reload_ms` if `reload_ms` is non-zero. Delays are rounded up to whole ticks.
+ * @return - a handle for timer_wheel_cancel(), TIMER_WHEEL_INVALID if the wheel has no free
+ * timers. The handle of a one shot timer stops resolving once the timer fires.
+ */
+timer_wheel_h timer_wheel_arm(timer_wheel_t *p_wheel,
+                              dispatch_queue_t *p_queue,
+                              uint32_t delay_ms,
+                              uint32_t reload_ms,
+                              dispatch_function_t fn,
+                              void *arg1,
+                              void *arg2);
+
+/**
+ * @brief Disarms a timer and releases its entry. Once this returns the timer posts nothing more,
+ * though an action it posted just before may still be pending on the target queue. If the timer
+ * task is posting an expiry of this timer at that moment, this waits for the post to complete, so
+ * do not call it from an item of the target queue when that queue's overflow policy blocks.
+ * @return - true if the timer was armed. A stale handle returns false and touches nothing.
+ */
+bool timer_wheel_cancel(timer_wheel_t *p_wheel, timer_wheel_h h_timer);
+
+/**
+ * @brief The process wide wheel behind dispatch_after_f() and dispatch_start_repeated_f(). It is
+ * created on first use, with room for CUTILS_SYSTEM_TIMERS timers.
+ */
+timer_wheel_t *timer_wheel_system_get(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -31,6 +31,9 @@ extern "C" {
 #include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
+#ifndef __cplusplus
+#include <stdalign.h>
+#endif
 
 #define GetArraySize(x) ((sizeof((x))) / (sizeof((x)[0])))
 
@@ -41,6 +44,16 @@ extern "C" {
 #ifndef MAX
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #endif
+
+/**
+ * Granularity used to keep fields that are written by different threads on separate cache lines.
+ * Set through the CUTILS_CACHE_LINE_SIZE cmake cache variable. A value of 0 turns the padding off,
+ * since a zero alignment specifier has no effect.
+ */
+#ifndef CUTILS_CACHE_LINE_SIZE
+#define CUTILS_CACHE_LINE_SIZE (64)
+#endif
+#define CUTILS_CACHE_ALIGNED alignas(CUTILS_CACHE_LINE_SIZE)
 #ifndef CUTILS_ASSERT
 #define CUTILS_ASSERT(x)                                                                           \
   {                                                                                                \
@@ -28,11 +28,18 @@
 #include <string.h>
 
 #define TASK_SANITY (0xDEADBEEF)
+/* Linux caps thread names at 16 bytes, terminator included. */
+#define TASK_OS_NAME_MAX (16)
 static _Thread_local task_t *s_current_task = NULL;
 
 static int thread_runner_f(void *ctx) {
   task_t *p_task = (task_t *)ctx;
   s_current_task = p_task;
+#ifdef CUTILS_HAVE_PTHREAD_NP
+  char name[TASK_OS_NAME_MAX] = {0};
+  strncpy(name, p_task->label, sizeof(name) - 1);
+  pthread_setname_np(thrd_current(), name);
+#endif
   p_task->func(p_task->ctx);
   s_current_task = NULL;
   return 0;
@@ -46,19 +53,31 @@ task_t *task_new_static(task_create_params_t *create_params) {
     memset(create_params->task, 0, sizeof(task_t));
     create_params->task->func = create_params->func;
     create_params->task->ctx = create_params->ctx;
+    // The new thread reads its label straight away, to name itself.
+    strncpy(
+        create_params->task->label, create_params->label, sizeof(create_params->task->label) - 1);
+    create_params->task->sanity = TASK_SANITY;
+    static const int s_policies[] = {
+        [TASK_SCHED_DEFAULT] = -1,
+        [TASK_SCHED_OTHER] = SCHED_OTHER,
+        [TASK_SCHED_FIFO] = SCHED_FIFO,
+        [TASK_SCHED_RR] = SCHED_RR,
+    };
+    CUTILS_ASSERT(create_params->sched_policy <= TASK_SCHED_RR);
     int r = thrd_create_ex(&create_params->task->task,
                            thread_runner_f,
                            create_params->task,
                            create_params->label,
+                           s_policies[create_params->sched_policy],
                            create_params->priority,
+                           create_params->affinity,
                            create_params->stack,
                            create_params->stack_size);
-
-    strncpy(
-        create_params->task->label, create_params->label, sizeof(create_params->task->label) - 1);
-    create_params->task->sanity = TASK_SANITY;
-    // TODO: Add an assertion
-    retval = (r == 0) ? create_params->task : 0;
+    if (r == thrd_success) {
+      retval = create_params->task;
+    } else {
+      create_params->task->sanity = 0;
+    }
   }
   return retval;
 }
@@ -74,17 +93,27 @@ bool task_start(task_t *task) {
   return true;
 }
 
+bool task_is_current(task_t *task) { return task && thrd_equal(thrd_current(), task->task); }
+
 cutils_ticks_t task_get_ticks(void) {
   struct timespec res = {0};
   clock_gettime(CLOCK_REALTIME, &res);
   return res.tv_sec * 1000000000 + res.tv_nsec;
 }
 
+uint32_t task_get_ms(void) {
+  struct timespec res = {0};
+  clock_gettime(CLOCK_MONOTONIC, &res);
+  return (uint32_t)((uint64_t)res.tv_sec * 1000 + res.tv_nsec / 1000000);
+}
+
 void task_sleep(uint32_t ms) {
   struct timespec duration = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000};
   thrd_sleep(&duration, 0);
 }
 
+void task_yield(void) { thrd_yield(); }
+
 void task_get_current_name(char *name, size_t string_len) {
   task_t *current = s_current_task;
   if (current && current->sanity == TASK_SANITY) {
@@ -22,19 +22,418 @@
  * THE SOFTWARE.
  */
 
+#if defined(CUTILS_HAVE_DLADDR) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <cutils/dispatch_queue.h>
+#include <cutils/logger.h>
+#include <cutils/timer_wheel.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef CUTILS_HAVE_DLADDR
+#include <dlfcn.h>
+#endif
 
-static void dispatch_queue_worker(void *ctx) {
-  dispatch_queue_t *p_queue = (dispatch_queue_t *)ctx;
-  while (1) {
-    dispatch_queue_post_data_t *p_data = 0;
-    CUTILS_ASSERT(ts_queue_dequeue(p_queue->queue, (void **)&p_data, WAIT_FOREVER));
+static void dispatch_profile_record(dispatch_profile_t *p_profile,
+                                    dispatch_function_t fn,
+                                    cutils_ticks_t posted_at,
+                                    cutils_ticks_t start,
+                                    cutils_ticks_t end);
+
+/**
+ * Takes a cancellable item off the table for dispatch_cancel(). Returns false if it had been
+ * cancelled. Either way the generation moves on to the next even value, which makes every token
+ * issued for the item stale.
+ */
+static bool dispatch_work_claim(dispatch_queue_post_data_t *p_data) {
+  unsigned int seq = atomic_load(&p_data->seq);
+  bool retval = !(seq & 1) && atomic_compare_exchange_strong(&p_data->seq, &seq, seq + 2);
+  if (!retval) {
+    atomic_store(&p_data->seq, seq + 1);
+  }
+  return retval;
+}
+
+/** Runs `fn` on a worker, timing it if the queue is profiled. */
+static inline void dispatch_queue_run_fn(dispatch_queue_t *p_queue,
+                                         dispatch_function_t fn,
+                                         void *arg1,
+                                         void *arg2,
+                                         cutils_ticks_t posted_at) {
+  dispatch_profile_t *p_profile = atomic_load_explicit(&p_queue->p_profile, memory_order_relaxed);
+  if (p_profile) {
+    cutils_ticks_t start = task_get_ticks();
+    fn(arg1, arg2);
+    dispatch_profile_record(p_profile, fn, posted_at, start, task_get_ticks());
+  } else {
+    fn(arg1, arg2);
+  }
+}
+
+/** Runs a queued item on a worker, unless it has been cancelled. */
+static inline void dispatch_queue_run_item(dispatch_queue_t *p_queue,
+                                           dispatch_queue_post_data_t *p_data) {
+  if ((p_data->flags & DISPATCH_POST_FLAG_CANCELLABLE) && !dispatch_work_claim(p_data)) {
+    atomic_fetch_add_explicit(&p_queue->cancelled, 1, memory_order_relaxed);
+    return;
+  }
+  dispatch_queue_run_fn(p_queue, p_data->fn, p_data->arg1, p_data->arg2, p_data->posted_at);
+}
+
+/** An item a worker posted to its own queue, see dispatch_queue_post_local(). */
+typedef struct {
+  dispatch_function_t fn;
+  void *arg1;
+  void *arg2;
+  cutils_ticks_t posted_at;
+} dispatch_local_run_t;
+
+/**
+ * The run list of a serial worker. Only the worker touches it, so it needs no synchronisation.
+ * It lives on the worker's stack while a batch runs and is published through the queue's p_local.
+ */
+typedef struct _dispatch_local_runs_t {
+  dispatch_local_run_t runs[DISPATCH_QUEUE_LOCAL_MAX];
+  uint32_t head;
+  uint32_t count;
+  /* Batch items not finished yet plus the local items, all of them counted in `pending`. */
+  uint32_t in_hand;
+} dispatch_local_runs_t;
+
+bool dispatch_queue_post_local(dispatch_queue_t *p_queue,
+                               dispatch_function_t fn,
+                               void *arg1,
+                               void *arg2) {
+  bool retval = false;
+  dispatch_local_runs_t *p_local = atomic_load_explicit(&p_queue->p_local, memory_order_relaxed);
+  // Anything counted in `pending` beyond what the worker holds sits in the shared queue, and the
+  // item must go after it. A post that raced with this check was concurrent with ours anyway.
+  if (p_local && task_is_current(p_queue->p_task) && p_local->count < DISPATCH_QUEUE_LOCAL_MAX &&
+      atomic_load_explicit(&p_queue->pending, memory_order_acquire) == p_local->in_hand) {
+    uint32_t slot = (p_local->head + p_local->count) % DISPATCH_QUEUE_LOCAL_MAX;
+    p_local->runs[slot] = (dispatch_local_run_t){
+        .fn = fn,
+        .arg1 = arg1,
+        .arg2 = arg2,
+        .posted_at =
+            atomic_load_explicit(&p_queue->p_profile, memory_order_relaxed) ? task_get_ticks() : 0,
+    };
+    p_local->count++;
+    p_local->in_hand++;
+    atomic_fetch_add_explicit(&p_queue->pending, 1, memory_order_relaxed);
+    retval = true;
+  }
+  return retval;
+}
+
+/**
+ * Runs one batch in posting order, then whatever the batch posted to the local run list. Returns
+ * true once the kill request has been reached.
+ */
+static bool dispatch_queue_drain_fifo(dispatch_queue_t *p_queue) {
+  dispatch_queue_post_data_t *batch[DISPATCH_QUEUE_BATCH_MAX];
+  dispatch_local_runs_t local = {0};
+  bool exit = false;
+  size_t count =
+      ts_queue_dequeue_batch(p_queue->queue, (void **)batch, p_queue->batch_max, WAIT_FOREVER);
+  CUTILS_ASSERT(count);
+  for (size_t i = 0; i < count; i++) {
+    local.in_hand += (void *)batch[i] != (void *)p_queue;
+  }
+  size_t ran = 0;
+  mutex_lock(&p_queue->exec_mtx, WAIT_FOREVER);
+  atomic_store_explicit(&p_queue->p_local, &local, memory_order_relaxed);
+  for (; ran < count; ran++) {
+    dispatch_queue_post_data_t *p_data = batch[ran];
     if ((void *)p_data == (void *)p_queue) {
       // Kill Request
+      exit = true;
+      break;
+    }
+    dispatch_queue_run_item(p_queue, p_data);
+    local.in_hand--;
+    atomic_fetch_sub_explicit(&p_queue->pending, 1, memory_order_release);
+    if (p_data->p_group) {
+      dispatch_group_leave(p_data->p_group);
+    }
+  }
+  // Items run from here may post more, which join the end of the list.
+  while (local.count) {
+    dispatch_local_run_t run = local.runs[local.head];
+    local.head = (local.head + 1) % DISPATCH_QUEUE_LOCAL_MAX;
+    local.count--;
+    dispatch_queue_run_fn(p_queue, run.fn, run.arg1, run.arg2, run.posted_at);
+    local.in_hand--;
+    atomic_fetch_sub_explicit(&p_queue->pending, 1, memory_order_release);
+  }
+  atomic_store_explicit(&p_queue->p_local, NULL, memory_order_relaxed);
+  mutex_unlock(&p_queue->exec_mtx);
+  pool_free_batch(p_queue->p_pool, (void **)batch, ran);
+  return exit;
+}
+
+/** Items a serial worker has taken off its queue but not run yet, one FIFO per QoS class. */
+typedef struct {
+  dispatch_queue_post_data_t *p_head[DISPATCH_QOS_COUNT];
+  dispatch_queue_post_data_t *p_tail[DISPATCH_QOS_COUNT];
+  /* Turns each non-empty lane has been passed over since it last ran. */
+  uint32_t skipped[DISPATCH_QOS_COUNT];
+  uint32_t count;
+  bool exit;
+} dispatch_qos_lanes_t;
+
+/* Lanes are served in index order, highest class first. */
+static const uint8_t s_qos_lane[DISPATCH_QOS_COUNT] = {
+    [DISPATCH_QOS_HIGH] = 0, [DISPATCH_QOS_DEFAULT] = 1, [DISPATCH_QOS_BACKGROUND] = 2};
+
+/** Moves everything queued so far into the lanes, waiting up to `wait_ms` for the first item. */
+static void dispatch_qos_stage(dispatch_queue_t *p_queue,
+                               dispatch_qos_lanes_t *p_lanes,
+                               uint32_t wait_ms) {
+  dispatch_queue_post_data_t *batch[DISPATCH_QUEUE_BATCH_MAX];
+  size_t count = 0;
+  do {
+    count =
+        ts_queue_dequeue_batch(p_queue->queue, (void **)batch, DISPATCH_QUEUE_BATCH_MAX, wait_ms);
+    wait_ms = NO_SLEEP;
+    for (size_t i = 0; i < count; i++) {
+      dispatch_queue_post_data_t *p_data = batch[i];
+      if ((void *)p_data == (void *)p_queue) {
+        // Kill Request, always the last item. Everything staged before it still runs.
+        p_lanes->exit = true;
+      } else {
+        uint8_t lane = s_qos_lane[DISPATCH_POST_QOS(p_data->flags)];
+        p_data->p_next = NULL;
+        if (p_lanes->p_tail[lane]) {
+          p_lanes->p_tail[lane]->p_next = p_data;
+        } else {
+          p_lanes->p_head[lane] = p_data;
+        }
+        p_lanes->p_tail[lane] = p_data;
+        p_lanes->count++;
+      }
+    }
+  } while (count == DISPATCH_QUEUE_BATCH_MAX);
+}
+
+/** Takes the next item: the highest class waiting, unless a lower one has waited too long. */
+static dispatch_queue_post_data_t *dispatch_qos_pick(dispatch_qos_lanes_t *p_lanes) {
+  uint32_t lane = 0;
+  while (!p_lanes->p_head[lane]) {
+    lane++;
+  }
+  for (uint32_t i = lane + 1; i < DISPATCH_QOS_COUNT; i++) {
+    if (p_lanes->p_head[i] && p_lanes->skipped[i] >= DISPATCH_QOS_STARVATION_LIMIT) {
+      lane = i;
+      break;
+    }
+  }
+  for (uint32_t i = 0; i < DISPATCH_QOS_COUNT; i++) {
+    p_lanes->skipped[i] = (i != lane && p_lanes->p_head[i]) ? p_lanes->skipped[i] + 1 : 0;
+  }
+  dispatch_queue_post_data_t *retval = p_lanes->p_head[lane];
+  p_lanes->p_head[lane] = retval->p_next;
+  if (!p_lanes->p_head[lane]) {
+    p_lanes->p_tail[lane] = NULL;
+  }
+  p_lanes->count--;
+  return retval;
+}
+
+/**
+ * Runs up to a batch of items by QoS class. The queue is polled again after every item, so a new
+ * high priority item waits for at most the item that is running.
+ */
+static void dispatch_queue_drain_qos(dispatch_queue_t *p_queue, dispatch_qos_lanes_t *p_lanes) {
+  dispatch_queue_post_data_t *done[DISPATCH_QUEUE_BATCH_MAX];
+  size_t ran = 0;
+  dispatch_qos_stage(p_queue, p_lanes, p_lanes->count ? NO_SLEEP : WAIT_FOREVER);
+  mutex_lock(&p_queue->exec_mtx, WAIT_FOREVER);
+  while (ran < p_queue->batch_max && p_lanes->count) {
+    dispatch_queue_post_data_t *p_data = dispatch_qos_pick(p_lanes);
+    dispatch_queue_run_item(p_queue, p_data);
+    atomic_fetch_sub_explicit(&p_queue->pending, 1, memory_order_release);
+    if (p_data->p_group) {
+      dispatch_group_leave(p_data->p_group);
+    }
+    done[ran++] = p_data;
+    dispatch_qos_stage(p_queue, p_lanes, NO_SLEEP);
+  }
+  mutex_unlock(&p_queue->exec_mtx);
+  pool_free_batch(p_queue->p_pool, (void **)done, ran);
+}
+
+/** Items an EDF worker has taken off its queue but not run yet, a binary min-heap by deadline. */
+typedef struct {
+  dispatch_queue_post_data_t **pp_items;
+  uint32_t count;
+  /* Stamped on each item as it is taken, so items with equal deadlines keep their order. */
+  uint32_t order;
+  bool exit;
+} dispatch_edf_heap_t;
+
+/** Every record of an EDF queue has its deadline behind it, see DISPATCH_EDF_QUEUE_STORE_DECL(). */
+static inline dispatch_edf_post_data_t *dispatch_edf_of(const dispatch_queue_post_data_t *p_data) {
+  return (dispatch_edf_post_data_t *)p_data;
+}
+
+static inline bool dispatch_edf_before(const dispatch_queue_post_data_t *p_a,
+                                       const dispatch_queue_post_data_t *p_b) {
+  const dispatch_edf_post_data_t *p_edf_a = dispatch_edf_of(p_a);
+  const dispatch_edf_post_data_t *p_edf_b = dispatch_edf_of(p_b);
+  int32_t diff = (int32_t)(p_edf_a->deadline_ms - p_edf_b->deadline_ms);
+  return diff < 0 || (diff == 0 && (int32_t)(p_edf_a->order - p_edf_b->order) < 0);
+}
+
+static void dispatch_edf_push(dispatch_edf_heap_t *p_heap, dispatch_queue_post_data_t *p_data) {
+  uint32_t i = p_heap->count++;
+  while (i && dispatch_edf_before(p_data, p_heap->pp_items[(i - 1) / 2])) {
+    p_heap->pp_items[i] = p_heap->pp_items[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  p_heap->pp_items[i] = p_data;
+}
+
+static dispatch_queue_post_data_t *dispatch_edf_pop(dispatch_edf_heap_t *p_heap) {
+  dispatch_queue_post_data_t *retval = p_heap->pp_items[0];
+  dispatch_queue_post_data_t *p_last = p_heap->pp_items[--p_heap->count];
+  uint32_t i = 0;
+  while (2 * i + 1 < p_heap->count) {
+    uint32_t child = 2 * i + 1;
+    if (child + 1 < p_heap->count &&
+        dispatch_edf_before(p_heap->pp_items[child + 1], p_heap->pp_items[child])) {
+      child++;
+    }
+    if (!dispatch_edf_before(p_heap->pp_items[child], p_last)) {
       break;
+    }
+    p_heap->pp_items[i] = p_heap->pp_items[child];
+    i = child;
+  }
+  p_heap->pp_items[i] = p_last;
+  return retval;
+}
+
+/** Moves everything queued so far into the heap, waiting up to `wait_ms` for the first item. */
+static void dispatch_edf_stage(dispatch_queue_t *p_queue,
+                               dispatch_edf_heap_t *p_heap,
+                               uint32_t wait_ms) {
+  dispatch_queue_post_data_t *batch[DISPATCH_QUEUE_BATCH_MAX];
+  size_t count = 0;
+  do {
+    count =
+        ts_queue_dequeue_batch(p_queue->queue, (void **)batch, DISPATCH_QUEUE_BATCH_MAX, wait_ms);
+    wait_ms = NO_SLEEP;
+    uint32_t now = count ? task_get_ms() : 0;
+    for (size_t i = 0; i < count; i++) {
+      dispatch_queue_post_data_t *p_data = batch[i];
+      if ((void *)p_data == (void *)p_queue) {
+        // Kill Request, always the last item. Everything staged before it still runs.
+        p_heap->exit = true;
+      } else {
+        CUTILS_ASSERT(p_heap->count < p_queue->deadline_heap_size);
+        if (!(p_data->flags & DISPATCH_POST_FLAG_DEADLINE)) {
+          dispatch_edf_of(p_data)->deadline_ms = now;
+        }
+        dispatch_edf_of(p_data)->order = p_heap->order++;
+        dispatch_edf_push(p_heap, p_data);
+      }
+    }
+  } while (count == DISPATCH_QUEUE_BATCH_MAX);
+}
+
+static void dispatch_edf_account(dispatch_queue_t *p_queue, dispatch_queue_post_data_t *p_data) {
+  int32_t lateness = (int32_t)(task_get_ms() - dispatch_edf_of(p_data)->deadline_ms);
+  atomic_fetch_add_explicit(&p_queue->deadlines_ran, 1, memory_order_relaxed);
+  if (lateness > 0) {
+    atomic_fetch_add_explicit(&p_queue->deadlines_missed, 1, memory_order_relaxed);
+    // Only the worker writes the maximum, so a plain compare suffices.
+    if ((uint32_t)lateness >
+        atomic_load_explicit(&p_queue->deadlines_max_lateness, memory_order_relaxed)) {
+      atomic_store_explicit(
+          &p_queue->deadlines_max_lateness, (uint32_t)lateness, memory_order_relaxed);
+    }
+  }
+}
+
+/**
+ * Runs up to a batch of items, earliest deadline first. The queue is polled again after every
+ * item, so a new urgent item waits for at most the item that is running.
+ */
+static void dispatch_queue_drain_edf(dispatch_queue_t *p_queue, dispatch_edf_heap_t *p_heap) {
+  dispatch_queue_post_data_t *done[DISPATCH_QUEUE_BATCH_MAX];
+  size_t ran = 0;
+  dispatch_edf_stage(p_queue, p_heap, p_heap->count ? NO_SLEEP : WAIT_FOREVER);
+  mutex_lock(&p_queue->exec_mtx, WAIT_FOREVER);
+  while (ran < p_queue->batch_max && p_heap->count) {
+    dispatch_queue_post_data_t *p_data = dispatch_edf_pop(p_heap);
+    dispatch_queue_run_item(p_queue, p_data);
+    if (p_data->flags & DISPATCH_POST_FLAG_DEADLINE) {
+      dispatch_edf_account(p_queue, p_data);
+    }
+    atomic_fetch_sub_explicit(&p_queue->pending, 1, memory_order_release);
+    if (p_data->p_group) {
+      dispatch_group_leave(p_data->p_group);
+    }
+    done[ran++] = p_data;
+    dispatch_edf_stage(p_queue, p_heap, NO_SLEEP);
+  }
+  mutex_unlock(&p_queue->exec_mtx);
+  pool_free_batch(p_queue->p_pool, (void **)done, ran);
+}
+
+/** Tells whether the worker has something to take off its queue, the kill request included. */
+static inline bool dispatch_queue_ready(dispatch_queue_t *p_queue) {
+  return atomic_load_explicit(&p_queue->pending, memory_order_acquire) ||
+         atomic_load_explicit(&p_queue->destroying, memory_order_relaxed);
+}
+
+/**
+ * Spins until something is posted or the poll budget runs out, so the post that ends the wait
+ * does not have to wake the worker. Only called with nothing staged, since `pending` counts staged
+ * items. The budget is read on every check, so a new one applies to a worker that is polling.
+ */
+static void dispatch_queue_poll(dispatch_queue_t *p_queue) {
+  cutils_ticks_t budget = atomic_load_explicit(&p_queue->poll_budget, memory_order_relaxed);
+  if (budget && !dispatch_queue_ready(p_queue)) {
+    cutils_ticks_t start = task_get_ticks();
+    cutils_ticks_t now = start;
+    bool ready = false;
+    for (uint32_t spins = 1; !ready && (budget == DISPATCH_POLL_FOREVER || now - start < budget);
+         spins++) {
+      if (!(spins % DISPATCH_POLL_YIELD_SPINS)) {
+        task_yield();
+      }
+      ready = dispatch_queue_ready(p_queue);
+      now = task_get_ticks();
+      budget = atomic_load_explicit(&p_queue->poll_budget, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&p_queue->poll_spent, now - start, memory_order_relaxed);
+    atomic_fetch_add_explicit(
+        ready ? &p_queue->poll_hits : &p_queue->poll_misses, 1, memory_order_relaxed);
+  }
+}
+
+static void dispatch_queue_worker(void *ctx) {
+  dispatch_queue_t *p_queue = (dispatch_queue_t *)ctx;
+  dispatch_qos_lanes_t lanes = {0};
+  dispatch_edf_heap_t heap = {.pp_items = p_queue->pp_deadline_heap};
+  bool exit = false;
+  while (!exit) {
+    if (!heap.count && !lanes.count) {
+      dispatch_queue_poll(p_queue);
+    }
+    if (heap.pp_items) {
+      dispatch_queue_drain_edf(p_queue, &heap);
+      exit = heap.exit && !heap.count;
+    } else if (atomic_load_explicit(&p_queue->uses_qos, memory_order_relaxed)) {
+      dispatch_queue_drain_qos(p_queue, &lanes);
+      exit = lanes.exit && !lanes.count;
     } else {
-      p_data->fn(p_data->arg1, p_data->arg2);
-      pool_free(p_queue->p_pool, p_data);
+      // Queues that never see a QoS post keep the plain batch path.
+      exit = dispatch_queue_drain_fifo(p_queue);
     }
   }
   signal_send(&p_queue->signal);
@@ -50,6 +449,8 @@ dispatch_queue_t *dispatch_queue_create(dispatch_queue_create_params_t *params)
   memset(params->p_queue, 0, sizeof(dispatch_queue_t));
 
   CUTILS_ASSERTF(signal_new(&params->p_queue->signal), "Couldn't create exit signal");
+  CUTILS_ASSERTF(mutex_new(&params->p_queue->exec_mtx), "Couldn't create execution mutex");
+  atomic_init(&params->p_queue->pending, 0);
 
   params->p_queue->queue = ts_queue_init(&params->queue_params);
   CUTILS_ASSERTF(params->p_queue->queue, "Couldn't create thread safe queue");
@@ -58,6 +459,15 @@ dispatch_queue_t *dispatch_queue_create(dispatch_queue_create_params_t *params)
   CUTILS_ASSERTF(params->p_queue->p_pool, "Unable to create pool");
 
   params->p_queue->label = params->task_params.label;
+  params->p_queue->pp_deadline_heap = params->pp_deadline_heap;
+  params->p_queue->deadline_heap_size = params->deadline_heap_size;
+  atomic_init(&params->p_queue->poll_budget, params->poll_budget);
+  CUTILS_ASSERTF(
+      !params->pp_deadline_heap || params->deadline_heap_size >= params->queue_params.size,
+      "The deadline heap needs room for every queued item");
+  params->p_queue->batch_max = (params->batch_max && params->batch_max < DISPATCH_QUEUE_BATCH_MAX)
+                                   ? params->batch_max
+                                   : DISPATCH_QUEUE_BATCH_MAX;
   atomic_init(&params->p_queue->destroying, false);
   params->task_params.func = dispatch_queue_worker;
   params->task_params.ctx = params->p_queue;
@@ -70,8 +480,446 @@ dispatch_queue_t *dispatch_queue_create(dispatch_queue_create_params_t *params)
   return retval;
 }
 
+#define DISPATCH_WORKER_FLAG_WAKE (1 << 0)
+#define DISPATCH_WORKER_FLAG_EXITED (1 << 1)
+
+static bool dispatch_worker_push(dispatch_worker_t *p_worker, dispatch_queue_post_data_t *p_data) {
+  bool retval = false;
+  mutex_lock(&p_worker->mtx, WAIT_FOREVER);
+  if (p_worker->bottom - p_worker->top <= p_worker->mask) {
+    p_worker->pp_items[p_worker->bottom++ & p_worker->mask] = p_data;
+    retval = true;
+  }
+  mutex_unlock(&p_worker->mtx);
+  return retval;
+}
+
+/** The owner takes the oldest item so its own posts stay in order. */
+static dispatch_queue_post_data_t *dispatch_worker_take(dispatch_worker_t *p_worker) {
+  dispatch_queue_post_data_t *retval = 0;
+  mutex_lock(&p_worker->mtx, WAIT_FOREVER);
+  if (p_worker->bottom != p_worker->top) {
+    retval = p_worker->pp_items[p_worker->top++ & p_worker->mask];
+  }
+  mutex_unlock(&p_worker->mtx);
+  return retval;
+}
+
+/** Thieves take from the other end, away from the items the owner is about to run. */
+static dispatch_queue_post_data_t *dispatch_worker_steal(dispatch_worker_t *p_worker) {
+  dispatch_queue_post_data_t *retval = 0;
+  if (mutex_lock(&p_worker->mtx, NO_SLEEP)) {
+    if (p_worker->bottom != p_worker->top) {
+      retval = p_worker->pp_items[--p_worker->bottom & p_worker->mask];
+    }
+    mutex_unlock(&p_worker->mtx);
+  }
+  return retval;
+}
+
+static dispatch_queue_post_data_t *dispatch_worker_find(dispatch_worker_t *p_worker,
+                                                        bool wait_for_locks) {
+  dispatch_workers_t *p_workers = p_worker->p_queue->p_workers;
+  dispatch_queue_post_data_t *retval = dispatch_worker_take(p_worker);
+  for (uint32_t i = 1; !retval && i < p_workers->num_workers; i++) {
+    dispatch_worker_t *p_victim =
+        &p_workers->p_workers[(p_worker->index + i) % p_workers->num_workers];
+    retval = wait_for_locks ? dispatch_worker_take(p_victim) : dispatch_worker_steal(p_victim);
+  }
+  return retval;
+}
+
+static bool dispatch_workers_held_empty(dispatch_workers_t *p_workers) {
+  mutex_lock(&p_workers->gate_mtx, WAIT_FOREVER);
+  bool retval = (p_workers->held_head == p_workers->held_tail);
+  mutex_unlock(&p_workers->gate_mtx);
+  return retval;
+}
+
+static void dispatch_workers_push_any(dispatch_workers_t *p_workers,
+                                      dispatch_queue_post_data_t *p_data);
+
+/**
+ * Releases held items, in order, for as long as the gate allows: a barrier only once nothing is in
+ * flight, and ordinary items only while no barrier runs. Called with the gate held.
+ */
+static void dispatch_workers_advance(dispatch_workers_t *p_workers) {
+  while (p_workers->held_head != p_workers->held_tail) {
+    dispatch_queue_post_data_t *p_data =
+        p_workers->pp_held[p_workers->held_head & p_workers->held_mask];
+    if (p_data->flags & DISPATCH_POST_FLAG_BARRIER) {
+      if (p_workers->barrier_running || atomic_load(&p_workers->inflight)) {
+        break;
+      }
+      p_workers->barrier_running = true;
+    } else if (p_workers->barrier_running) {
+      break;
+    }
+    p_workers->held_head++;
+    atomic_fetch_add(&p_workers->inflight, 1);
+    dispatch_workers_push_any(p_workers, p_data);
+  }
+}
+
+/** Accounts for a finished item, opening the gate behind it if that is what it was waiting on. */
+static void dispatch_workers_complete(dispatch_workers_t *p_workers, uint32_t flags) {
+  if (flags & DISPATCH_POST_FLAG_BARRIER) {
+    mutex_lock(&p_workers->gate_mtx, WAIT_FOREVER);
+    p_workers->barrier_running = false;
+    atomic_fetch_sub(&p_workers->barriers_pending, 1);
+    atomic_fetch_sub(&p_workers->inflight, 1);
+    dispatch_workers_advance(p_workers);
+    mutex_unlock(&p_workers->gate_mtx);
+  } else if (atomic_fetch_sub(&p_workers->inflight, 1) == 1 &&
+             atomic_load(&p_workers->barriers_pending)) {
+    mutex_lock(&p_workers->gate_mtx, WAIT_FOREVER);
+    dispatch_workers_advance(p_workers);
+    mutex_unlock(&p_workers->gate_mtx);
+  }
+}
+
+/**
+ * Counts an ordinary item as in flight unless a barrier is pending. Pairs with the barrier side,
+ * which bumps barriers_pending before it looks at inflight, so one of the two always sees the
+ * other.
+ */
+static bool dispatch_workers_enter(dispatch_workers_t *p_workers) {
+  bool retval = true;
+  atomic_fetch_add(&p_workers->inflight, 1);
+  if (atomic_load(&p_workers->barriers_pending)) {
+    dispatch_workers_complete(p_workers, 0);
+    retval = false;
+  }
+  return retval;
+}
+
+static void dispatch_concurrent_worker(void *ctx) {
+  dispatch_worker_t *p_worker = (dispatch_worker_t *)ctx;
+  dispatch_queue_t *p_queue = p_worker->p_queue;
+  dispatch_workers_t *p_workers = p_queue->p_workers;
+  const uint32_t bit = 1u << p_worker->index;
+  while (1) {
+    dispatch_queue_post_data_t *p_data = dispatch_worker_find(p_worker, false);
+    if (!p_data) {
+      // Advertise as idle before the final look, so a post that lands after the look is
+      // guaranteed to see the bit and wake us.
+      atomic_fetch_or(&p_workers->idle_mask, bit);
+      p_data = dispatch_worker_find(p_worker, true);
+      if (p_data) {
+        atomic_fetch_and(&p_workers->idle_mask, ~bit);
+      } else if (atomic_load(&p_queue->destroying) && dispatch_workers_held_empty(p_workers)) {
+        break;
+      } else {
+        event_flag_wait(
+            &p_worker->flags, DISPATCH_WORKER_FLAG_WAKE, WAIT_OR_CLEAR, NULL, WAIT_FOREVER);
+        atomic_fetch_and(&p_workers->idle_mask, ~bit);
+        continue;
+      }
+    }
+    uint32_t flags = p_data->flags;
+    dispatch_group_t *p_group = p_data->p_group;
+    dispatch_queue_run_item(p_queue, p_data);
+    pool_free(p_queue->p_pool, p_data);
+    dispatch_workers_complete(p_workers, flags);
+    if (p_group) {
+      dispatch_group_leave(p_group);
+    }
+  }
+  event_flag_send(&p_worker->flags, DISPATCH_WORKER_FLAG_EXITED);
+}
+
+/** Wakes a parked worker, preferring `preferred` if it is one of them. */
+static void dispatch_workers_wake(dispatch_workers_t *p_workers, uint32_t preferred) {
+  uint32_t idle = atomic_load(&p_workers->idle_mask);
+  while (idle) {
+    uint32_t index = (idle & (1u << preferred)) ? preferred : (uint32_t)__builtin_ctz(idle);
+    uint32_t bit = 1u << index;
+    if (atomic_fetch_and(&p_workers->idle_mask, ~bit) & bit) {
+      event_flag_send(&p_workers->p_workers[index].flags, DISPATCH_WORKER_FLAG_WAKE);
+      break;
+    }
+    idle = atomic_load(&p_workers->idle_mask);
+  }
+}
+
+static void dispatch_workers_push_any(dispatch_workers_t *p_workers,
+                                      dispatch_queue_post_data_t *p_data) {
+  bool pushed = false;
+  uint32_t start = atomic_fetch_add_explicit(&p_workers->next, 1, memory_order_relaxed);
+  for (uint32_t i = 0; !pushed && i < p_workers->num_workers; i++) {
+    uint32_t index = (start + i) % p_workers->num_workers;
+    if (dispatch_worker_push(&p_workers->p_workers[index], p_data)) {
+      dispatch_workers_wake(p_workers, index);
+      pushed = true;
+    }
+  }
+  // Each deque can hold every record of the pool, so this cannot fail.
+  CUTILS_ASSERT(pushed);
+}
+
+bool dispatch_workers_post(dispatch_queue_t *p_queue, dispatch_queue_post_data_t *p_data) {
+  bool retval = true;
+  dispatch_workers_t *p_workers = p_queue->p_workers;
+  if (!(p_data->flags & DISPATCH_POST_FLAG_BARRIER) && dispatch_workers_enter(p_workers)) {
+    dispatch_workers_push_any(p_workers, p_data);
+  } else {
+    mutex_lock(&p_workers->gate_mtx, WAIT_FOREVER);
+    if (p_data->flags & DISPATCH_POST_FLAG_BARRIER) {
+      atomic_fetch_add(&p_workers->barriers_pending, 1);
+    }
+    if (p_workers->held_tail - p_workers->held_head <= p_workers->held_mask) {
+      p_workers->pp_held[p_workers->held_tail++ & p_workers->held_mask] = p_data;
+    } else {
+      retval = false;
+    }
+    dispatch_workers_advance(p_workers);
+    mutex_unlock(&p_workers->gate_mtx);
+  }
+  return retval;
+}
+
+dispatch_queue_t *
+dispatch_concurrent_queue_create(dispatch_concurrent_queue_create_params_t *params) {
+  dispatch_queue_t *retval = 0;
+
+  CUTILS_ASSERTF(params, "Provide valid Create Params");
+  CUTILS_ASSERTF(params->p_queue && params->p_workers && params->p_worker_array,
+                 "Control block not provided");
+  CUTILS_ASSERTF(params->num_workers && params->num_workers <= DISPATCH_QUEUE_MAX_WORKERS,
+                 "Require between 1 and %u workers",
+                 DISPATCH_QUEUE_MAX_WORKERS);
+  CUTILS_ASSERTF(params->deque_size && !(params->deque_size & (params->deque_size - 1)),
+                 "Queue size must be a power of 2");
+
+  dispatch_queue_t *p_queue = params->p_queue;
+  dispatch_workers_t *p_workers = params->p_workers;
+  memset(p_queue, 0, sizeof(dispatch_queue_t));
+  memset(p_workers, 0, sizeof(dispatch_workers_t));
+  atomic_init(&p_queue->destroying, false);
+  atomic_init(&p_workers->next, 0);
+  atomic_init(&p_workers->idle_mask, 0);
+  atomic_init(&p_workers->inflight, 0);
+  atomic_init(&p_workers->barriers_pending, 0);
+  CUTILS_ASSERTF(mutex_new(&p_workers->gate_mtx), "Couldn't create gate mutex");
+  p_workers->pp_held = params->pp_held;
+  p_workers->held_mask = params->deque_size - 1;
+  p_queue->p_pool = pool_create(&params->pool_params);
+  CUTILS_ASSERTF(p_queue->p_pool, "Unable to create pool");
+  p_queue->label = params->p_task_params[0].label;
+  p_workers->p_workers = params->p_worker_array;
+  p_workers->num_workers = params->num_workers;
+  p_queue->p_workers = p_workers;
+
+  for (uint32_t i = 0; i < params->num_workers; i++) {
+    dispatch_worker_t *p_worker = &p_workers->p_workers[i];
+    memset(p_worker, 0, sizeof(dispatch_worker_t));
+    CUTILS_ASSERTF(mutex_new(&p_worker->mtx), "Couldn't create worker mutex");
+    CUTILS_ASSERTF(event_flag_new(&p_worker->flags), "Couldn't create worker flags");
+    p_worker->pp_items = params->pp_deques + (i * params->deque_size);
+    p_worker->mask = params->deque_size - 1;
+    p_worker->p_queue = p_queue;
+    p_worker->index = i;
+  }
+  // Workers steal from each other, so they all have to exist before any of them runs.
+  for (uint32_t i = 0; i < params->num_workers; i++) {
+    dispatch_worker_t *p_worker = &p_workers->p_workers[i];
+    params->p_task_params[i].func = dispatch_concurrent_worker;
+    params->p_task_params[i].ctx = p_worker;
+    p_worker->p_task = task_new_static(&params->p_task_params[i]);
+    CUTILS_ASSERTF(p_worker->p_task, "Couldn't Create Task");
+  }
+  for (uint32_t i = 0; i < params->num_workers; i++) {
+    task_start(p_workers->p_workers[i].p_task);
+  }
+  retval = p_queue;
+
+  return retval;
+}
+
+typedef struct _dispatch_sync_ctx_t {
+  dispatch_function_t fn;
+  void *arg1;
+  void *arg2;
+  signal_t done;
+} dispatch_sync_ctx_t;
+
+static void dispatch_sync_trampoline(void *arg1, void *arg2) {
+  (void)arg2;
+  dispatch_sync_ctx_t *p_ctx = (dispatch_sync_ctx_t *)arg1;
+  p_ctx->fn(p_ctx->arg1, p_ctx->arg2);
+  signal_send(&p_ctx->done);
+}
+
+/** Returns the calling task if it runs items of `p_queue`, NULL otherwise. */
+static task_t *dispatch_queue_current_worker(dispatch_queue_t *p_queue) {
+  task_t *retval = 0;
+  if (p_queue->p_workers) {
+    for (uint32_t i = 0; !retval && i < p_queue->p_workers->num_workers; i++) {
+      task_t *p_task = p_queue->p_workers->p_workers[i].p_task;
+      retval = task_is_current(p_task) ? p_task : NULL;
+    }
+  } else if (p_queue->p_target) {
+    task_t *p_task = atomic_load_explicit(&p_queue->p_drain_task, memory_order_relaxed);
+    retval = (p_task && task_is_current(p_task)) ? p_task : NULL;
+  } else {
+    retval = task_is_current(p_queue->p_task) ? p_queue->p_task : NULL;
+  }
+  return retval;
+}
+
+/**
+ * Posts the drain of a targeted queue through the record it keeps on the target. The queue holds a
+ * reference of its own, so the worker that runs the drain only drops the one taken here. The drain
+ * may repost itself before that worker is done with the record: its fields never change.
+ */
+static void dispatch_targeted_schedule(dispatch_queue_t *p_queue) {
+  pool_retain(p_queue->p_target->p_pool, p_queue->p_drain);
+  CUTILS_ASSERTF(dispatch_queue_post_reserved(p_queue->p_target, p_queue->p_drain),
+                 "Target of %s destroyed before it",
+                 p_queue->label ? p_queue->label : "");
+}
+
+/**
+ * Runs items of a targeted queue on a worker of its target. Only one drain per queue is ever
+ * posted, so the items run one at a time. The exec lock excludes dispatch_sync_f() callers that run
+ * inline.
+ */
+static void dispatch_targeted_drain(void *arg1, void *arg2) {
+  (void)arg2;
+  dispatch_queue_t *p_queue = (dispatch_queue_t *)arg1;
+  bool done = false;
+  mutex_lock(&p_queue->exec_mtx, WAIT_FOREVER);
+  // Only this task can see itself here, so a stale value never matches anyone.
+  atomic_store_explicit(&p_queue->p_drain_task,
+                        dispatch_queue_current_worker(p_queue->p_target),
+                        memory_order_relaxed);
+  for (uint32_t i = 0; !done && i < p_queue->batch_max; i++) {
+    dispatch_queue_post_data_t *p_data = 0;
+    // Items are counted in `pending` only once they are queued, so this cannot come up empty.
+    CUTILS_ASSERT(ts_queue_dequeue(p_queue->queue, (void **)&p_data, NO_SLEEP));
+    dispatch_group_t *p_group = p_data->p_group;
+    dispatch_queue_run_item(p_queue, p_data);
+    pool_free(p_queue->p_pool, p_data);
+    if (p_group) {
+      dispatch_group_leave(p_group);
+    }
+    done = (atomic_fetch_sub_explicit(&p_queue->pending, 1, memory_order_acq_rel) == 1);
+  }
+  atomic_store_explicit(&p_queue->p_drain_task, NULL, memory_order_relaxed);
+  mutex_unlock(&p_queue->exec_mtx);
+  if (!done) {
+    // Go to the back of the target, so queues sharing it get a turn.
+    dispatch_targeted_schedule(p_queue);
+  }
+}
+
+void dispatch_targeted_post(dispatch_queue_t *p_queue, dispatch_queue_post_data_t *p_data) {
+  CUTILS_ASSERT(ts_queue_enqueue(p_queue->queue, p_data, NO_SLEEP));
+  if (atomic_fetch_add_explicit(&p_queue->pending, 1, memory_order_acq_rel) == 0) {
+    dispatch_targeted_schedule(p_queue);
+  }
+}
+
+dispatch_queue_t *
+dispatch_targeted_queue_create(dispatch_targeted_queue_create_params_t *params) {
+  dispatch_queue_t *retval = 0;
+
+  CUTILS_ASSERTF(params, "Provide valid Create Params");
+  CUTILS_ASSERTF(params->p_queue, "Control block not provided");
+  CUTILS_ASSERTF(params->p_target, "Target queue not provided");
+
+  dispatch_queue_t *p_queue = params->p_queue;
+  dispatch_queue_post_data_t *p_drain =
+      dispatch_queue_reserve_post(params->p_target, dispatch_targeted_drain, p_queue, NULL);
+  CHECK_RUN(p_drain, return retval, "Target of %s has no record to spare", params->label);
+  memset(p_queue, 0, sizeof(dispatch_queue_t));
+  CUTILS_ASSERTF(mutex_new(&p_queue->exec_mtx), "Couldn't create execution mutex");
+  atomic_init(&p_queue->pending, 0);
+  atomic_init(&p_queue->destroying, false);
+  p_queue->queue = ts_queue_init(&params->queue_params);
+  CUTILS_ASSERTF(p_queue->queue, "Couldn't create thread safe queue");
+  p_queue->p_pool = pool_create(&params->pool_params);
+  CUTILS_ASSERTF(p_queue->p_pool, "Unable to create pool");
+  p_queue->label = params->label;
+  p_queue->p_target = params->p_target;
+  p_queue->p_drain = p_drain;
+  p_queue->batch_max = (params->batch_max && params->batch_max < DISPATCH_QUEUE_BATCH_MAX)
+                           ? params->batch_max
+                           : DISPATCH_QUEUE_BATCH_MAX;
+  retval = p_queue;
+
+  return retval;
+}
+
+static void dispatch_noop(void *arg1, void *arg2) {
+  (void)arg1;
+  (void)arg2;
+}
+
+static void dispatch_targeted_queue_destroy(dispatch_queue_t *p_queue) {
+  // New posts are refused by now. Push a fence behind the last of them, bypassing that check. The
+  // pool may be full of pending items, so wait for the drain to hand a record back.
+  dispatch_sync_ctx_t fence = {.fn = dispatch_noop};
+  CUTILS_ASSERTF(signal_new(&fence.done), "Couldn't create completion signal");
+  dispatch_queue_post_data_t *p_data =
+      pool_alloc_blocking(p_queue->p_pool, WAIT_FOREVER, NULL, NULL);
+  CUTILS_ASSERT(p_data);
+  // Field by field, since the record's generation must survive for dispatch_cancel().
+  p_data->fn = dispatch_sync_trampoline;
+  p_data->arg1 = &fence;
+  p_data->arg2 = NULL;
+  p_data->flags = DISPATCH_POST_FLAG_NO_DROP;
+  p_data->p_group = NULL;
+  dispatch_queue_post_submit(p_queue, p_data);
+  signal_wait(&fence.done);
+  signal_free(&fence.done);
+  // The drain that ran the fence still holds the exec lock while it retires it.
+  mutex_lock(&p_queue->exec_mtx, WAIT_FOREVER);
+  mutex_unlock(&p_queue->exec_mtx);
+  pool_destroy(p_queue->p_pool);
+  p_queue->p_pool = 0;
+  ts_queue_destroy(p_queue->queue);
+  p_queue->queue = 0;
+  mutex_free(&p_queue->exec_mtx);
+  // The worker that ran the last drain may still hold its reference, and returns the record then.
+  dispatch_queue_unreserve(p_queue->p_target, p_queue->p_drain);
+  p_queue->p_drain = 0;
+}
+
+static void dispatch_concurrent_queue_destroy(dispatch_queue_t *p_queue) {
+  dispatch_workers_t *p_workers = p_queue->p_workers;
+  // Workers drain what is pending and exit instead of parking once they see `destroying`.
+  for (uint32_t i = 0; i < p_workers->num_workers; i++) {
+    event_flag_send(&p_workers->p_workers[i].flags, DISPATCH_WORKER_FLAG_WAKE);
+  }
+  for (uint32_t i = 0; i < p_workers->num_workers; i++) {
+    dispatch_worker_t *p_worker = &p_workers->p_workers[i];
+    CUTILS_ASSERTF(event_flag_wait(&p_worker->flags,
+                                   DISPATCH_WORKER_FLAG_EXITED,
+                                   WAIT_OR_CLEAR,
+                                   NULL,
+                                   WAIT_FOREVER),
+                   "Failed to wait on worker exit");
+    task_destroy_static(p_worker->p_task);
+    p_worker->p_task = 0;
+    mutex_free(&p_worker->mtx);
+    event_flag_free(&p_worker->flags);
+  }
+  mutex_free(&p_workers->gate_mtx);
+  pool_destroy(p_queue->p_pool);
+  p_queue->p_pool = 0;
+}
+
 void dispatch_queue_destroy(dispatch_queue_t *p_queue) {
-  if (p_queue && !atomic_flag_test_and_set(&p_queue->destroying)) {
+  if (p_queue && p_queue->p_workers) {
+    if (!atomic_exchange(&p_queue->destroying, true)) {
+      dispatch_concurrent_queue_destroy(p_queue);
+    }
+  } else if (p_queue && p_queue->p_target) {
+    if (!atomic_exchange(&p_queue->destroying, true)) {
+      dispatch_targeted_queue_destroy(p_queue);
+    }
+  } else if (p_queue && !atomic_flag_test_and_set(&p_queue->destroying)) {
     // We use a pointer value that is unacceptable to indicate that we want to kill the thread.
     // The thread worker function will check items popped off the queue and if this pointer value is
     // encountered It will exit the thread
@@ -86,19 +934,728 @@ void dispatch_queue_destroy(dispatch_queue_t *p_queue) {
       p_queue->p_pool = 0;
       ts_queue_destroy(p_queue->queue);
       p_queue->queue = 0;
+      mutex_free(&p_queue->exec_mtx);
       signal_free(&p_queue->signal);
     } else {
       CUTILS_ASSERTF(0, "Failed to wait on exit signal");
     }
   }
 }
-#if 0
-bool dispatch_after_f(dispatch_queue_t *p_queue,
-                      uint32_t delay_ms,
-                      dispatch_function_t fn,
-                      void *arg1,
-                      void *arg2)
-{
+
+void dispatch_queue_set_overflow(dispatch_queue_t *p_queue,
+                                 dispatch_overflow_policy_e policy,
+                                 uint32_t timeout_ms) {
+  CUTILS_ASSERT(p_queue);
+  p_queue->overflow_policy = policy;
+  p_queue->overflow_timeout_ms = timeout_ms;
+}
+
+void dispatch_queue_set_poll(dispatch_queue_t *p_queue, cutils_ticks_t budget) {
+  CUTILS_ASSERTF(p_queue && p_queue->p_task, "Only the worker of a serial queue can poll");
+  atomic_store_explicit(&p_queue->poll_budget, budget, memory_order_relaxed);
+}
+
+void dispatch_queue_get_poll(dispatch_queue_t *p_queue, dispatch_poll_stats_t *p_stats) {
+  CUTILS_ASSERT(p_queue && p_stats);
+  p_stats->spent = atomic_load_explicit(&p_queue->poll_spent, memory_order_relaxed);
+  p_stats->hits = atomic_load_explicit(&p_queue->poll_hits, memory_order_relaxed);
+  p_stats->misses = atomic_load_explicit(&p_queue->poll_misses, memory_order_relaxed);
+}
+
+void dispatch_queue_get_overflow(dispatch_queue_t *p_queue,
+                                 dispatch_queue_overflow_stats_t *p_stats) {
+  CUTILS_ASSERT(p_queue && p_stats);
+  p_stats->rejected = atomic_load_explicit(&p_queue->overflow_rejected, memory_order_relaxed);
+  p_stats->blocked = atomic_load_explicit(&p_queue->overflow_blocked, memory_order_relaxed);
+  p_stats->timed_out = atomic_load_explicit(&p_queue->overflow_timed_out, memory_order_relaxed);
+  p_stats->dropped = atomic_load_explicit(&p_queue->overflow_dropped, memory_order_relaxed);
+  p_stats->ran_inline = atomic_load_explicit(&p_queue->overflow_ran_inline, memory_order_relaxed);
+  p_stats->cancelled = atomic_load_explicit(&p_queue->cancelled, memory_order_relaxed);
+}
+
+/** Retires a queued item that is being discarded, as if it had run. */
+static void dispatch_queue_retire_dropped(dispatch_queue_post_data_t *p_data) {
+  if (p_data->flags & DISPATCH_POST_FLAG_CANCELLABLE) {
+    dispatch_work_claim(p_data);
+  }
+  if (p_data->p_group) {
+    dispatch_group_leave(p_data->p_group);
+  }
+  p_data->p_group = NULL;
+}
+
+/** Whether the head of a serial queue can be discarded to make room. `ctx` is the queue. */
+static bool dispatch_queue_is_droppable(void *p_item, void *ctx) {
+  return p_item != ctx &&
+         !(((dispatch_queue_post_data_t *)p_item)->flags & DISPATCH_POST_FLAG_NO_DROP);
+}
+
+/**
+ * Takes the oldest queued item that nobody waits on, to reuse its record. A serial queue only
+ * gives up its head, and leaves the queue as it is if the head cannot be dropped, so its order
+ * holds. QoS and EDF queues drop nothing, as their worker stages items the queue's head is younger
+ * than. On a concurrent queue, where order does not matter, an item that cannot be dropped goes
+ * back into its deque.
+ */
+static dispatch_queue_post_data_t *dispatch_queue_drop_oldest(dispatch_queue_t *p_queue) {
+  dispatch_queue_post_data_t *retval = 0;
+  if (p_queue->p_workers) {
+    dispatch_workers_t *p_workers = p_queue->p_workers;
+    uint32_t start = atomic_load_explicit(&p_workers->next, memory_order_relaxed);
+    for (uint32_t i = 0; !retval && i < p_workers->num_workers; i++) {
+      uint32_t index = (start + i) % p_workers->num_workers;
+      dispatch_worker_t *p_worker = &p_workers->p_workers[index];
+      dispatch_queue_post_data_t *p_data = dispatch_worker_take(p_worker);
+      if (p_data && (p_data->flags & (DISPATCH_POST_FLAG_NO_DROP | DISPATCH_POST_FLAG_BARRIER))) {
+        // The owner may have parked while the item was out of its deque.
+        CUTILS_ASSERT(dispatch_worker_push(p_worker, p_data));
+        dispatch_workers_wake(p_workers, index);
+      } else if (p_data) {
+        dispatch_workers_complete(p_workers, p_data->flags);
+        retval = p_data;
+      }
+    }
+  } else if (!p_queue->p_target && !p_queue->pp_deadline_heap &&
+             !atomic_load_explicit(&p_queue->uses_qos, memory_order_relaxed)) {
+    if (ts_queue_dequeue_if(
+            p_queue->queue, dispatch_queue_is_droppable, p_queue, (void **)&retval)) {
+      atomic_fetch_sub_explicit(&p_queue->pending, 1, memory_order_release);
+    }
+  }
+  if (retval) {
+    dispatch_queue_retire_dropped(retval);
+  }
+  return retval;
+}
+
+/**
+ * Applies the overflow policy once the pool is exhausted. Returns a record to post with, or NULL
+ * if the post is refused or, when `*p_policy` comes back as DISPATCH_OVERFLOW_RUN_INLINE, has to
+ * run on the caller.
+ */
+static dispatch_queue_post_data_t *dispatch_queue_reserve(dispatch_queue_t *p_queue,
+                                                          dispatch_overflow_policy_e *p_policy,
+                                                          uint32_t timeout_ms) {
+  dispatch_queue_post_data_t *retval = 0;
+  if (*p_policy == DISPATCH_OVERFLOW_DEFAULT) {
+    *p_policy = p_queue->overflow_policy;
+    timeout_ms = p_queue->overflow_timeout_ms;
+  }
+  switch (*p_policy) {
+  case DISPATCH_OVERFLOW_FAIL:
+    atomic_fetch_add_explicit(&p_queue->overflow_rejected, 1, memory_order_relaxed);
+    break;
+  case DISPATCH_OVERFLOW_BLOCK:
+    retval = pool_alloc_blocking(p_queue->p_pool, timeout_ms, NULL, NULL);
+    atomic_fetch_add_explicit(retval ? &p_queue->overflow_blocked : &p_queue->overflow_timed_out,
+                              1,
+                              memory_order_relaxed);
+    break;
+  case DISPATCH_OVERFLOW_DROP_OLDEST:
+    retval = dispatch_queue_drop_oldest(p_queue);
+    atomic_fetch_add_explicit(
+        retval ? &p_queue->overflow_dropped : &p_queue->overflow_rejected, 1, memory_order_relaxed);
+    break;
+  case DISPATCH_OVERFLOW_RUN_INLINE:
+    break;
+  default:
+    CUTILS_ASSERTF(0, "Dispatch queue %s is full", p_queue->label ? p_queue->label : "");
+    break;
+  }
+  return retval;
+}
+
+/**
+ * Runs an item that did not fit on the caller, still excluding the queue's own items. An item of
+ * a serial or targeted queue posting to its own queue already holds the execution lock, so the
+ * new item runs right away, nested in the one that posted it.
+ */
+static bool dispatch_queue_run_inline(
+    dispatch_queue_t *p_queue, dispatch_function_t fn, void *arg1, void *arg2, uint32_t flags) {
+  bool retval = false;
+  if (p_queue->p_workers) {
+    if (!(flags & DISPATCH_POST_FLAG_BARRIER) && dispatch_workers_enter(p_queue->p_workers)) {
+      fn(arg1, arg2);
+      dispatch_workers_complete(p_queue->p_workers, 0);
+      retval = true;
+    }
+  } else if (dispatch_queue_current_worker(p_queue)) {
+    fn(arg1, arg2);
+    retval = true;
+  } else {
+    mutex_lock(&p_queue->exec_mtx, WAIT_FOREVER);
+    fn(arg1, arg2);
+    mutex_unlock(&p_queue->exec_mtx);
+    retval = true;
+  }
+  atomic_fetch_add_explicit(retval ? &p_queue->overflow_ran_inline : &p_queue->overflow_rejected,
+                            1,
+                            memory_order_relaxed);
+  return retval;
+}
+
+/**
+ * Posts one item, falling back on `policy` when the queue is full. The first `copy_len` bytes at
+ * `arg1` are copied into the record, which then passes the copy instead. A cancellable item gets
+ * its token in `p_token` before it is submitted.
+ */
+static bool dispatch_queue_post_item(dispatch_queue_t *p_queue,
+                                     dispatch_function_t fn,
+                                     void *arg1,
+                                     void *arg2,
+                                     uint32_t flags,
+                                     dispatch_group_t *p_group,
+                                     dispatch_overflow_policy_e policy,
+                                     uint32_t timeout_ms,
+                                     uint32_t deadline_ms,
+                                     size_t copy_len,
+                                     dispatch_work_token_t *p_token) {
+  bool retval = false;
+  if (p_queue && !atomic_load(&p_queue->destroying)) {
+    dispatch_queue_post_data_t *p_data = pool_alloc(p_queue->p_pool);
+    if (!p_data) {
+      p_data = dispatch_queue_reserve(p_queue, &policy, timeout_ms);
+    }
+    if (p_data) {
+      p_data->fn = fn;
+      p_data->arg1 = arg1;
+      p_data->arg2 = arg2;
+      p_data->flags = flags;
+      p_data->p_group = p_group;
+      if (p_queue->pp_deadline_heap) {
+        dispatch_edf_of(p_data)->deadline_ms = deadline_ms;
+      }
+      if (copy_len) {
+        p_data->arg1 = (uint8_t *)p_data + DISPATCH_QUEUE_INLINE_OFFSET;
+        memcpy(p_data->arg1, arg1, copy_len);
+      }
+      if (flags & DISPATCH_POST_FLAG_CANCELLABLE) {
+        // Records start out with whatever their storage held, so the generation may need evening.
+        unsigned int seq = atomic_load(&p_data->seq);
+        if (seq & 1) {
+          atomic_store(&p_data->seq, ++seq);
+        }
+        // Taken before the post, as the item may run and its record be reused straight away.
+        *p_token = (dispatch_work_token_t){.p_item = p_data, .seq = seq};
+      }
+      dispatch_queue_post_submit(p_queue, p_data);
+      retval = true;
+    } else if (policy == DISPATCH_OVERFLOW_RUN_INLINE) {
+      // The caller's context outlives an inline run, so no copy is needed.
+      retval = dispatch_queue_run_inline(p_queue, fn, arg1, arg2, flags);
+      if (retval && p_group) {
+        dispatch_group_leave(p_group);
+      }
+    }
+  }
+  return retval;
+}
+
+bool dispatch_queue_post_ex(dispatch_queue_t *p_queue,
+                            dispatch_function_t fn,
+                            void *arg1,
+                            void *arg2,
+                            uint32_t flags,
+                            dispatch_group_t *p_group,
+                            dispatch_overflow_policy_e policy,
+                            uint32_t timeout_ms) {
+  return dispatch_queue_post_item(
+      p_queue, fn, arg1, arg2, flags, p_group, policy, timeout_ms, 0, 0, NULL);
+}
+
+dispatch_queue_post_data_t *dispatch_queue_reserve_post(dispatch_queue_t *p_queue,
+                                                        dispatch_function_t fn,
+                                                        void *arg1,
+                                                        void *arg2) {
+  dispatch_queue_post_data_t *retval = 0;
+  CUTILS_ASSERT(fn);
+  if (p_queue && !atomic_load(&p_queue->destroying)) {
+    retval = pool_alloc(p_queue->p_pool);
+    if (retval) {
+      retval->fn = fn;
+      retval->arg1 = arg1;
+      retval->arg2 = arg2;
+      retval->flags = DISPATCH_POST_FLAG_NO_DROP;
+      retval->p_group = NULL;
+    }
+  }
+  return retval;
+}
+
+bool dispatch_queue_post_reserved(dispatch_queue_t *p_queue, dispatch_queue_post_data_t *p_data) {
+  bool retval = false;
+  CUTILS_ASSERT(p_queue && p_data);
+  if (!atomic_load(&p_queue->destroying)) {
+    // The record has been counted against the pool since it was reserved, so the queue has room.
+    dispatch_queue_post_submit(p_queue, p_data);
+    retval = true;
+  } else {
+    dispatch_queue_unreserve(p_queue, p_data);
+  }
+  return retval;
+}
+
+void dispatch_queue_unreserve(dispatch_queue_t *p_queue, dispatch_queue_post_data_t *p_data) {
+  CUTILS_ASSERT(p_queue && p_data);
+  pool_free(p_queue->p_pool, p_data);
+}
+
+bool dispatch_async_ex(dispatch_queue_t *p_queue,
+                       dispatch_function_t fn,
+                       void *arg1,
+                       void *arg2,
+                       dispatch_overflow_policy_e policy,
+                       uint32_t timeout_ms) {
+  CUTILS_ASSERT(fn);
+  return dispatch_queue_post_ex(p_queue, fn, arg1, arg2, 0, NULL, policy, timeout_ms);
+}
+
+bool dispatch_async_deadline_f(dispatch_queue_t *p_queue,
+                               uint32_t deadline_ms,
+                               dispatch_function_t fn,
+                               void *arg1,
+                               void *arg2) {
+  CUTILS_ASSERT(fn);
+  return dispatch_queue_post_item(p_queue,
+                                  fn,
+                                  arg1,
+                                  arg2,
+                                  DISPATCH_POST_FLAG_DEADLINE,
+                                  NULL,
+                                  DISPATCH_OVERFLOW_DEFAULT,
+                                  0,
+                                  deadline_ms,
+                                  0,
+                                  NULL);
+}
+
+void dispatch_queue_get_deadlines(dispatch_queue_t *p_queue, dispatch_deadline_stats_t *p_stats) {
+  CUTILS_ASSERT(p_queue && p_stats);
+  p_stats->ran = atomic_load_explicit(&p_queue->deadlines_ran, memory_order_relaxed);
+  p_stats->missed = atomic_load_explicit(&p_queue->deadlines_missed, memory_order_relaxed);
+  p_stats->max_lateness_ms =
+      atomic_load_explicit(&p_queue->deadlines_max_lateness, memory_order_relaxed);
+}
+
+bool dispatch_async_cancellable_f(dispatch_queue_t *p_queue,
+                                  dispatch_function_t fn,
+                                  void *arg1,
+                                  void *arg2,
+                                  dispatch_work_token_t *p_token) {
+  CUTILS_ASSERT(fn && p_token);
+  *p_token = DISPATCH_WORK_TOKEN_INVALID;
+  return dispatch_queue_post_item(p_queue,
+                                  fn,
+                                  arg1,
+                                  arg2,
+                                  DISPATCH_POST_FLAG_CANCELLABLE,
+                                  NULL,
+                                  DISPATCH_OVERFLOW_DEFAULT,
+                                  0,
+                                  0,
+                                  0,
+                                  p_token);
+}
+
+bool dispatch_profile_new(dispatch_profile_t *p_profile) {
+  CUTILS_ASSERT(p_profile);
+  memset(p_profile, 0, sizeof(*p_profile));
+  return mutex_new(&p_profile->mtx);
+}
+
+void dispatch_profile_free(dispatch_profile_t *p_profile) {
+  CUTILS_ASSERT(p_profile);
+  mutex_free(&p_profile->mtx);
+}
+
+void dispatch_profile_reset(dispatch_profile_t *p_profile) {
+  CUTILS_ASSERT(p_profile);
+  mutex_lock(&p_profile->mtx, WAIT_FOREVER);
+  memset(p_profile->entries, 0, sizeof(p_profile->entries));
+  p_profile->num_entries = 0;
+  p_profile->untracked = 0;
+  mutex_unlock(&p_profile->mtx);
+}
+
+void dispatch_queue_set_profile(dispatch_queue_t *p_queue, dispatch_profile_t *p_profile) {
+  CUTILS_ASSERT(p_queue);
+  atomic_store_explicit(&p_queue->p_profile, p_profile, memory_order_relaxed);
+}
+
+static void dispatch_profile_record(dispatch_profile_t *p_profile,
+                                    dispatch_function_t fn,
+                                    cutils_ticks_t posted_at,
+                                    cutils_ticks_t start,
+                                    cutils_ticks_t end) {
+  cutils_ticks_t run = end - start;
+  // Linear probing from the pointer's hash. Entries are never removed, so the first empty slot
+  // ends the search.
+  uint32_t slot = (uint32_t)(((uintptr_t)fn >> 2) * 2654435761u) % DISPATCH_PROFILE_MAX_FUNCTIONS;
+  mutex_lock(&p_profile->mtx, WAIT_FOREVER);
+  dispatch_profile_entry_t *p_entry = 0;
+  for (uint32_t i = 0; !p_entry && i < DISPATCH_PROFILE_MAX_FUNCTIONS; i++) {
+    dispatch_profile_entry_t *p_probe =
+        &p_profile->entries[(slot + i) % DISPATCH_PROFILE_MAX_FUNCTIONS];
+    if (p_probe->fn == fn) {
+      p_entry = p_probe;
+    } else if (!p_probe->fn) {
+      p_probe->fn = fn;
+      p_profile->num_entries++;
+      p_entry = p_probe;
+    }
+  }
+  if (p_entry) {
+    p_entry->calls++;
+    p_entry->total_run += run;
+    p_entry->max_run = MAX(p_entry->max_run, run);
+    if (posted_at) {
+      cutils_ticks_t delay = start - posted_at;
+      p_entry->total_delay += delay;
+      p_entry->max_delay = MAX(p_entry->max_delay, delay);
+    }
+  } else {
+    p_profile->untracked++;
+  }
+  mutex_unlock(&p_profile->mtx);
+}
+
+static int dispatch_profile_compare(const void *a, const void *b) {
+  const dispatch_profile_entry_t *p_a = (const dispatch_profile_entry_t *)a;
+  const dispatch_profile_entry_t *p_b = (const dispatch_profile_entry_t *)b;
+  return (p_a->total_run < p_b->total_run) - (p_a->total_run > p_b->total_run);
+}
+
+size_t dispatch_profile_sorted(dispatch_profile_t *p_profile,
+                               dispatch_profile_entry_t *p_entries,
+                               size_t max) {
+  CUTILS_ASSERT(p_profile && (p_entries || !max));
+  dispatch_profile_entry_t sorted[DISPATCH_PROFILE_MAX_FUNCTIONS];
+  size_t count = 0;
+  mutex_lock(&p_profile->mtx, WAIT_FOREVER);
+  for (uint32_t i = 0; i < DISPATCH_PROFILE_MAX_FUNCTIONS; i++) {
+    if (p_profile->entries[i].fn) {
+      sorted[count++] = p_profile->entries[i];
+    }
+  }
+  mutex_unlock(&p_profile->mtx);
+  qsort(sorted, count, sizeof(sorted[0]), dispatch_profile_compare);
+  count = MIN(count, max);
+  memcpy(p_entries, sorted, count * sizeof(sorted[0]));
+  return count;
+}
+
+static void dispatch_profile_name(dispatch_function_t fn, char *name, size_t len) {
+  bool named = false;
+#ifdef CUTILS_HAVE_DLADDR
+  Dl_info info = {0};
+  if (!dladdr((void *)(uintptr_t)fn, &info)) {
+    // Not in any loaded module, fall back to the address.
+  } else if (info.dli_sname) {
+    snprintf(name, len, "%s", info.dli_sname);
+    named = true;
+  } else if (info.dli_fname) {
+    // Static functions have no dynamic symbol. An offset into the module can still go to addr2line.
+    const char *module = strrchr(info.dli_fname, '/');
+    snprintf(name,
+             len,
+             "%s+0x%" PRIxPTR,
+             module ? module + 1 : info.dli_fname,
+             (uintptr_t)fn - (uintptr_t)info.dli_fbase);
+    named = true;
+  }
+#endif
+  if (!named) {
+    snprintf(name, len, "%p", (void *)(uintptr_t)fn);
+  }
+}
+
+void dispatch_profile_log(dispatch_profile_t *p_profile) {
+  dispatch_profile_entry_t entries[DISPATCH_PROFILE_MAX_FUNCTIONS];
+  size_t count = dispatch_profile_sorted(p_profile, entries, DISPATCH_PROFILE_MAX_FUNCTIONS);
+  mutex_lock(&p_profile->mtx, WAIT_FOREVER);
+  uint32_t untracked = p_profile->untracked;
+  mutex_unlock(&p_profile->mtx);
+  CLOG("dispatch profile: %zu functions, %" PRIu32 " untracked calls", count, untracked);
+  CLOG("  %-40s %10s %14s %14s %14s %14s",
+       "function",
+       "calls",
+       "total run",
+       "max run",
+       "avg delay",
+       "max delay");
+  for (size_t i = 0; i < count; i++) {
+    char name[41];
+    dispatch_profile_name(entries[i].fn, name, sizeof(name));
+    CLOG("  %-40s %10" PRIu32 " %14" PRIu64 " %14" PRIu64 " %14" PRIu64 " %14" PRIu64,
+         name,
+         entries[i].calls,
+         (uint64_t)entries[i].total_run,
+         (uint64_t)entries[i].max_run,
+         (uint64_t)(entries[i].total_delay / entries[i].calls),
+         (uint64_t)entries[i].max_delay);
+  }
+}
+
+bool dispatch_async_copy_f(dispatch_queue_t *p_queue,
+                           dispatch_function_t fn,
+                           const void *ctx,
+                           size_t len) {
+  bool retval = false;
+  CUTILS_ASSERT(fn);
+  if (p_queue && !atomic_load(&p_queue->destroying) && len <= dispatch_queue_inline_size(p_queue)) {
+    retval = dispatch_queue_post_item(
+        p_queue, fn, (void *)ctx, NULL, 0, NULL, DISPATCH_OVERFLOW_DEFAULT, 0, 0, len, NULL);
+  }
+  return retval;
+}
+
+/** Runs `fn` on the caller's thread if the queue can be entered right away. */
+static bool dispatch_sync_inline(dispatch_queue_t *p_queue,
+                                 dispatch_function_t fn,
+                                 void *arg1,
+                                 void *arg2) {
+  bool retval = false;
+  if (p_queue->p_workers) {
+    if (dispatch_workers_enter(p_queue->p_workers)) {
+      fn(arg1, arg2);
+      dispatch_workers_complete(p_queue->p_workers, 0);
+      retval = true;
+    }
+  } else if (!atomic_load_explicit(&p_queue->pending, memory_order_acquire) &&
+             mutex_lock(&p_queue->exec_mtx, NO_SLEEP)) {
+    // Anything posted after the check runs after us, exactly as if it had been posted later.
+    if (!atomic_load_explicit(&p_queue->pending, memory_order_acquire)) {
+      fn(arg1, arg2);
+      retval = true;
+    }
+    mutex_unlock(&p_queue->exec_mtx);
+  }
+  return retval;
+}
+
+bool dispatch_sync_f(dispatch_queue_t *p_queue, dispatch_function_t fn, void *arg1, void *arg2) {
+  bool retval = false;
+
+  CUTILS_ASSERT(fn);
+  if (p_queue && !atomic_load(&p_queue->destroying)) {
+    retval = dispatch_sync_inline(p_queue, fn, arg1, arg2);
+    if (!retval) {
+      dispatch_sync_ctx_t ctx = {.fn = fn, .arg1 = arg1, .arg2 = arg2};
+      CUTILS_ASSERTF(signal_new(&ctx.done), "Couldn't create completion signal");
+      if (dispatch_queue_post(
+              p_queue, dispatch_sync_trampoline, &ctx, NULL, DISPATCH_POST_FLAG_NO_DROP, NULL)) {
+        retval = signal_wait(&ctx.done);
+      }
+      signal_free(&ctx.done);
+    }
+  }
+  return retval;
+}
+
+bool dispatch_barrier_async_f(
+    dispatch_queue_t *p_queue, dispatch_function_t fn, void *arg1, void *arg2) {
+  bool retval = false;
+  if (p_queue && p_queue->p_workers) {
+    retval = dispatch_queue_post(p_queue, fn, arg1, arg2, DISPATCH_POST_FLAG_BARRIER, NULL);
+  } else {
+    retval = dispatch_async_f(p_queue, fn, arg1, arg2);
+  }
+  return retval;
+}
+
+#define DISPATCH_GROUP_FLAG_EMPTY (1 << 0)
+
+bool dispatch_group_new(dispatch_group_t *p_group) {
+  bool retval = false;
+  CUTILS_ASSERT(p_group);
+  memset(p_group, 0, sizeof(dispatch_group_t));
+  atomic_init(&p_group->count, 0);
+  if (mutex_new(&p_group->mtx)) {
+    if (event_flag_new(&p_group->flags)) {
+      event_flag_send(&p_group->flags, DISPATCH_GROUP_FLAG_EMPTY);
+      retval = true;
+    } else {
+      mutex_free(&p_group->mtx);
+    }
+  }
+  return retval;
+}
+
+void dispatch_group_free(dispatch_group_t *p_group) {
+  CUTILS_ASSERTF(!atomic_load(&p_group->count), "Group freed with items outstanding");
+  // The last leave may still hold the lock after releasing the waiters.
+  mutex_lock(&p_group->mtx, WAIT_FOREVER);
+  mutex_unlock(&p_group->mtx);
+  event_flag_free(&p_group->flags);
+  mutex_free(&p_group->mtx);
+}
+
+void dispatch_group_enter(dispatch_group_t *p_group) {
+  // Only the empty to non-empty transition touches the lock. It re-checks the count under the lock
+  // so that it cannot undo a later transition back to empty.
+  if (atomic_fetch_add(&p_group->count, 1) == 0) {
+    mutex_lock(&p_group->mtx, WAIT_FOREVER);
+    if (atomic_load(&p_group->count)) {
+      event_flag_clear(&p_group->flags, DISPATCH_GROUP_FLAG_EMPTY);
+    }
+    mutex_unlock(&p_group->mtx);
+  }
+}
+
+void dispatch_group_leave(dispatch_group_t *p_group) {
+  uint32_t prev = atomic_fetch_sub(&p_group->count, 1);
+  CUTILS_ASSERTF(prev, "Unbalanced dispatch_group_leave");
+  if (prev == 1) {
+    dispatch_group_notify_t notify[DISPATCH_GROUP_MAX_NOTIFY];
+    uint32_t num_notify = 0;
+    mutex_lock(&p_group->mtx, WAIT_FOREVER);
+    if (!atomic_load(&p_group->count)) {
+      num_notify = p_group->num_notify;
+      memcpy(notify, p_group->notify, num_notify * sizeof(notify[0]));
+      p_group->num_notify = 0;
+    }
+    mutex_unlock(&p_group->mtx);
+    // Posted from the copy, without the lock, since a post may block or run the action inline.
+    // Waiters are only released afterwards, so the notifications are queued by the time they run.
+    for (uint32_t i = 0; i < num_notify; i++) {
+      dispatch_group_notify_t *p_notify = &notify[i];
+      if (!dispatch_async_f(p_notify->p_queue, p_notify->fn, p_notify->arg1, p_notify->arg2)) {
+        CLOG("Group notification refused by queue %s", p_notify->p_queue->label);
+      }
+    }
+    // An enter since the copy owns the next transition to empty.
+    mutex_lock(&p_group->mtx, WAIT_FOREVER);
+    if (!atomic_load(&p_group->count)) {
+      event_flag_send(&p_group->flags, DISPATCH_GROUP_FLAG_EMPTY);
+    }
+    mutex_unlock(&p_group->mtx);
+  }
+}
+
+bool dispatch_group_async_f(dispatch_group_t *p_group,
+                            dispatch_queue_t *p_queue,
+                            dispatch_function_t fn,
+                            void *arg1,
+                            void *arg2) {
+  bool retval = false;
+  CUTILS_ASSERT(p_group);
+  dispatch_group_enter(p_group);
+  retval = dispatch_queue_post(p_queue, fn, arg1, arg2, 0, p_group);
+  if (!retval) {
+    dispatch_group_leave(p_group);
+  }
+  return retval;
+}
+
+bool dispatch_group_wait(dispatch_group_t *p_group, uint32_t timeout_ms) {
+  CUTILS_ASSERT(p_group);
+  // Wait on the flag rather than the count: the count reaches zero before the last leave has
+  // posted the notifications.
+  return event_flag_wait(&p_group->flags, DISPATCH_GROUP_FLAG_EMPTY, WAIT_OR, NULL, timeout_ms);
+}
+
+bool dispatch_group_notify_f(dispatch_group_t *p_group,
+                             dispatch_queue_t *p_queue,
+                             dispatch_function_t fn,
+                             void *arg1,
+                             void *arg2) {
+  bool retval = false;
+  bool post_now = false;
+  CUTILS_ASSERT(p_group);
+  CUTILS_ASSERT(fn);
+  mutex_lock(&p_group->mtx, WAIT_FOREVER);
+  if (!atomic_load(&p_group->count)) {
+    post_now = true;
+  } else if (p_group->num_notify < DISPATCH_GROUP_MAX_NOTIFY) {
+    p_group->notify[p_group->num_notify++] =
+        (dispatch_group_notify_t){.p_queue = p_queue, .fn = fn, .arg1 = arg1, .arg2 = arg2};
+    retval = true;
+  }
+  mutex_unlock(&p_group->mtx);
+  if (post_now) {
+    retval = dispatch_async_f(p_queue, fn, arg1, arg2);
+  }
+  return retval;
+}
+
+typedef struct _dispatch_apply_ctx_t {
+  dispatch_apply_function_t fn;
+  void *ctx;
+  size_t iterations;
+  size_t participants;
+  atomic_size_t next;
+  atomic_uint active;
+  signal_t done;
+} dispatch_apply_ctx_t;
+
+static void dispatch_apply_run(dispatch_apply_ctx_t *p_apply) {
+  size_t begin = atomic_load_explicit(&p_apply->next, memory_order_relaxed);
+  while (begin < p_apply->iterations) {
+    size_t chunk = (p_apply->iterations - begin) / (2 * p_apply->participants);
+    size_t end = begin + (chunk ? chunk : 1);
+    if (atomic_compare_exchange_weak_explicit(
+            &p_apply->next, &begin, end, memory_order_relaxed, memory_order_relaxed)) {
+      for (size_t i = begin; i < end; i++) {
+        p_apply->fn(p_apply->ctx, i);
+      }
+      begin = end;
+    }
+  }
+}
+
+static void dispatch_apply_helper(void *arg1, void *arg2) {
+  (void)arg2;
+  dispatch_apply_ctx_t *p_apply = (dispatch_apply_ctx_t *)arg1;
+  dispatch_apply_run(p_apply);
+  if (atomic_fetch_sub(&p_apply->active, 1) == 1) {
+    signal_send(&p_apply->done);
+  }
+}
+
+static void dispatch_apply_serial(void *arg1, void *arg2) {
+  dispatch_apply_ctx_t *p_apply = (dispatch_apply_ctx_t *)arg1;
+  (void)arg2;
+  for (size_t i = 0; i < p_apply->iterations; i++) {
+    p_apply->fn(p_apply->ctx, i);
+  }
+}
+
+void dispatch_apply_f(size_t iterations,
+                      dispatch_queue_t *p_queue,
+                      void *ctx,
+                      dispatch_apply_function_t fn) {
+  CUTILS_ASSERT(fn);
+  dispatch_apply_ctx_t apply = {.fn = fn, .ctx = ctx, .iterations = iterations, .participants = 1};
+  atomic_init(&apply.next, 0);
+
+  if (!p_queue) {
+    dispatch_apply_serial(&apply, NULL);
+  } else if (!p_queue->p_workers) {
+    dispatch_sync_f(p_queue, dispatch_apply_serial, &apply, NULL);
+  } else if (iterations) {
+    uint32_t helpers = p_queue->p_workers->num_workers;
+    if (helpers > iterations - 1) {
+      helpers = (uint32_t)(iterations - 1);
+    }
+    apply.participants = helpers + 1;
+    atomic_init(&apply.active, helpers + 1);
+    CUTILS_ASSERTF(signal_new(&apply.done), "Couldn't create completion signal");
+    for (uint32_t i = 0; i < helpers; i++) {
+      if (!dispatch_queue_post(
+              p_queue, dispatch_apply_helper, &apply, NULL, DISPATCH_POST_FLAG_NO_DROP, NULL)) {
+        atomic_fetch_sub(&apply.active, 1);
+      }
+    }
+    dispatch_apply_run(&apply);
+    if (atomic_fetch_sub(&apply.active, 1) != 1) {
+      signal_wait(&apply.done);
+    }
+    signal_free(&apply.done);
+  }
+}
+
+bool dispatch_after_f(
+    dispatch_queue_t *p_queue, uint32_t delay_ms, dispatch_function_t fn, void *arg1, void *arg2) {
   bool retval = false;
 
   CUTILS_ASSERT(p_queue);
@@ -106,7 +1663,8 @@ bool dispatch_after_f(dispatch_queue_t *p_queue,
   if (delay_ms == NO_SLEEP) {
     retval = dispatch_async_f(p_queue, fn, arg1, arg2);
   } else {
-    retval = (timer_thread_set(timer_thread_system_get(), p_queue, fn, arg1, arg2, delay_ms, 0) != 0);
+    retval = (timer_wheel_arm(timer_wheel_system_get(), p_queue, delay_ms, 0, fn, arg1, arg2) !=
+              TIMER_WHEEL_INVALID);
   }
   return retval;
 }
@@ -116,27 +1674,25 @@ dispatch_queue_timed_action_h dispatch_start_repeated_f(dispatch_queue_t *p_queu
                                                         uint32_t reload_ms,
                                                         dispatch_function_t fn,
                                                         void *arg1,
-                                                        void *arg2)
-{
+                                                        void *arg2) {
   dispatch_queue_timed_action_h retval = 0;
   CUTILS_ASSERT(p_queue);
   CUTILS_ASSERT(fn);
 
-  if(initial_ms == 0){
+  if (initial_ms == 0) {
     dispatch_async_f(p_queue, fn, arg1, arg2);
     initial_ms = reload_ms;
   }
 
-  if(initial_ms || reload_ms) {
-    retval = timer_thread_set(timer_thread_system_get(), p_queue, fn, arg1, arg2, initial_ms, reload_ms);
+  if (initial_ms || reload_ms) {
+    retval = timer_wheel_arm(
+        timer_wheel_system_get(), p_queue, initial_ms, reload_ms, fn, arg1, arg2);
   }
   return retval;
 }
 
-void dispatch_stop_repeated_f(dispatch_queue_timed_action_h h_action)
-{
-  if(h_action) {
-    timer_thread_delete(timer_thread_system_get(), h_action);
+void dispatch_stop_repeated_f(dispatch_queue_timed_action_h h_action) {
+  if (h_action) {
+    timer_wheel_cancel(timer_wheel_system_get(), h_action);
   }
 }
-#endif
@@ -0,0 +1,401 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2020> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cutils/dispatch_source.h>
+#include <cutils/logger.h>
+
+/* A handler run is posted and has not yet taken the accumulated value. */
+#define DISPATCH_DATA_SOURCE_PENDING (1u << 0)
+#define DISPATCH_DATA_SOURCE_CANCELLED (1u << 1)
+/* One handler run in progress, counted in the remaining bits. A concurrent queue can run more. */
+#define DISPATCH_DATA_SOURCE_RUNNING (1u << 2)
+
+void dispatch_data_source_init(dispatch_data_source_t *p_source,
+                               dispatch_source_data_op_e op,
+                               dispatch_queue_t *p_queue,
+                               dispatch_source_data_handler_t fn,
+                               void *ctx) {
+  CUTILS_ASSERT(p_source && p_queue && fn);
+  CUTILS_ASSERT(op == DISPATCH_SOURCE_DATA_ADD || op == DISPATCH_SOURCE_DATA_OR);
+  p_source->p_queue = p_queue;
+  p_source->fn = fn;
+  p_source->ctx = ctx;
+  p_source->op = op;
+  p_source->p_cancelled = NULL;
+  atomic_init(&p_source->data, 0);
+  atomic_init(&p_source->state, 0);
+}
+
+/** Ends one counted run. The last one out of a cancelled source posts its cancellation action. */
+static void dispatch_data_source_release(dispatch_data_source_t *p_source) {
+  unsigned int state = atomic_fetch_sub(&p_source->state, DISPATCH_DATA_SOURCE_RUNNING);
+  if ((state & DISPATCH_DATA_SOURCE_CANCELLED) && state < 2 * DISPATCH_DATA_SOURCE_RUNNING &&
+      p_source->p_cancelled &&
+      !dispatch_queue_post_reserved(p_source->p_queue, p_source->p_cancelled)) {
+    CLOG("dispatch data source cancelled while its queue is being destroyed");
+  }
+}
+
+static void dispatch_data_source_fire(void *arg1, void *arg2) {
+  (void)arg2;
+  dispatch_data_source_t *p_source = (dispatch_data_source_t *)arg1;
+  unsigned int state = atomic_load(&p_source->state);
+  // Clearing PENDING before taking the value lets a merge that lands afterwards post a fresh run.
+  while (!(state & DISPATCH_DATA_SOURCE_CANCELLED) &&
+         !atomic_compare_exchange_weak(&p_source->state,
+                                       &state,
+                                       (state & ~DISPATCH_DATA_SOURCE_PENDING) +
+                                           DISPATCH_DATA_SOURCE_RUNNING)) {
+  }
+  if (!(state & DISPATCH_DATA_SOURCE_CANCELLED)) {
+    uintptr_t data = atomic_exchange(&p_source->data, 0);
+    // The value may already have gone to the previous run, if the merge raced with it.
+    if (data) {
+      p_source->fn(p_source->ctx, data);
+    }
+  }
+  // A run that was still pending when the source got cancelled has been counted by the cancel.
+  dispatch_data_source_release(p_source);
+}
+
+void dispatch_source_merge_data(dispatch_data_source_t *p_source, uintptr_t value) {
+  CUTILS_ASSERT(p_source);
+  if (value && !(atomic_load(&p_source->state) & DISPATCH_DATA_SOURCE_CANCELLED)) {
+    if (p_source->op == DISPATCH_SOURCE_DATA_ADD) {
+      atomic_fetch_add(&p_source->data, value);
+    } else {
+      atomic_fetch_or(&p_source->data, value);
+    }
+    unsigned int state = atomic_fetch_or(&p_source->state, DISPATCH_DATA_SOURCE_PENDING);
+    if (!(state & DISPATCH_DATA_SOURCE_PENDING) &&
+        !dispatch_queue_post(p_source->p_queue,
+                             dispatch_data_source_fire,
+                             p_source,
+                             NULL,
+                             DISPATCH_POST_FLAG_NO_DROP,
+                             NULL)) {
+      // The value stays accumulated and goes to the run posted by the next merge.
+      CLOG("dispatch data source could not post its handler");
+      state = atomic_load(&p_source->state);
+      while (!(state & DISPATCH_DATA_SOURCE_CANCELLED) &&
+             !atomic_compare_exchange_weak(
+                 &p_source->state, &state, state & ~DISPATCH_DATA_SOURCE_PENDING)) {
+      }
+      if (state & DISPATCH_DATA_SOURCE_CANCELLED) {
+        // Cancelled in the meantime, which counted the run that never got posted.
+        dispatch_data_source_release(p_source);
+      }
+    }
+  }
+}
+
+bool dispatch_data_source_cancel(dispatch_data_source_t *p_source,
+                                 dispatch_function_t on_cancelled,
+                                 void *arg1,
+                                 void *arg2) {
+  bool retval = false;
+  CUTILS_ASSERT(p_source);
+  // Reserved up front, so that once the source is cancelled the action cannot be refused.
+  dispatch_queue_post_data_t *p_post =
+      on_cancelled ? dispatch_queue_reserve_post(p_source->p_queue, on_cancelled, arg1, arg2)
+                   : NULL;
+  if (p_post || !on_cancelled) {
+    p_source->p_cancelled = p_post;
+    // Setting PENDING too keeps merges from posting again. A run that is still pending is counted
+    // as running, and if any run is counted the last one to finish posts the action instead.
+    unsigned int state = atomic_load(&p_source->state);
+    unsigned int cancelled = 0;
+    do {
+      CUTILS_ASSERTF(!(state & DISPATCH_DATA_SOURCE_CANCELLED), "Data source cancelled twice");
+      cancelled = state | DISPATCH_DATA_SOURCE_PENDING | DISPATCH_DATA_SOURCE_CANCELLED;
+      if (state & DISPATCH_DATA_SOURCE_PENDING) {
+        cancelled += DISPATCH_DATA_SOURCE_RUNNING;
+      }
+    } while (!atomic_compare_exchange_weak(&p_source->state, &state, cancelled));
+    if (p_post && cancelled < DISPATCH_DATA_SOURCE_RUNNING &&
+        !dispatch_queue_post_reserved(p_source->p_queue, p_post)) {
+      CLOG("dispatch data source cancelled while its queue is being destroyed");
+    }
+    retval = true;
+  } else {
+    CLOG("dispatch data source left running, its queue has no record");
+  }
+  return retval;
+}
+
+#ifdef CUTILS_HAVE_EPOLL
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#ifndef CUTILS_SYSTEM_SOURCES
+#define CUTILS_SYSTEM_SOURCES (256)
+#endif
+
+/* Ready descriptors taken from the kernel per epoll_wait(). */
+#define DISPATCH_SOURCE_EVENTS_PER_WAIT (64)
+
+/**
+ * One watched descriptor. Everything but `cancelled` is only touched with the monitor's mutex
+ * held, or by the single handler in flight, which the one-shot registration guarantees.
+ */
+typedef struct _dispatch_source_t {
+  dispatch_source_h handle;
+  int fd;
+  uint32_t mask;
+  dispatch_queue_t *p_queue;
+  dispatch_source_handler_t fn;
+  void *ctx;
+  /* Events handed to the pending handler. */
+  uint32_t events;
+  /* A handler is posted or running, so the record must stay. */
+  bool queued;
+  atomic_bool cancelled;
+  /* The cancellation action, reserved on the queue by dispatch_source_cancel(). */
+  dispatch_queue_post_data_t *p_cancelled;
+} dispatch_source_t;
+
+typedef struct _dispatch_source_monitor_t {
+  int epoll_fd;
+  /* Serializes event delivery with cancellation, so a record is never freed under the monitor. */
+  mutex_t mtx;
+  pool_t *p_pool;
+  handle_table_t *p_handles;
+  task_t *p_task;
+  struct epoll_event ready[DISPATCH_SOURCE_EVENTS_PER_WAIT];
+} dispatch_source_monitor_t;
+
+TASK_STATIC_STORE_DECL(dispatch_sources, 4096);
+TASK_STATIC_STORE_DEF_OWNED(dispatch_sources, MemReportDispatchQueue);
+POOL_STORE_DECL(dispatch_sources,
+                CUTILS_SYSTEM_SOURCES,
+                sizeof(dispatch_source_t),
+                alignof(dispatch_source_t));
+POOL_STORE_DEF_OWNED(dispatch_sources, MemReportDispatchQueue);
+HANDLE_TABLE_STORE_DECL(dispatch_sources, CUTILS_SYSTEM_SOURCES);
+HANDLE_TABLE_STORE_DEF_OWNED(dispatch_sources, MemReportDispatchQueue);
+
+static dispatch_source_monitor_t s_monitor;
+
+static uint32_t dispatch_source_to_epoll(uint32_t mask) {
+  return ((mask & DISPATCH_SOURCE_READ) ? EPOLLIN : 0) |
+         ((mask & DISPATCH_SOURCE_WRITE) ? EPOLLOUT : 0) | EPOLLONESHOT;
+}
+
+static uint32_t dispatch_source_from_epoll(uint32_t events) {
+  return ((events & (EPOLLIN | EPOLLPRI | EPOLLRDHUP)) ? DISPATCH_SOURCE_READ : 0) |
+         ((events & EPOLLOUT) ? DISPATCH_SOURCE_WRITE : 0) |
+         ((events & (EPOLLERR | EPOLLHUP)) ? DISPATCH_SOURCE_ERROR : 0);
+}
+
+/* What is left to do once a cancelled source has been released. */
+typedef struct {
+  dispatch_queue_t *p_queue;
+  dispatch_queue_post_data_t *p_post;
+} dispatch_source_cancelled_t;
+
+/**
+ * Releases a cancelled source that has no handler left. Called with the monitor mutex held. The
+ * cancellation action is returned rather than posted, so that it is posted without the mutex.
+ */
+static dispatch_source_cancelled_t dispatch_source_retire(dispatch_source_t *p_source) {
+  dispatch_source_cancelled_t retval = {.p_queue = p_source->p_queue,
+                                        .p_post = p_source->p_cancelled};
+  handle_table_release(s_monitor.p_handles, p_source->handle);
+  pool_free(s_monitor.p_pool, p_source);
+  return retval;
+}
+
+static void dispatch_source_post_cancelled(dispatch_source_cancelled_t *p_cancelled) {
+  if (p_cancelled->p_post &&
+      !dispatch_queue_post_reserved(p_cancelled->p_queue, p_cancelled->p_post)) {
+    CLOG("dispatch source cancelled while its queue is being destroyed");
+  }
+}
+
+/** Takes back the handler of a source whose post failed, or that has just run. */
+static void dispatch_source_unqueue(dispatch_source_t *p_source, bool rearm) {
+  dispatch_source_cancelled_t cancelled = {0};
+  mutex_lock(&s_monitor.mtx, WAIT_FOREVER);
+  p_source->queued = false;
+  if (atomic_load(&p_source->cancelled)) {
+    cancelled = dispatch_source_retire(p_source);
+  } else if (rearm) {
+    // Watch the descriptor again. If it is still ready, the monitor hears about it straight away.
+    struct epoll_event event = {.events = dispatch_source_to_epoll(p_source->mask),
+                                .data.u64 = p_source->handle};
+    if (epoll_ctl(s_monitor.epoll_fd, EPOLL_CTL_MOD, p_source->fd, &event)) {
+      CLOG("dispatch source on fd %d could not be re-armed, errno %d", p_source->fd, errno);
+    }
+  }
+  mutex_unlock(&s_monitor.mtx);
+  dispatch_source_post_cancelled(&cancelled);
+}
+
+static void dispatch_source_fire(void *arg1, void *arg2) {
+  (void)arg2;
+  dispatch_source_t *p_source = (dispatch_source_t *)arg1;
+  if (!atomic_load(&p_source->cancelled)) {
+    p_source->fn(p_source->ctx, p_source->events);
+  }
+  dispatch_source_unqueue(p_source, true);
+}
+
+static void dispatch_source_monitor(void *ctx) {
+  dispatch_source_monitor_t *p_monitor = (dispatch_source_monitor_t *)ctx;
+  dispatch_source_t *fire[DISPATCH_SOURCE_EVENTS_PER_WAIT];
+  while (1) {
+    int count = epoll_wait(
+        p_monitor->epoll_fd, p_monitor->ready, DISPATCH_SOURCE_EVENTS_PER_WAIT, -1);
+    CUTILS_ASSERTF(count >= 0 || errno == EINTR, "epoll_wait failed, errno %d", errno);
+    int num_fire = 0;
+    mutex_lock(&p_monitor->mtx, WAIT_FOREVER);
+    for (int i = 0; i < count; i++) {
+      // A source cancelled after the kernel reported it no longer resolves, so it is skipped.
+      dispatch_source_t *p_source =
+          handle_table_lookup(p_monitor->p_handles, p_monitor->ready[i].data.u64);
+      if (p_source && !p_source->queued && !atomic_load(&p_source->cancelled)) {
+        // Once queued, a cancel leaves the record to the handler, so it can be posted unlocked.
+        p_source->events = dispatch_source_from_epoll(p_monitor->ready[i].events);
+        p_source->queued = true;
+        fire[num_fire++] = p_source;
+      }
+    }
+    mutex_unlock(&p_monitor->mtx);
+    for (int i = 0; i < num_fire; i++) {
+      if (!dispatch_queue_post(fire[i]->p_queue,
+                               dispatch_source_fire,
+                               fire[i],
+                               NULL,
+                               DISPATCH_POST_FLAG_NO_DROP,
+                               NULL)) {
+        // The queue is gone or full. The source stays disarmed until it is cancelled.
+        CLOG("dispatch source on fd %d could not post its handler", fire[i]->fd);
+        dispatch_source_unqueue(fire[i], false);
+      }
+    }
+  }
+}
+
+static dispatch_source_monitor_t *dispatch_source_monitor_get(void) {
+  static atomic_uint s_state = 0;
+  enum { UNINITIALIZED, CREATING, READY };
+  unsigned int expected = UNINITIALIZED;
+  if (atomic_compare_exchange_strong(&s_state, &expected, CREATING)) {
+    s_monitor.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    CUTILS_ASSERTF(s_monitor.epoll_fd >= 0, "Couldn't create the epoll instance");
+    CUTILS_ASSERTF(mutex_new(&s_monitor.mtx), "Couldn't create mutex");
+
+    pool_create_params_t pool_params;
+    POOL_CREATE_INIT(pool_params, dispatch_sources);
+    s_monitor.p_pool = pool_create(&pool_params);
+    CUTILS_ASSERTF(s_monitor.p_pool, "Unable to create source pool");
+
+    handle_table_create_params_t handle_params;
+    HANDLE_TABLE_CREATE_PARAMS_INIT(handle_params, dispatch_sources);
+    s_monitor.p_handles = handle_table_create(&handle_params);
+    CUTILS_ASSERTF(s_monitor.p_handles, "Unable to create source handles");
+
+    task_create_params_t task_params;
+    TASK_STATIC_INIT_CREATE_PARAMS(task_params,
+                                   dispatch_sources,
+                                   "dispatch_sources",
+                                   CUTILS_TASK_PRIORITY_HIGHEST,
+                                   dispatch_source_monitor,
+                                   &s_monitor);
+    s_monitor.p_task = task_new_static(&task_params);
+    CUTILS_ASSERTF(s_monitor.p_task, "Couldn't Create Task");
+    task_start(s_monitor.p_task);
+    atomic_store(&s_state, READY);
+  } else {
+    while (atomic_load(&s_state) != READY) {
+      task_sleep(1);
+    }
+  }
+  return &s_monitor;
+}
+
+dispatch_source_h dispatch_source_create(
+    int fd, uint32_t mask, dispatch_queue_t *p_queue, dispatch_source_handler_t fn, void *ctx) {
+  dispatch_source_h retval = DISPATCH_SOURCE_INVALID;
+  CUTILS_ASSERT(p_queue && fn);
+  CUTILS_ASSERTF(mask && !(mask & ~(DISPATCH_SOURCE_READ | DISPATCH_SOURCE_WRITE)),
+                 "Watch for DISPATCH_SOURCE_READ and/or DISPATCH_SOURCE_WRITE");
+  dispatch_source_monitor_t *p_monitor = dispatch_source_monitor_get();
+  mutex_lock(&p_monitor->mtx, WAIT_FOREVER);
+  dispatch_source_t *p_source = pool_alloc(p_monitor->p_pool);
+  if (p_source) {
+    *p_source = (dispatch_source_t){
+        .fd = fd, .mask = mask, .p_queue = p_queue, .fn = fn, .ctx = ctx};
+    atomic_init(&p_source->cancelled, false);
+    p_source->handle = handle_table_alloc(p_monitor->p_handles, p_source);
+    CUTILS_ASSERT(p_source->handle != HANDLE_INVALID);
+    struct epoll_event event = {.events = dispatch_source_to_epoll(mask),
+                                .data.u64 = p_source->handle};
+    if (!epoll_ctl(p_monitor->epoll_fd, EPOLL_CTL_ADD, fd, &event)) {
+      retval = p_source->handle;
+    } else {
+      CLOG("Can't watch fd %d, errno %d", fd, errno);
+      handle_table_release(p_monitor->p_handles, p_source->handle);
+      pool_free(p_monitor->p_pool, p_source);
+    }
+  }
+  mutex_unlock(&p_monitor->mtx);
+  return retval;
+}
+
+bool dispatch_source_cancel(dispatch_source_h h_source,
+                            dispatch_function_t on_cancelled,
+                            void *arg1,
+                            void *arg2) {
+  bool retval = false;
+  dispatch_source_cancelled_t cancelled = {0};
+  dispatch_source_monitor_t *p_monitor = dispatch_source_monitor_get();
+  mutex_lock(&p_monitor->mtx, WAIT_FOREVER);
+  dispatch_source_t *p_source = handle_table_lookup(p_monitor->p_handles, h_source);
+  if (p_source && !atomic_load(&p_source->cancelled)) {
+    // Reserving never blocks, so it can be done under the mutex. Once the source is cancelled, the
+    // action cannot be refused.
+    dispatch_queue_post_data_t *p_post =
+        on_cancelled ? dispatch_queue_reserve_post(p_source->p_queue, on_cancelled, arg1, arg2)
+                     : NULL;
+    if (p_post || !on_cancelled) {
+      atomic_store(&p_source->cancelled, true);
+      p_source->p_cancelled = p_post;
+      epoll_ctl(p_monitor->epoll_fd, EPOLL_CTL_DEL, p_source->fd, NULL);
+      if (!p_source->queued) {
+        cancelled = dispatch_source_retire(p_source);
+      }
+      retval = true;
+    } else {
+      CLOG("dispatch source on fd %d left live, its queue has no record", p_source->fd);
+    }
+  }
+  mutex_unlock(&p_monitor->mtx);
+  dispatch_source_post_cancelled(&cancelled);
+  return retval;
+}
+
+#endif // CUTILS_HAVE_EPOLL
@@ -21,6 +21,11 @@ task_t *task_new_static(task_create_params_t *params) {
                                    params->priority,
                                    params->stack,
                                    &task->tcb);
+#if (configUSE_CORE_AFFINITY == 1) && (configNUMBER_OF_CORES > 1)
+    if (task->task && params->affinity) {
+      vTaskCoreAffinitySet(task->task, (UBaseType_t)params->affinity);
+    }
+#endif
     return task;
   }
   return 0;
@@ -34,6 +39,8 @@ bool task_start(task_t *task) {
   return true;
 }
 
+bool task_is_current(task_t *task) { return task && task->task == xTaskGetCurrentTaskHandle(); }
+
 void task_destroy_static(task_t *task) {
   if (task && task->task) {
     vTaskDelete(task->task);
@@ -49,12 +56,19 @@ cutils_ticks_t task_get_ticks(void) {
   return xTaskGetTickCount();
 }
 
+uint32_t task_get_ms(void) {
+  /* Wraps together with the tick counter; deltas stay correct in uint32_t arithmetic. */
+  return (uint32_t)xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
 void task_sleep(uint32_t ms) {
   /* pdMS_TO_TICKS(0) == 0; vTaskDelay(0) yields to equal-priority tasks rather
    * than sleeping, which matches the intent of a zero-timeout 'sleep'. */
   vTaskDelay((ms == WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(ms));
 }
 
+void task_yield(void) { taskYIELD(); }
+
 void task_get_current_name(char *name, size_t string_length) {
   if (name && string_length) {
     const char *pcName = pcTaskGetName(xTaskGetCurrentTaskHandle());
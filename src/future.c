@@ -0,0 +1,210 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cutils/future.h>
+#include <cutils/logger.h>
+#include <cutils/pool.h>
+
+#ifndef CUTILS_SYSTEM_FUTURES
+#define CUTILS_SYSTEM_FUTURES (64)
+#endif
+
+/* Taken by the first future_fulfill(), which alone may write the value. */
+#define FUTURE_CLAIMED (1u << 0)
+/* The value has been written. */
+#define FUTURE_DONE (1u << 1)
+/* A continuation has been attached. Whoever sets the second of DONE and THEN posts it. */
+#define FUTURE_THEN (1u << 2)
+
+#define FUTURE_SIGNAL_DONE (1u)
+
+POOL_STORE_DECL(system_futures, CUTILS_SYSTEM_FUTURES, sizeof(future_t), alignof(future_t));
+POOL_STORE_DEF_OWNED(system_futures, MemReportFuture);
+
+/* Only valid once future_pool_get() has run, which every future has been through. */
+#define FUTURE_POOL (&POOL_STORE(system_futures).pool)
+
+static pool_t *future_pool_get(void) {
+  static pool_t *s_pool = 0;
+  static atomic_uint s_state = 0;
+  enum { UNINITIALIZED, CREATING, READY };
+  unsigned int expected = UNINITIALIZED;
+  if (atomic_compare_exchange_strong(&s_state, &expected, CREATING)) {
+    pool_create_params_t params;
+    POOL_CREATE_INIT(params, system_futures);
+    s_pool = pool_create(&params);
+    CUTILS_ASSERTF(s_pool, "Unable to create the future pool");
+    atomic_store(&s_state, READY);
+  } else {
+    while (atomic_load(&s_state) != READY) {
+      task_sleep(1);
+    }
+  }
+  return s_pool;
+}
+
+static void future_destroy(void *mem, void *private) {
+  (void)private;
+  event_flag_free(&((future_t *)mem)->done);
+}
+
+future_t *future_new(void) {
+  future_t *retval = 0;
+  pool_t *p_pool = future_pool_get();
+  future_t *p_future = (future_t *)pool_alloc_blocking(p_pool, NO_SLEEP, future_destroy, NULL);
+  if (p_future) {
+    memset(p_future, 0, sizeof(*p_future));
+    atomic_init(&p_future->state, 0);
+    if (event_flag_new(&p_future->done)) {
+      retval = p_future;
+    } else {
+      CLOG("Couldn't create the event flag of a future");
+      pool_set_destructor(p_pool, p_future, NULL, NULL);
+      pool_free(p_pool, p_future);
+    }
+  }
+  return retval;
+}
+
+void future_retain(future_t *p_future) {
+  CUTILS_ASSERT(p_future);
+  pool_retain(FUTURE_POOL, p_future);
+}
+
+void future_release(future_t *p_future) {
+  if (p_future) {
+    pool_free(FUTURE_POOL, p_future);
+  }
+}
+
+/* Runs a continuation on its queue and fulfills the future it produces. */
+static void future_run_then(void *arg1, void *arg2) {
+  future_t *p_future = (future_t *)arg1;
+  future_t *p_next = (future_t *)arg2;
+  future_fulfill(p_next, p_next->then(p_next->arg1, p_future->value));
+  future_release(p_next);
+  future_release(p_future);
+}
+
+static void future_post_then(future_t *p_future) {
+  future_t *p_next = (future_t *)p_future->p_then->arg2;
+  if (!dispatch_queue_post_reserved(p_future->p_queue, p_future->p_then)) {
+    // Only a queue that is being destroyed refuses it. Drop what the continuation would have.
+    CLOG("Continuation dropped, queue %s is being destroyed", p_future->p_queue->label);
+    future_release(p_next);
+    future_release(p_future);
+  }
+}
+
+bool future_fulfill(future_t *p_future, void *value) {
+  bool retval = false;
+  CUTILS_ASSERT(p_future);
+  if (!(atomic_fetch_or(&p_future->state, FUTURE_CLAIMED) & FUTURE_CLAIMED)) {
+    p_future->value = value;
+    unsigned int state = atomic_fetch_or(&p_future->state, FUTURE_DONE);
+    event_flag_send(&p_future->done, FUTURE_SIGNAL_DONE);
+    if (state & FUTURE_THEN) {
+      future_post_then(p_future);
+    }
+    retval = true;
+  }
+  return retval;
+}
+
+bool future_is_ready(future_t *p_future) {
+  CUTILS_ASSERT(p_future);
+  return atomic_load(&p_future->state) & FUTURE_DONE;
+}
+
+bool future_wait(future_t *p_future, uint32_t timeout_ms, void **p_value) {
+  bool retval = future_is_ready(p_future);
+  if (!retval && timeout_ms != NO_SLEEP) {
+    // WAIT_OR leaves the flag set for every other waiter.
+    retval = event_flag_wait(&p_future->done, FUTURE_SIGNAL_DONE, WAIT_OR, NULL, timeout_ms);
+  }
+  if (retval && p_value) {
+    *p_value = p_future->value;
+  }
+  return retval;
+}
+
+future_t *future_then_f(future_t *p_future,
+                        dispatch_queue_t *p_queue,
+                        future_function_t fn,
+                        void *ctx) {
+  future_t *retval = 0;
+  CUTILS_ASSERT(p_future && p_queue && fn);
+  CUTILS_ASSERTF(!(atomic_load(&p_future->state) & FUTURE_THEN),
+                 "A future takes a single continuation");
+  future_t *p_next = future_new();
+  dispatch_queue_post_data_t *p_then =
+      p_next ? dispatch_queue_reserve_post(p_queue, future_run_then, p_future, p_next) : NULL;
+  if (p_then) {
+    p_next->then = fn;
+    p_next->arg1 = ctx;
+    // One reference for the caller, one for the continuation. The continuation also keeps the
+    // future it reads the value of.
+    future_retain(p_next);
+    future_retain(p_future);
+    p_future->p_queue = p_queue;
+    p_future->p_then = p_then;
+    if (atomic_fetch_or(&p_future->state, FUTURE_THEN) & FUTURE_DONE) {
+      future_post_then(p_future);
+    }
+    retval = p_next;
+  } else {
+    future_release(p_next);
+  }
+  return retval;
+}
+
+/* Runs the work item of dispatch_async_future_f() and fulfills its future. */
+static void future_run_work(void *arg1, void *arg2) {
+  (void)arg2;
+  future_t *p_future = (future_t *)arg1;
+  future_fulfill(p_future, p_future->work(p_future->arg1, p_future->arg2));
+  future_release(p_future);
+}
+
+future_t *dispatch_async_future_f(dispatch_queue_t *p_queue,
+                                  future_work_t fn,
+                                  void *arg1,
+                                  void *arg2) {
+  future_t *retval = 0;
+  CUTILS_ASSERT(p_queue && fn);
+  future_t *p_future = future_new();
+  if (p_future) {
+    p_future->work = fn;
+    p_future->arg1 = arg1;
+    p_future->arg2 = arg2;
+    future_retain(p_future);
+    if (dispatch_async_f(p_queue, future_run_work, p_future, NULL)) {
+      retval = p_future;
+    } else {
+      future_release(p_future);
+      future_release(p_future);
+    }
+  }
+  return retval;
+}
@@ -0,0 +1,110 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cutils/logger.h>
+#include <cutils/mem_report.h>
+#include <inttypes.h>
+
+// The linker synthesizes these for any section whose name is a valid C identifier. They are weak
+// so that an image without a single registered store still links; both resolve to NULL then.
+extern const mem_report_record_t __start_cutils_mem_records[] __attribute__((weak));
+extern const mem_report_record_t __stop_cutils_mem_records[] __attribute__((weak));
+
+size_t mem_report_record_count(void) {
+  size_t retval = 0;
+  if (__start_cutils_mem_records && __stop_cutils_mem_records) {
+    retval = (size_t)(__stop_cutils_mem_records - __start_cutils_mem_records);
+  }
+  return retval;
+}
+
+const mem_report_record_t *mem_report_record_at(size_t index) {
+  const mem_report_record_t *retval = 0;
+  if (index < mem_report_record_count()) {
+    retval = &__start_cutils_mem_records[index];
+  }
+  return retval;
+}
+
+size_t mem_report_foreach(mem_report_record_f fn, void *ctx) {
+  size_t count = mem_report_record_count();
+  if (fn) {
+    for (size_t i = 0; i < count; i++) {
+      fn(&__start_cutils_mem_records[i], ctx);
+    }
+  }
+  return count;
+}
+
+uint64_t mem_report_subsystem_bytes(mem_report_kind_e owner) {
+  uint64_t retval = 0;
+  size_t count = mem_report_record_count();
+  for (size_t i = 0; i < count; i++) {
+    if (__start_cutils_mem_records[i].owner == (uint32_t)owner) {
+      retval += __start_cutils_mem_records[i].size;
+    }
+  }
+  return retval;
+}
+
+uint64_t mem_report_kind_bytes(mem_report_kind_e kind) {
+  uint64_t retval = 0;
+  size_t count = mem_report_record_count();
+  for (size_t i = 0; i < count; i++) {
+    if (__start_cutils_mem_records[i].kind == (uint32_t)kind) {
+      retval += __start_cutils_mem_records[i].size;
+    }
+  }
+  return retval;
+}
+
+static void log_record(const mem_report_record_t *p_record, void *ctx) {
+  (void)ctx;
+  CLOG("  %-20s %-20s %-40.*s %10" PRIu32 " bytes (%" PRIu32 " x %" PRIu32 ")",
+       get_mem_report_kind_e_string((mem_report_kind_e)p_record->owner),
+       get_mem_report_kind_e_string((mem_report_kind_e)p_record->kind),
+       (int)sizeof(p_record->name),
+       p_record->name,
+       p_record->size,
+       p_record->count,
+       p_record->element_size);
+}
+
+void mem_report_log(bool verbose) {
+  uint64_t total = 0;
+  CLOG("cutils static memory: %zu stores", mem_report_record_count());
+  for (uint32_t owner = 0; owner < MemReportKindCount; owner++) {
+    uint64_t bytes = mem_report_subsystem_bytes((mem_report_kind_e)owner);
+    if (bytes) {
+      CLOG("  %-24s %12" PRIu64 " bytes",
+           get_mem_report_kind_e_string((mem_report_kind_e)owner),
+           bytes);
+      total += bytes;
+    }
+  }
+  CLOG("  %-24s %12" PRIu64 " bytes", "Total", total);
+  if (verbose) {
+    mem_report_foreach(log_record, NULL);
+  }
+}
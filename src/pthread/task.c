@@ -22,12 +22,20 @@
  * THE SOFTWARE.
  */
 
+#if defined(CUTILS_HAVE_PTHREAD_NP) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // pthread_setname_np(), pthread_attr_setaffinity_np()
+#endif
+
 #include <cutils/logger.h>
 #include <cutils/task.h>
+#include <errno.h>
 #include <pthread.h>
+#include <sched.h>
 #include <string.h>
 
 #define TASK_SANITY (0xDEADBEEF)
+/* Linux caps thread names at 16 bytes, terminator included. */
+#define TASK_OS_NAME_MAX (16)
 static pthread_key_t s_task_private_key = 0;
 static pthread_once_t s_init = PTHREAD_ONCE_INIT;
 
@@ -37,11 +45,43 @@ static void *task_runner(void *ctx) {
   task_t *task = (task_t *)ctx;
   pthread_once(&s_init, thread_init);
   pthread_setspecific(s_task_private_key, task);
+#ifdef CUTILS_HAVE_PTHREAD_NP
+  char name[TASK_OS_NAME_MAX] = {0};
+  strncpy(name, task->label, sizeof(name) - 1);
+  pthread_setname_np(pthread_self(), name);
+#endif
   task->func(task->ctx);
   pthread_setspecific(s_task_private_key, NULL);
   return NULL;
 }
 
+/* Maps the per task override to a policy, -1 meaning inherit the creating thread's. */
+static int task_sched_policy(task_sched_policy_e policy) {
+  int retval = -1;
+  switch (policy) {
+  case TASK_SCHED_OTHER:
+    retval = SCHED_OTHER;
+    break;
+  case TASK_SCHED_FIFO:
+    retval = SCHED_FIFO;
+    break;
+  case TASK_SCHED_RR:
+    retval = SCHED_RR;
+    break;
+  default:
+    /* Only real-time policies (SCHED_FIFO/SCHED_RR) expose a non-trivial
+     * priority range, so only they take explicit control of thread scheduling.
+     * On Linux that requires CAP_SYS_NICE; under the default SCHED_OTHER there
+     * is no range (0..0), .priority is a no-op, and we inherit the parent's
+     * scheduling so the build runs unprivileged. See issue #22. */
+    retval = (SCHEDULING_POLICY == SCHED_FIFO || SCHEDULING_POLICY == SCHED_RR)
+                 ? SCHEDULING_POLICY
+                 : -1;
+    break;
+  }
+  return retval;
+}
+
 task_t *task_new_static(task_create_params_t *create_params) {
   task_t *retval = 0;
 
@@ -57,29 +97,46 @@ task_t *task_new_static(task_create_params_t *create_params) {
     int rval = pthread_attr_getstacksize(&attr, &min_stack_size);
     CHECK_RUN(!rval, pthread_attr_destroy(&attr);
               return retval, "Failed to query minimum stack size");
-    /* Only real-time policies (SCHED_FIFO/SCHED_RR) expose a non-trivial
-     * priority range, so only they take explicit control of thread scheduling.
-     * On Linux that requires CAP_SYS_NICE; under the default SCHED_OTHER there
-     * is no range (0..0), .priority is a no-op, and we inherit the parent's
-     * scheduling so the build runs unprivileged. See issue #22. */
-#if CUTILS_PTHREAD_SCHED_POLICY == SCHED_FIFO || \
-    CUTILS_PTHREAD_SCHED_POLICY == SCHED_RR
-    rval = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
-    CHECK_RUN(!rval, pthread_attr_destroy(&attr);
-              return retval, "Failed to set scheduling parameter");
-    rval = pthread_attr_setschedpolicy(&attr, SCHEDULING_POLICY);
-    CHECK_RUN(!rval, pthread_attr_destroy(&attr); return retval, "Failed to set scheduling policy");
-    struct sched_param param = {.sched_priority = create_params->priority};
-    rval = pthread_attr_setschedparam(&attr, &param);
-    CHECK_RUN(!rval, pthread_attr_destroy(&attr);
-              return retval, "Failed to set priority to %d", param.sched_priority);
+    int policy = task_sched_policy(create_params->sched_policy);
+    if (policy >= 0) {
+      rval = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+      CHECK_RUN(!rval, pthread_attr_destroy(&attr);
+                return retval, "Failed to set scheduling parameter");
+      rval = pthread_attr_setschedpolicy(&attr, policy);
+      CHECK_RUN(!rval, pthread_attr_destroy(&attr);
+                return retval, "Failed to set scheduling policy %d", policy);
+      struct sched_param param = {.sched_priority = (int)create_params->priority};
+      if (param.sched_priority < sched_get_priority_min(policy)) {
+        param.sched_priority = sched_get_priority_min(policy);
+      } else if (param.sched_priority > sched_get_priority_max(policy)) {
+        param.sched_priority = sched_get_priority_max(policy);
+      }
+      rval = pthread_attr_setschedparam(&attr, &param);
+      CHECK_RUN(!rval, pthread_attr_destroy(&attr);
+                return retval, "Failed to set priority to %d", param.sched_priority);
+    } else {
+      /* SCHED_OTHER: priority range is 0..0, so .priority is a no-op. Inherit
+       * the creating thread's scheduling to avoid the CAP_SYS_NICE requirement. */
+      rval = pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+      CHECK_RUN(!rval, pthread_attr_destroy(&attr);
+                return retval, "Failed to set inherit scheduling");
+    }
+    if (create_params->affinity) {
+#ifdef CUTILS_HAVE_PTHREAD_NP
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      for (unsigned int cpu = 0; cpu < 64; cpu++) {
+        if (create_params->affinity & ((uint64_t)1 << cpu)) {
+          CPU_SET(cpu, &cpus);
+        }
+      }
+      rval = pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
 #else
-    /* SCHED_OTHER: priority range is 0..0, so .priority is a no-op. Inherit
-     * the creating thread's scheduling to avoid the CAP_SYS_NICE requirement. */
-    rval = pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
-    CHECK_RUN(!rval, pthread_attr_destroy(&attr);
-              return retval, "Failed to set inherit scheduling");
+      rval = ENOTSUP;
 #endif
+      CHECK_RUN(!rval, pthread_attr_destroy(&attr); return retval,
+                "Failed to set CPU affinity 0x%llx", (unsigned long long)create_params->affinity);
+    }
     if (create_params->stack && create_params->stack_size >= min_stack_size) {
       rval = pthread_attr_setstack(&attr, create_params->stack, create_params->stack_size);
       CHECK_RUN(!rval, pthread_attr_destroy(&attr);
@@ -88,15 +145,20 @@ task_t *task_new_static(task_create_params_t *create_params) {
 
     create_params->task->ctx = create_params->ctx;
     create_params->task->func = create_params->func;
-
-    int res = pthread_create(&create_params->task->task, &attr, task_runner, create_params->task);
-    pthread_attr_destroy(&attr);
-
-    create_params->task->sanity = TASK_SANITY;
+    // The new thread reads its label straight away, to name itself.
     strncpy(
         create_params->task->label, create_params->label, sizeof(create_params->task->label) - 1);
-    // TODO: Add an assertion
-    retval = (res == 0) ? create_params->task : 0;
+    create_params->task->sanity = TASK_SANITY;
+
+    rval = pthread_create(&create_params->task->task, &attr, task_runner, create_params->task);
+    pthread_attr_destroy(&attr);
+    if (!rval) {
+      retval = create_params->task;
+    } else {
+      // EPERM: a real time policy without CAP_SYS_NICE. EINVAL: no allowed CPU is online.
+      CLOG("Couldn't create task %s, error %d", create_params->task->label, rval);
+      create_params->task->sanity = 0;
+    }
   }
   return retval;
 }
@@ -113,17 +175,27 @@ bool task_start(task_t *task) {
   return true;
 }
 
+bool task_is_current(task_t *task) { return task && pthread_equal(pthread_self(), task->task); }
+
 cutils_ticks_t task_get_ticks(void) {
   struct timespec res = {0};
   clock_gettime(CLOCK_REALTIME, &res);
   return res.tv_sec * 1000000000 + res.tv_nsec;
 }
 
+uint32_t task_get_ms(void) {
+  struct timespec res = {0};
+  clock_gettime(CLOCK_MONOTONIC, &res);
+  return (uint32_t)((uint64_t)res.tv_sec * 1000 + res.tv_nsec / 1000000);
+}
+
 void task_sleep(uint32_t ms) {
   struct timespec duration = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000};
   nanosleep(&duration, 0);
 }
 
+void task_yield(void) { sched_yield(); }
+
 void task_get_current_name(char *name, size_t string_len) {
   task_t *current = pthread_getspecific(s_task_private_key);
   if (current && current->sanity == TASK_SANITY) {
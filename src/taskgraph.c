@@ -0,0 +1,264 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <cutils/logger.h>
+#include <cutils/taskgraph.h>
+
+taskgraph_t *taskgraph_create(taskgraph_create_params_t *p_params) {
+  taskgraph_t *retval = 0;
+  CUTILS_ASSERTF(p_params && p_params->p_graph, "Provide valid Create Params");
+  CUTILS_ASSERTF(p_params->p_nodes && p_params->p_edges && p_params->p_order,
+                 "Task graph storage not provided");
+  taskgraph_t *p_graph = p_params->p_graph;
+  memset(p_graph, 0, sizeof(*p_graph));
+  CHECK_RUN(signal_new(&p_graph->done), return retval, "Couldn't create completion signal");
+  p_graph->p_nodes = p_params->p_nodes;
+  p_graph->max_nodes = p_params->max_nodes;
+  p_graph->p_edges = p_params->p_edges;
+  p_graph->max_edges = p_params->max_edges;
+  p_graph->p_order = p_params->p_order;
+  atomic_init(&p_graph->remaining, 0);
+  atomic_init(&p_graph->running, false);
+  retval = p_graph;
+  return retval;
+}
+
+void taskgraph_destroy(taskgraph_t *p_graph) {
+  if (p_graph) {
+    CUTILS_ASSERTF(!atomic_load(&p_graph->running), "Task graph destroyed while running");
+    signal_free(&p_graph->done);
+    p_graph->num_nodes = p_graph->num_edges = 0;
+  }
+}
+
+uint32_t taskgraph_add_node(taskgraph_t *p_graph,
+                            dispatch_queue_t *p_queue,
+                            dispatch_function_t fn,
+                            void *arg1,
+                            void *arg2) {
+  uint32_t retval = TASKGRAPH_NODE_INVALID;
+  CUTILS_ASSERT(p_graph && p_queue && fn);
+  CUTILS_ASSERTF(!atomic_load(&p_graph->running), "Task graph changed while running");
+  if (p_graph->num_nodes < p_graph->max_nodes) {
+    retval = p_graph->num_nodes++;
+    taskgraph_node_t *p_node = &p_graph->p_nodes[retval];
+    p_node->fn = fn;
+    p_node->arg1 = arg1;
+    p_node->arg2 = arg2;
+    p_node->p_queue = p_queue;
+    p_node->p_graph = p_graph;
+    p_node->first_edge = p_node->last_edge = TASKGRAPH_NODE_INVALID;
+    p_node->num_predecessors = 0;
+    atomic_init(&p_node->waiting, 0);
+    p_graph->checked = false;
+  }
+  return retval;
+}
+
+bool taskgraph_add_edge(taskgraph_t *p_graph, uint32_t from, uint32_t to) {
+  bool retval = false;
+  CUTILS_ASSERT(p_graph);
+  CUTILS_ASSERTF(!atomic_load(&p_graph->running), "Task graph changed while running");
+  if (from < p_graph->num_nodes && to < p_graph->num_nodes &&
+      p_graph->num_edges < p_graph->max_edges) {
+    uint32_t edge = p_graph->num_edges++;
+    p_graph->p_edges[edge] = (taskgraph_edge_t){.to = to, .next = TASKGRAPH_NODE_INVALID};
+    taskgraph_node_t *p_from = &p_graph->p_nodes[from];
+    if (p_from->last_edge == TASKGRAPH_NODE_INVALID) {
+      p_from->first_edge = edge;
+    } else {
+      p_graph->p_edges[p_from->last_edge].next = edge;
+    }
+    p_from->last_edge = edge;
+    p_graph->p_nodes[to].num_predecessors++;
+    p_graph->checked = false;
+    retval = true;
+  }
+  return retval;
+}
+
+/**
+ * Tells whether every node can be reached once its predecessors are done, by sorting the graph
+ * topologically. Only repeated after the graph has changed. Uses the in-degree counters, so it
+ * must not run while the graph does.
+ */
+static bool taskgraph_check(taskgraph_t *p_graph) {
+  if (!p_graph->checked) {
+    uint32_t queued = 0;
+    for (uint32_t i = 0; i < p_graph->num_nodes; i++) {
+      atomic_store_explicit(
+          &p_graph->p_nodes[i].waiting, p_graph->p_nodes[i].num_predecessors, memory_order_relaxed);
+      if (!p_graph->p_nodes[i].num_predecessors) {
+        p_graph->p_order[queued++] = i;
+      }
+    }
+    for (uint32_t sorted = 0; sorted < queued; sorted++) {
+      taskgraph_node_t *p_node = &p_graph->p_nodes[p_graph->p_order[sorted]];
+      for (uint32_t e = p_node->first_edge; e != TASKGRAPH_NODE_INVALID;
+           e = p_graph->p_edges[e].next) {
+        uint32_t to = p_graph->p_edges[e].to;
+        if (atomic_fetch_sub_explicit(&p_graph->p_nodes[to].waiting, 1, memory_order_relaxed) ==
+            1) {
+          p_graph->p_order[queued++] = to;
+        }
+      }
+    }
+    p_graph->acyclic = queued == p_graph->num_nodes;
+    p_graph->checked = true;
+  }
+  return p_graph->acyclic;
+}
+
+/**
+ * Ends a run. An asynchronous run clears `running` before posting its completion, so the completion
+ * can start the next run. A synchronous run only sends the done signal, and taskgraph_run() clears
+ * `running` once its wait returns: the signal cannot tell runs apart, so no other run may start
+ * before it has been consumed.
+ */
+static void taskgraph_complete(taskgraph_t *p_graph) {
+  dispatch_queue_t *p_queue = p_graph->p_done_queue;
+  dispatch_queue_post_data_t *p_post = p_graph->p_done_post;
+  if (p_post) {
+    atomic_store_explicit(&p_graph->running, false, memory_order_release);
+    // The record was reserved when the run started, so only a destroyed queue refuses it.
+    CUTILS_ASSERTF(dispatch_queue_post_reserved(p_queue, p_post),
+                   "Completion queue of a task graph destroyed while it ran");
+  } else {
+    signal_send(&p_graph->done);
+  }
+}
+
+static void taskgraph_node_run(void *arg1, void *arg2);
+
+static inline void taskgraph_release(taskgraph_node_t *p_node) {
+  CUTILS_ASSERTF(dispatch_queue_post_reserved(p_node->p_queue, p_node->p_post),
+                 "Queue of a task graph node destroyed while the graph ran");
+}
+
+/**
+ * Reserves the records a run posts through, one per node and one for the completion action, so
+ * that no post of the run can be refused once it has started. Gives them back if any is missing.
+ */
+static bool taskgraph_reserve(taskgraph_t *p_graph,
+                              dispatch_queue_t *p_queue,
+                              dispatch_function_t fn,
+                              void *arg1,
+                              void *arg2) {
+  uint32_t reserved = 0;
+  for (; reserved < p_graph->num_nodes; reserved++) {
+    taskgraph_node_t *p_node = &p_graph->p_nodes[reserved];
+    p_node->p_post = dispatch_queue_reserve_post(p_node->p_queue, taskgraph_node_run, p_node, NULL);
+    if (!p_node->p_post) {
+      break;
+    }
+  }
+  p_graph->p_done_post = (fn && reserved == p_graph->num_nodes)
+                             ? dispatch_queue_reserve_post(p_queue, fn, arg1, arg2)
+                             : NULL;
+  bool retval = reserved == p_graph->num_nodes && (!fn || p_graph->p_done_post);
+  if (!retval) {
+    for (uint32_t i = 0; i < reserved; i++) {
+      dispatch_queue_unreserve(p_graph->p_nodes[i].p_queue, p_graph->p_nodes[i].p_post);
+    }
+    if (p_graph->p_done_post) {
+      dispatch_queue_unreserve(p_queue, p_graph->p_done_post);
+    }
+  }
+  return retval;
+}
+
+static void taskgraph_node_run(void *arg1, void *arg2) {
+  (void)arg2;
+  taskgraph_node_t *p_node = (taskgraph_node_t *)arg1;
+  taskgraph_t *p_graph = p_node->p_graph;
+  p_node->fn(p_node->arg1, p_node->arg2);
+  for (uint32_t e = p_node->first_edge; e != TASKGRAPH_NODE_INVALID; e = p_graph->p_edges[e].next) {
+    taskgraph_node_t *p_next = &p_graph->p_nodes[p_graph->p_edges[e].to];
+    // Whichever predecessor finishes last posts the successor, and acq_rel hands it what every
+    // predecessor wrote.
+    if (atomic_fetch_sub_explicit(&p_next->waiting, 1, memory_order_acq_rel) == 1) {
+      taskgraph_release(p_next);
+    }
+  }
+  if (atomic_fetch_sub_explicit(&p_graph->remaining, 1, memory_order_acq_rel) == 1) {
+    taskgraph_complete(p_graph);
+  }
+}
+
+/** Starts a run that ends by posting `fn` to `p_queue`, or with the done signal if `fn` is NULL. */
+static bool taskgraph_start(taskgraph_t *p_graph,
+                            dispatch_queue_t *p_queue,
+                            dispatch_function_t fn,
+                            void *arg1,
+                            void *arg2) {
+  bool retval = false;
+  CUTILS_ASSERT(p_graph);
+  if (!atomic_exchange(&p_graph->running, true)) {
+    if (!taskgraph_check(p_graph)) {
+      CLOG("Task graph has a cycle");
+      atomic_store(&p_graph->running, false);
+    } else if (!taskgraph_reserve(p_graph, p_queue, fn, arg1, arg2)) {
+      CLOG("Task graph queues have too few free records for a run");
+      atomic_store(&p_graph->running, false);
+    } else {
+      p_graph->p_done_queue = p_queue;
+      for (uint32_t i = 0; i < p_graph->num_nodes; i++) {
+        atomic_store_explicit(&p_graph->p_nodes[i].waiting,
+                              p_graph->p_nodes[i].num_predecessors,
+                              memory_order_relaxed);
+      }
+      atomic_store_explicit(&p_graph->remaining, p_graph->num_nodes, memory_order_release);
+      if (!p_graph->num_nodes) {
+        taskgraph_complete(p_graph);
+      }
+      // The graph cannot complete before every root has been posted, so the loop is safe.
+      for (uint32_t i = 0; i < p_graph->num_nodes; i++) {
+        if (!p_graph->p_nodes[i].num_predecessors) {
+          taskgraph_release(&p_graph->p_nodes[i]);
+        }
+      }
+      retval = true;
+    }
+  }
+  return retval;
+}
+
+bool taskgraph_run_async(taskgraph_t *p_graph,
+                         dispatch_queue_t *p_queue,
+                         dispatch_function_t fn,
+                         void *arg1,
+                         void *arg2) {
+  CUTILS_ASSERTF(p_queue && fn, "Provide where to post the completion");
+  return taskgraph_start(p_graph, p_queue, fn, arg1, arg2);
+}
+
+bool taskgraph_run(taskgraph_t *p_graph) {
+  bool retval = taskgraph_start(p_graph, NULL, NULL, NULL, NULL);
+  if (retval) {
+    retval = signal_wait(&p_graph->done);
+    atomic_store_explicit(&p_graph->running, false, memory_order_release);
+  }
+  return retval;
+}
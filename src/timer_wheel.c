@@ -0,0 +1,390 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cutils/dispatch_queue.h>
+#include <cutils/logger.h>
+#include <cutils/timer_wheel.h>
+
+#ifndef CUTILS_SYSTEM_TIMERS
+#define CUTILS_SYSTEM_TIMERS (64)
+#endif
+
+#define TIMER_WHEEL_FLAG_WAKE (1 << 0)
+#define TIMER_WHEEL_FLAG_EXIT (1 << 1)
+#define TIMER_WHEEL_FLAG_EXITED (1 << 2)
+/* Sent once the expiry in `posting` has been posted. */
+#define TIMER_WHEEL_FLAG_POSTED (1 << 3)
+
+/* Number of ticks covered by the whole wheel. */
+#define TIMER_WHEEL_SPAN (1u << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS))
+
+#define LEVEL_SHIFT(level) (TIMER_WHEEL_SLOT_BITS * (level))
+
+static inline uint32_t ms_to_ticks(uint32_t ms) {
+  return (ms + CUTILS_TIMER_WHEEL_TICK_MS - 1) / CUTILS_TIMER_WHEEL_TICK_MS;
+}
+
+/**
+ * Files an entry into the slot covering its expiry. The cascade passes `cascading` so an entry
+ * due on the tick being processed goes into the current level 0 slot, which is taken right after,
+ * instead of being pushed to the next tick.
+ */
+static void
+timer_wheel_insert(timer_wheel_t *p_wheel, timer_wheel_entry_t *p_entry, bool cascading) {
+  uint32_t delta = p_entry->expires - p_wheel->now;
+  if ((int32_t)delta < 0 || (!delta && !cascading)) {
+    // Already due, the earliest slot that will still be processed is the next tick.
+    p_entry->expires = p_wheel->now + 1;
+    delta = 1;
+  }
+  uint32_t target = p_entry->expires;
+  uint32_t level = 0;
+  if (delta >= TIMER_WHEEL_SPAN) {
+    // Park it in the top level, it is re-filed each time its slot comes around.
+    target = p_wheel->now + TIMER_WHEEL_SPAN - 1;
+    level = TIMER_WHEEL_LEVELS - 1;
+  } else {
+    while (delta >> LEVEL_SHIFT(level + 1)) {
+      level++;
+    }
+  }
+  p_entry->level = (uint8_t)level;
+  p_entry->slot = (uint8_t)((target >> LEVEL_SHIFT(level)) & TIMER_WHEEL_SLOT_MASK);
+  p_entry->elem.next = p_entry->elem.prev = 0;
+  KLIST_HEAD_PREPEND(p_wheel->slots[level][p_entry->slot], &p_entry->elem);
+  p_wheel->occupied[level] |= (1ull << p_entry->slot);
+}
+
+static void timer_wheel_unlink(timer_wheel_t *p_wheel, timer_wheel_entry_t *p_entry) {
+  KListHead **pp_head = &p_wheel->slots[p_entry->level][p_entry->slot];
+  if (*pp_head == &p_entry->elem) {
+    *pp_head = p_entry->elem.next;
+  }
+  KLIST_REMOVE_ELEM(&p_entry->elem);
+  if (!*pp_head) {
+    p_wheel->occupied[p_entry->level] &= ~(1ull << p_entry->slot);
+  }
+}
+
+static KListHead *timer_wheel_take_slot(timer_wheel_t *p_wheel, uint32_t level, uint32_t slot) {
+  KListHead *retval = p_wheel->slots[level][slot];
+  p_wheel->slots[level][slot] = 0;
+  p_wheel->occupied[level] &= ~(1ull << slot);
+  return retval;
+}
+
+static void
+timer_wheel_fire(timer_wheel_t *p_wheel, timer_wheel_entry_t *p_entry, uint32_t target) {
+  p_wheel->p_fired[p_wheel->num_fired++] =
+      (timer_wheel_fire_t){.handle = p_entry->reload ? p_entry->handle : TIMER_WHEEL_INVALID,
+                           .p_queue = p_entry->p_queue,
+                           .fn = p_entry->fn,
+                           .arg1 = p_entry->arg1,
+                           .arg2 = p_entry->arg2};
+  if (p_entry->reload) {
+    p_entry->expires += p_entry->reload;
+    if ((int32_t)(target - p_entry->expires) > 0) {
+      // The task fell behind; skip the missed periods instead of posting them in a burst.
+      uint32_t behind = target - p_entry->expires;
+      p_entry->expires += ((behind + p_entry->reload - 1) / p_entry->reload) * p_entry->reload;
+    }
+    timer_wheel_insert(p_wheel, p_entry, false);
+  } else {
+    handle_table_release(p_wheel->p_handles, p_entry->handle);
+    p_wheel->count--;
+    pool_free(p_wheel->p_pool, p_entry);
+  }
+}
+
+/**
+ * Processes the next tick: cascades the slots of every level whose boundary was crossed, highest
+ * level first so entries can fall through more than one level, then fires the due level 0 slot.
+ */
+static void timer_wheel_tick(timer_wheel_t *p_wheel, uint32_t target) {
+  p_wheel->now++;
+  uint32_t top = 0;
+  while (top + 1 < TIMER_WHEEL_LEVELS && !(p_wheel->now & ((1u << LEVEL_SHIFT(top + 1)) - 1))) {
+    top++;
+  }
+  for (uint32_t level = top; level > 0; level--) {
+    uint32_t slot = (p_wheel->now >> LEVEL_SHIFT(level)) & TIMER_WHEEL_SLOT_MASK;
+    KListHead *head = timer_wheel_take_slot(p_wheel, level, slot);
+    while (head) {
+      KListElem *p_elem = 0;
+      KLIST_HEAD_POP(head, p_elem);
+      timer_wheel_insert(p_wheel, (timer_wheel_entry_t *)p_elem, true);
+    }
+  }
+  KListHead *head = timer_wheel_take_slot(p_wheel, 0, p_wheel->now & TIMER_WHEEL_SLOT_MASK);
+  while (head) {
+    KListElem *p_elem = 0;
+    KLIST_HEAD_POP(head, p_elem);
+    timer_wheel_entry_t *p_entry = (timer_wheel_entry_t *)p_elem;
+    if ((int32_t)(p_entry->expires - p_wheel->now) > 0) {
+      timer_wheel_insert(p_wheel, p_entry, false);
+    } else {
+      timer_wheel_fire(p_wheel, p_entry, target);
+    }
+  }
+}
+
+/**
+ * Processes ticks up to `target`. A tick fires every armed timer at most once, so it only starts
+ * while the fired list has room for all of them.
+ * @return - true once `target` is reached, false if the fired list has to be posted first
+ */
+static bool timer_wheel_advance(timer_wheel_t *p_wheel, uint32_t target) {
+  while (p_wheel->now != target && p_wheel->count &&
+         p_wheel->num_fired + p_wheel->count <= p_wheel->max_fired) {
+    timer_wheel_tick(p_wheel, target);
+  }
+  if (!p_wheel->count) {
+    // Nothing armed, nothing to walk through.
+    p_wheel->now = target;
+  }
+  return p_wheel->now == target;
+}
+
+/**
+ * Posts the collected expiries. Called by the timer task without the wheel lock. A repeating timer
+ * may have been cancelled since its expiry was taken, so its handle is checked again, and it stays
+ * in `posting` until the post is done so that timer_wheel_cancel() can wait for it.
+ */
+static void timer_wheel_post_fired(timer_wheel_t *p_wheel) {
+  for (uint32_t i = 0; i < p_wheel->num_fired; i++) {
+    timer_wheel_fire_t *p_fire = &p_wheel->p_fired[i];
+    bool post = true;
+    if (p_fire->handle != TIMER_WHEEL_INVALID) {
+      mutex_lock(&p_wheel->mtx, WAIT_FOREVER);
+      post = (handle_table_lookup(p_wheel->p_handles, p_fire->handle) != NULL);
+      if (post) {
+        p_wheel->posting = p_fire->handle;
+        event_flag_clear(&p_wheel->flags, TIMER_WHEEL_FLAG_POSTED);
+      }
+      mutex_unlock(&p_wheel->mtx);
+    }
+    if (post && !dispatch_async_f(p_fire->p_queue, p_fire->fn, p_fire->arg1, p_fire->arg2)) {
+      atomic_fetch_add(&p_wheel->refused, 1);
+      CLOG("Timer expiry refused by queue %s", p_fire->p_queue->label);
+    }
+    if (post && p_fire->handle != TIMER_WHEEL_INVALID) {
+      mutex_lock(&p_wheel->mtx, WAIT_FOREVER);
+      p_wheel->posting = TIMER_WHEEL_INVALID;
+      mutex_unlock(&p_wheel->mtx);
+      event_flag_send(&p_wheel->flags, TIMER_WHEEL_FLAG_POSTED);
+    }
+  }
+  p_wheel->num_fired = 0;
+}
+
+/**
+ * Returns the number of ticks until the next slot that needs processing, either a level 0 slot
+ * that is due or a higher level slot that has to be cascaded. 0 if no timer is armed.
+ */
+static uint32_t timer_wheel_next_wake(timer_wheel_t *p_wheel) {
+  uint32_t retval = 0;
+  if (p_wheel->count) {
+    retval = UINT32_MAX;
+    for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+      uint64_t occupied = p_wheel->occupied[level];
+      if (occupied) {
+        uint32_t unit = (p_wheel->now >> LEVEL_SHIFT(level)) + 1;
+        uint32_t rotate = unit & TIMER_WHEEL_SLOT_MASK;
+        occupied = (occupied >> rotate) | (occupied << ((TIMER_WHEEL_SLOTS - rotate) & 63));
+        unit += (uint32_t)__builtin_ctzll(occupied);
+        uint32_t wait = (unit << LEVEL_SHIFT(level)) - p_wheel->now;
+        retval = (wait < retval) ? wait : retval;
+      }
+    }
+  }
+  return retval;
+}
+
+static void timer_wheel_worker(void *ctx) {
+  timer_wheel_t *p_wheel = (timer_wheel_t *)ctx;
+  uint32_t wait_ms = WAIT_FOREVER;
+  while (1) {
+    uint32_t flags = 0;
+    event_flag_wait(&p_wheel->flags,
+                    TIMER_WHEEL_FLAG_WAKE | TIMER_WHEEL_FLAG_EXIT,
+                    WAIT_OR_CLEAR,
+                    &flags,
+                    wait_ms);
+    if (atomic_load(&p_wheel->destroying)) {
+      break;
+    }
+    mutex_lock(&p_wheel->mtx, WAIT_FOREVER);
+    uint32_t now_ms = task_get_ms();
+    uint32_t elapsed = (now_ms - p_wheel->now_ms) / CUTILS_TIMER_WHEEL_TICK_MS;
+    p_wheel->now_ms += elapsed * CUTILS_TIMER_WHEEL_TICK_MS;
+    uint32_t target = p_wheel->now + elapsed;
+    while (!timer_wheel_advance(p_wheel, target)) {
+      mutex_unlock(&p_wheel->mtx);
+      timer_wheel_post_fired(p_wheel);
+      mutex_lock(&p_wheel->mtx, WAIT_FOREVER);
+    }
+    uint32_t ticks = timer_wheel_next_wake(p_wheel);
+    p_wheel->sleeping = (ticks != 0);
+    p_wheel->wake_tick = p_wheel->now + ticks;
+    wait_ms = ticks ? (ticks * CUTILS_TIMER_WHEEL_TICK_MS) - (now_ms - p_wheel->now_ms)
+                    : WAIT_FOREVER;
+    mutex_unlock(&p_wheel->mtx);
+    timer_wheel_post_fired(p_wheel);
+  }
+  event_flag_send(&p_wheel->flags, TIMER_WHEEL_FLAG_EXITED);
+}
+
+timer_wheel_t *timer_wheel_create(timer_wheel_create_params_t *p_params) {
+  timer_wheel_t *retval = 0;
+
+  CUTILS_ASSERTF(p_params && p_params->p_wheel, "Provide valid Create Params");
+  timer_wheel_t *p_wheel = p_params->p_wheel;
+  memset(p_wheel, 0, sizeof(timer_wheel_t));
+  atomic_init(&p_wheel->destroying, false);
+
+  CUTILS_ASSERTF(mutex_new(&p_wheel->mtx), "Couldn't create mutex");
+  CUTILS_ASSERTF(event_flag_new(&p_wheel->flags), "Couldn't create event flags");
+  p_wheel->p_pool = pool_create(&p_params->pool_params);
+  CUTILS_ASSERTF(p_wheel->p_pool, "Unable to create timer pool");
+  p_wheel->p_handles = handle_table_create(&p_params->handle_params);
+  CUTILS_ASSERTF(p_wheel->p_handles, "Unable to create timer handles");
+  CUTILS_ASSERTF(p_params->p_fired && p_params->max_fired == p_wheel->p_pool->num_of_elements,
+                 "Fired list must hold every timer");
+  p_wheel->p_fired = p_params->p_fired;
+  p_wheel->max_fired = p_params->max_fired;
+  p_wheel->posting = TIMER_WHEEL_INVALID;
+  atomic_init(&p_wheel->refused, 0);
+  p_wheel->now_ms = task_get_ms();
+
+  p_params->task_params.func = timer_wheel_worker;
+  p_params->task_params.ctx = p_wheel;
+  p_wheel->p_task = task_new_static(&p_params->task_params);
+  CUTILS_ASSERTF(p_wheel->p_task, "Couldn't Create Task");
+  task_start(p_wheel->p_task);
+  retval = p_wheel;
+
+  return retval;
+}
+
+void timer_wheel_destroy(timer_wheel_t *p_wheel) {
+  if (p_wheel && !atomic_exchange(&p_wheel->destroying, true)) {
+    event_flag_send(&p_wheel->flags, TIMER_WHEEL_FLAG_EXIT);
+    if (event_flag_wait(
+            &p_wheel->flags, TIMER_WHEEL_FLAG_EXITED, WAIT_OR_CLEAR, NULL, WAIT_FOREVER)) {
+      task_destroy_static(p_wheel->p_task);
+      p_wheel->p_task = 0;
+      handle_table_destroy(p_wheel->p_handles);
+      p_wheel->p_handles = 0;
+      pool_destroy(p_wheel->p_pool);
+      p_wheel->p_pool = 0;
+      mutex_free(&p_wheel->mtx);
+      event_flag_free(&p_wheel->flags);
+    } else {
+      CUTILS_ASSERTF(0, "Failed to wait on timer task exit");
+    }
+  }
+}
+
+timer_wheel_h timer_wheel_arm(timer_wheel_t *p_wheel,
+                              dispatch_queue_t *p_queue,
+                              uint32_t delay_ms,
+                              uint32_t reload_ms,
+                              dispatch_function_t fn,
+                              void *arg1,
+                              void *arg2) {
+  timer_wheel_h retval = TIMER_WHEEL_INVALID;
+  if (p_wheel && p_queue && fn && !atomic_load(&p_wheel->destroying)) {
+    timer_wheel_entry_t *p_entry = pool_alloc(p_wheel->p_pool);
+    CHECK_RUN(p_entry, return retval, "%s(): No free timers", __FUNCTION__);
+    p_entry->p_queue = p_queue;
+    p_entry->fn = fn;
+    p_entry->arg1 = arg1;
+    p_entry->arg2 = arg2;
+    p_entry->reload = ms_to_ticks(reload_ms);
+
+    mutex_lock(&p_wheel->mtx, WAIT_FOREVER);
+    // The table has a slot per pool entry, so this cannot fail.
+    p_entry->handle = handle_table_alloc(p_wheel->p_handles, p_entry);
+    CUTILS_ASSERT(p_entry->handle != TIMER_WHEEL_INVALID);
+    // The wheel only advances when the task wakes, so count the ticks it has not processed yet.
+    uint32_t pending = (task_get_ms() - p_wheel->now_ms) / CUTILS_TIMER_WHEEL_TICK_MS;
+    p_entry->expires = p_wheel->now + pending + ms_to_ticks(delay_ms);
+    p_wheel->count++;
+    timer_wheel_insert(p_wheel, p_entry, false);
+    if (!p_wheel->sleeping || (int32_t)(p_entry->expires - p_wheel->wake_tick) < 0) {
+      p_wheel->sleeping = true;
+      p_wheel->wake_tick = p_entry->expires;
+      event_flag_send(&p_wheel->flags, TIMER_WHEEL_FLAG_WAKE);
+    }
+    retval = p_entry->handle;
+    mutex_unlock(&p_wheel->mtx);
+  }
+  return retval;
+}
+
+bool timer_wheel_cancel(timer_wheel_t *p_wheel, timer_wheel_h h_timer) {
+  bool retval = false;
+  if (p_wheel && h_timer != TIMER_WHEEL_INVALID) {
+    mutex_lock(&p_wheel->mtx, WAIT_FOREVER);
+    // Entries are only released under the lock, so a handle that resolves here is still armed.
+    timer_wheel_entry_t *p_entry = handle_table_lookup(p_wheel->p_handles, h_timer);
+    if (p_entry) {
+      timer_wheel_unlink(p_wheel, p_entry);
+      handle_table_release(p_wheel->p_handles, h_timer);
+      p_wheel->count--;
+      pool_free(p_wheel->p_pool, p_entry);
+      retval = true;
+    }
+    // An expiry taken before the cancel may be being posted. The handle no longer resolves, so
+    // once that post is done no other is made.
+    while (retval && p_wheel->posting == h_timer) {
+      mutex_unlock(&p_wheel->mtx);
+      event_flag_wait(&p_wheel->flags, TIMER_WHEEL_FLAG_POSTED, WAIT_OR, NULL, WAIT_FOREVER);
+      mutex_lock(&p_wheel->mtx, WAIT_FOREVER);
+    }
+    mutex_unlock(&p_wheel->mtx);
+  }
+  return retval;
+}
+
+TIMER_WHEEL_STORE_DECL(system_timers, CUTILS_SYSTEM_TIMERS, 4096);
+TIMER_WHEEL_STORE_DEF(system_timers);
+
+timer_wheel_t *timer_wheel_system_get(void) {
+  static atomic_uint s_state = 0;
+  enum { UNINITIALIZED, CREATING, READY };
+  unsigned int expected = UNINITIALIZED;
+  if (atomic_compare_exchange_strong(&s_state, &expected, CREATING)) {
+    timer_wheel_create_params_t params;
+    TIMER_WHEEL_CREATE_PARAMS_INIT(
+        params, system_timers, "system_timers", CUTILS_TASK_PRIORITY_HIGHEST);
+    CUTILS_ASSERTF(timer_wheel_create(&params), "Couldn't create the system timer wheel");
+    atomic_store(&s_state, READY);
+  } else {
+    while (atomic_load(&s_state) != READY) {
+      task_sleep(1);
+    }
+  }
+  return &TIMER_WHEEL_STORE(system_timers).wheel;
+}
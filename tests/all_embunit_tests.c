@@ -37,6 +37,7 @@ extern TestRef mem_ring_buffer_get_tests(void);
 extern TestRef os_mutex_get_tests(void);
 extern TestRef os_event_flag_get_tests(void);
 extern TestRef os_task_get_tests(void);
+extern TestRef os_task_placement_get_tests(void);
 extern TestRef queue_free_list_get_tests(void);
 extern TestRef queue_kqueue_get_tests(void);
 extern TestRef queue_ts_queue_simple_get_tests(void);
@@ -45,6 +46,7 @@ extern TestRef pool_get_tests(void);
 extern TestRef notifier_get_tests(void);
 extern TestRef notifier_static_store_get_tests(void);
 extern TestRef accumulator_get_tests(void);
+extern TestRef mem_report_get_tests(void);
 /* Note: dispatch_queue, asyncio, and state_event_loop tests
  * are excluded from the aggregate — they rely on task/thread
  * infrastructure not available on the host pthread platform. */
@@ -61,6 +63,7 @@ int main(void) {
   test_wrapper(os_mutex_get_tests);
   test_wrapper(os_event_flag_get_tests);
   test_wrapper(os_task_get_tests);
+  test_wrapper(os_task_placement_get_tests);
   test_wrapper(queue_free_list_get_tests);
   test_wrapper(queue_kqueue_get_tests);
   test_wrapper(queue_ts_queue_simple_get_tests);
@@ -69,6 +72,7 @@ int main(void) {
   test_wrapper(notifier_get_tests);
   test_wrapper(notifier_static_store_get_tests);
   test_wrapper(accumulator_get_tests);
+  test_wrapper(mem_report_get_tests);
 
   TestRunner_end();
   return 0;
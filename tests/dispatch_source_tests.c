@@ -0,0 +1,267 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cutils/dispatch_source.h>
+#include <embUnit/embUnit.h>
+#include <string.h>
+#ifdef CUTILS_HAVE_EPOLL
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+DISPATCH_QUEUE_STORE_DECL(ds_test_queue, 16, 4096);
+DISPATCH_QUEUE_STORE_DEF(ds_test_queue);
+DISPATCH_CONCURRENT_QUEUE_STORE_DECL(ds_test_cq, 2, 16, 4096);
+DISPATCH_CONCURRENT_QUEUE_STORE_DEF(ds_test_cq);
+
+typedef struct {
+  dispatch_queue_t *p_queue;
+  int fds[2];
+  signal_t drained;
+  signal_t cancelled;
+  signal_t release;
+  atomic_uint calls;
+  atomic_uint bytes;
+  uint32_t expected_bytes;
+  uint32_t events;
+  uintptr_t data;
+  uint32_t calls_at_cancel;
+} dispatch_source_test_data_t;
+
+static dispatch_source_test_data_t s_ds_test;
+
+static void blocked_action(void *arg1, void *arg2) {
+  (void)arg2;
+  signal_wait(&((dispatch_source_test_data_t *)arg1)->release);
+}
+
+static void cancelled_action(void *arg1, void *arg2) {
+  (void)arg2;
+  signal_send(&((dispatch_source_test_data_t *)arg1)->cancelled);
+}
+
+static void data_handler(void *ctx, uintptr_t data) {
+  dispatch_source_test_data_t *p_data = (dispatch_source_test_data_t *)ctx;
+  p_data->data = data;
+  atomic_fetch_add(&p_data->calls, 1);
+  signal_send(&p_data->drained);
+}
+
+static void data_source_merges_into_one_handler(void) {
+  dispatch_data_source_t source;
+  dispatch_data_source_init(
+      &source, DISPATCH_SOURCE_DATA_ADD, s_ds_test.p_queue, data_handler, &s_ds_test);
+
+  // Every merge lands while the queue is held, so one run sees the sum of them all.
+  TEST_ASSERT(dispatch_async_f(s_ds_test.p_queue, blocked_action, &s_ds_test, NULL));
+  for (uintptr_t i = 1; i <= 100; i++) {
+    dispatch_source_merge_data(&source, i);
+  }
+  dispatch_source_merge_data(&source, 0);
+  signal_send(&s_ds_test.release);
+  TEST_ASSERT(signal_wait_timed(&s_ds_test.drained, 1000));
+  TEST_ASSERT_EQUAL_INT(5050, (int)s_ds_test.data);
+
+  // Once the handler has run, the next merge posts it again.
+  dispatch_source_merge_data(&source, 7);
+  TEST_ASSERT(signal_wait_timed(&s_ds_test.drained, 1000));
+  TEST_ASSERT_EQUAL_INT(7, (int)s_ds_test.data);
+  TEST_ASSERT_EQUAL_INT(2, atomic_load(&s_ds_test.calls));
+  dispatch_data_source_cancel(&source, cancelled_action, &s_ds_test, NULL);
+  TEST_ASSERT(signal_wait_timed(&s_ds_test.cancelled, 1000));
+
+  dispatch_data_source_init(
+      &source, DISPATCH_SOURCE_DATA_OR, s_ds_test.p_queue, data_handler, &s_ds_test);
+  TEST_ASSERT(dispatch_async_f(s_ds_test.p_queue, blocked_action, &s_ds_test, NULL));
+  dispatch_source_merge_data(&source, 0x1);
+  dispatch_source_merge_data(&source, 0x4);
+  dispatch_source_merge_data(&source, 0x4);
+  signal_send(&s_ds_test.release);
+  TEST_ASSERT(signal_wait_timed(&s_ds_test.drained, 1000));
+  TEST_ASSERT_EQUAL_INT(0x5, (int)s_ds_test.data);
+  TEST_ASSERT_EQUAL_INT(3, atomic_load(&s_ds_test.calls));
+
+  // Cancelling skips the pending run, and later merges are ignored.
+  TEST_ASSERT(dispatch_async_f(s_ds_test.p_queue, blocked_action, &s_ds_test, NULL));
+  dispatch_source_merge_data(&source, 0x2);
+  dispatch_data_source_cancel(&source, cancelled_action, &s_ds_test, NULL);
+  dispatch_source_merge_data(&source, 0x8);
+  signal_send(&s_ds_test.release);
+  TEST_ASSERT(signal_wait_timed(&s_ds_test.cancelled, 1000));
+  TEST_ASSERT_EQUAL_INT(3, atomic_load(&s_ds_test.calls));
+}
+
+static void blocking_data_handler(void *ctx, uintptr_t data) {
+  dispatch_source_test_data_t *p_data = (dispatch_source_test_data_t *)ctx;
+  p_data->data = data;
+  signal_send(&p_data->drained);
+  signal_wait(&p_data->release);
+  atomic_fetch_add(&p_data->calls, 1);
+}
+
+static void cancelled_after_handler_action(void *arg1, void *arg2) {
+  (void)arg2;
+  dispatch_source_test_data_t *p_data = (dispatch_source_test_data_t *)arg1;
+  p_data->calls_at_cancel = atomic_load(&p_data->calls);
+  signal_send(&p_data->cancelled);
+}
+
+static void data_source_cancel_waits_for_running_handler(void) {
+  dispatch_concurrent_queue_create_params_t params;
+  DISPATCH_CONCURRENT_QUEUE_CREATE_PARAMS_INIT(
+      params, ds_test_cq, "ds_test_cq", CUTILS_TASK_PRIORITY_MEDIUM);
+  dispatch_queue_t *p_queue = dispatch_concurrent_queue_create(&params);
+  TEST_ASSERT(p_queue);
+  dispatch_data_source_t source;
+  dispatch_data_source_init(
+      &source, DISPATCH_SOURCE_DATA_ADD, p_queue, blocking_data_handler, &s_ds_test);
+  dispatch_source_merge_data(&source, 3);
+  TEST_ASSERT(signal_wait_timed(&s_ds_test.drained, 1000));
+
+  // Another worker is free, but the action still waits for the running handler to return.
+  TEST_ASSERT(
+      dispatch_data_source_cancel(&source, cancelled_after_handler_action, &s_ds_test, NULL));
+  bool cancelled_early = signal_wait_timed(&s_ds_test.cancelled, 50);
+  signal_send(&s_ds_test.release);
+  TEST_ASSERT(cancelled_early || signal_wait_timed(&s_ds_test.cancelled, 1000));
+  dispatch_queue_destroy(p_queue);
+  TEST_ASSERT(!cancelled_early);
+  TEST_ASSERT_EQUAL_INT(1, s_ds_test.calls_at_cancel);
+  TEST_ASSERT_EQUAL_INT(3, (int)s_ds_test.data);
+}
+
+#ifdef CUTILS_HAVE_EPOLL
+
+// Runs on the queue, draining whatever the pipe holds.
+static void read_handler(void *ctx, uint32_t events) {
+  dispatch_source_test_data_t *p_data = (dispatch_source_test_data_t *)ctx;
+  uint8_t buf[16];
+  ssize_t len = 0;
+  p_data->events |= events;
+  while ((len = read(p_data->fds[0], buf, sizeof(buf))) > 0) {
+    atomic_fetch_add(&p_data->bytes, (uint32_t)len);
+  }
+  atomic_fetch_add(&p_data->calls, 1);
+  if (atomic_load(&p_data->bytes) >= p_data->expected_bytes) {
+    signal_send(&p_data->drained);
+  }
+}
+
+static void readiness_posts_one_coalesced_handler(void) {
+  dispatch_source_h h_source = dispatch_source_create(
+      s_ds_test.fds[0], DISPATCH_SOURCE_READ, s_ds_test.p_queue, read_handler, &s_ds_test);
+  TEST_ASSERT(h_source != DISPATCH_SOURCE_INVALID);
+
+  s_ds_test.expected_bytes = 1;
+  TEST_ASSERT_EQUAL_INT(1, write(s_ds_test.fds[1], "a", 1));
+  TEST_ASSERT(signal_wait_timed(&s_ds_test.drained, 1000));
+  TEST_ASSERT_EQUAL_INT(1, atomic_load(&s_ds_test.calls));
+  TEST_ASSERT(s_ds_test.events & DISPATCH_SOURCE_READ);
+
+  // Hold the queue while the pipe becomes readable again and again. Only one handler is posted.
+  TEST_ASSERT(dispatch_async_f(s_ds_test.p_queue, blocked_action, &s_ds_test, NULL));
+  s_ds_test.expected_bytes = 4;
+  for (uint32_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL_INT(1, write(s_ds_test.fds[1], "b", 1));
+    task_sleep(5);
+  }
+  signal_send(&s_ds_test.release);
+  TEST_ASSERT(signal_wait_timed(&s_ds_test.drained, 1000));
+  TEST_ASSERT_EQUAL_INT(2, atomic_load(&s_ds_test.calls));
+
+  TEST_ASSERT(dispatch_source_cancel(h_source, cancelled_action, &s_ds_test, NULL));
+  TEST_ASSERT(!dispatch_source_cancel(h_source, cancelled_action, &s_ds_test, NULL));
+  TEST_ASSERT(signal_wait_timed(&s_ds_test.cancelled, 1000));
+  TEST_ASSERT_EQUAL_INT(1, write(s_ds_test.fds[1], "c", 1));
+  task_sleep(20);
+  TEST_ASSERT_EQUAL_INT(2, atomic_load(&s_ds_test.calls));
+}
+
+static void cancel_waits_for_pending_handler(void) {
+  dispatch_source_h h_source = dispatch_source_create(
+      s_ds_test.fds[0], DISPATCH_SOURCE_READ, s_ds_test.p_queue, read_handler, &s_ds_test);
+  TEST_ASSERT(h_source != DISPATCH_SOURCE_INVALID);
+  TEST_ASSERT(dispatch_async_f(s_ds_test.p_queue, blocked_action, &s_ds_test, NULL));
+  TEST_ASSERT_EQUAL_INT(1, write(s_ds_test.fds[1], "a", 1));
+  task_sleep(20);
+  // The handler is queued behind the blocked item. It is skipped, and the cancellation follows it.
+  TEST_ASSERT(dispatch_source_cancel(h_source, cancelled_action, &s_ds_test, NULL));
+  signal_send(&s_ds_test.release);
+  TEST_ASSERT(signal_wait_timed(&s_ds_test.cancelled, 1000));
+  TEST_ASSERT_EQUAL_INT(0, atomic_load(&s_ds_test.calls));
+}
+
+#endif // CUTILS_HAVE_EPOLL
+
+static void setUp(void) {
+  memset(&s_ds_test, 0, sizeof(s_ds_test));
+  TEST_ASSERT(signal_new(&s_ds_test.drained));
+  TEST_ASSERT(signal_new(&s_ds_test.cancelled));
+  TEST_ASSERT(signal_new(&s_ds_test.release));
+#ifdef CUTILS_HAVE_EPOLL
+  TEST_ASSERT(!pipe(s_ds_test.fds));
+  fcntl(s_ds_test.fds[0], F_SETFL, O_NONBLOCK);
+#endif
+  dispatch_queue_create_params_t queue_params;
+  DISPATCH_QUEUE_CREATE_PARAMS_INIT(
+      queue_params, ds_test_queue, "ds_test_queue", CUTILS_TASK_PRIORITY_MEDIUM);
+  s_ds_test.p_queue = dispatch_queue_create(&queue_params);
+}
+
+static void tearDown(void) {
+  dispatch_queue_destroy(s_ds_test.p_queue);
+#ifdef CUTILS_HAVE_EPOLL
+  close(s_ds_test.fds[0]);
+  close(s_ds_test.fds[1]);
+#endif
+  signal_free(&s_ds_test.drained);
+  signal_free(&s_ds_test.cancelled);
+  signal_free(&s_ds_test.release);
+}
+
+TestRef dispatch_source_get_tests(void) {
+  EMB_UNIT_TESTFIXTURES(fixtures){
+      new_TestFixture("Data source merges into one handler", data_source_merges_into_one_handler),
+      new_TestFixture("Data source cancel waits for a running handler",
+                      data_source_cancel_waits_for_running_handler),
+#ifdef CUTILS_HAVE_EPOLL
+      new_TestFixture("Readiness posts one coalesced handler",
+                      readiness_posts_one_coalesced_handler),
+      new_TestFixture("Cancel waits for a pending handler", cancel_waits_for_pending_handler),
+#endif
+  };
+  EMB_UNIT_TESTCALLER(dispatch_source_tests, "DispatchSourceTests", setUp, tearDown, fixtures);
+  return (TestRef)&dispatch_source_tests;
+}
+
+#ifndef AGGREGATE_RUNNER
+int main() {
+  TestRunner_start();
+  {
+    TestRunner_runTest(dispatch_source_get_tests());
+  }
+  TestRunner_end();
+  return 0;
+}
+#endif // AGGREGATE_RUNNER
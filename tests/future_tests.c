@@ -0,0 +1,169 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cutils/dispatch_queue.h>
+#include <cutils/future.h>
+#include <embUnit/embUnit.h>
+
+DISPATCH_QUEUE_STORE_DECL(future_test_a, 16, 4096);
+DISPATCH_QUEUE_STORE_DEF(future_test_a);
+DISPATCH_QUEUE_STORE_DECL(future_test_b, 16, 4096);
+DISPATCH_QUEUE_STORE_DEF(future_test_b);
+
+typedef struct {
+  dispatch_queue_t *p_queue_a;
+  dispatch_queue_t *p_queue_b;
+  signal_t release;
+  atomic_uint steps;
+} future_test_data_t;
+
+static future_test_data_t s_future_test;
+
+static void *add_f(void *arg1, void *arg2) {
+  return (void *)((uintptr_t)arg1 + (uintptr_t)arg2);
+}
+
+static void *blocked_add_f(void *arg1, void *arg2) {
+  signal_wait(&s_future_test.release);
+  return add_f(arg1, arg2);
+}
+
+// Continuations record the order they ran in through the step count.
+static void *plus_one_f(void *ctx, void *value) {
+  (void)ctx;
+  atomic_fetch_add(&s_future_test.steps, 1);
+  return (void *)((uintptr_t)value + 1);
+}
+
+static void *times_f(void *ctx, void *value) {
+  TEST_ASSERT_EQUAL_INT(1, atomic_fetch_add(&s_future_test.steps, 1));
+  return (void *)((uintptr_t)value * (uintptr_t)ctx);
+}
+
+static void released_futures_return_to_the_pool(void) {
+  static future_t *s_futures[256];
+  for (uint32_t round = 0; round < 2; round++) {
+    uint32_t count = 0;
+    while (count < GetArraySize(s_futures) && (s_futures[count] = future_new())) {
+      count++;
+    }
+    // The default CUTILS_SYSTEM_FUTURES.
+    TEST_ASSERT_EQUAL_INT(64, count);
+    for (uint32_t i = 0; i < count; i++) {
+      future_release(s_futures[i]);
+    }
+  }
+}
+
+static void wait_times_out_until_fulfilled(void) {
+  void *value = NULL;
+  future_t *p_future = future_new();
+  TEST_ASSERT(p_future);
+  TEST_ASSERT(!future_is_ready(p_future));
+  TEST_ASSERT(!future_wait(p_future, 10, &value));
+  TEST_ASSERT(future_fulfill(p_future, (void *)7));
+  TEST_ASSERT(!future_fulfill(p_future, (void *)8));
+  TEST_ASSERT(future_is_ready(p_future));
+  TEST_ASSERT(future_wait(p_future, NO_SLEEP, &value));
+  TEST_ASSERT_EQUAL_INT(7, (uintptr_t)value);
+  future_release(p_future);
+}
+
+static void async_future_is_fulfilled_by_its_work_item(void) {
+  void *value = NULL;
+  future_t *p_future =
+      dispatch_async_future_f(s_future_test.p_queue_a, add_f, (void *)40, (void *)2);
+  TEST_ASSERT(p_future);
+  TEST_ASSERT(future_wait(p_future, 2000, &value));
+  TEST_ASSERT_EQUAL_INT(42, (uintptr_t)value);
+  future_release(p_future);
+}
+
+static void continuations_chain_across_queues(void) {
+  void *value = NULL;
+  future_t *p_first =
+      dispatch_async_future_f(s_future_test.p_queue_a, blocked_add_f, (void *)1, (void *)2);
+  TEST_ASSERT(p_first);
+  future_t *p_second = future_then_f(p_first, s_future_test.p_queue_b, plus_one_f, NULL);
+  TEST_ASSERT(p_second);
+  future_t *p_third = future_then_f(p_second, s_future_test.p_queue_a, times_f, (void *)10);
+  TEST_ASSERT(p_third);
+  // The continuations keep what they read from, so only the last future needs holding on to.
+  future_release(p_first);
+  future_release(p_second);
+  TEST_ASSERT(!future_wait(p_third, 10, NULL));
+  signal_send(&s_future_test.release);
+  TEST_ASSERT(future_wait(p_third, 2000, &value));
+  TEST_ASSERT_EQUAL_INT(40, (uintptr_t)value);
+  TEST_ASSERT_EQUAL_INT(2, atomic_load(&s_future_test.steps));
+
+  // Attached after the value is there, a continuation is posted straight away.
+  future_t *p_late = future_then_f(p_third, s_future_test.p_queue_b, plus_one_f, NULL);
+  TEST_ASSERT(p_late);
+  TEST_ASSERT(future_wait(p_late, 2000, &value));
+  TEST_ASSERT_EQUAL_INT(41, (uintptr_t)value);
+  future_release(p_late);
+  future_release(p_third);
+}
+
+static void setUp(void) {
+  memset(&s_future_test, 0, sizeof(s_future_test));
+  TEST_ASSERT(signal_new(&s_future_test.release));
+  dispatch_queue_create_params_t params;
+  DISPATCH_QUEUE_CREATE_PARAMS_INIT(
+      params, future_test_a, "future_test_a", CUTILS_TASK_PRIORITY_MEDIUM);
+  s_future_test.p_queue_a = dispatch_queue_create(&params);
+  DISPATCH_QUEUE_CREATE_PARAMS_INIT(
+      params, future_test_b, "future_test_b", CUTILS_TASK_PRIORITY_MEDIUM);
+  s_future_test.p_queue_b = dispatch_queue_create(&params);
+  TEST_ASSERT(s_future_test.p_queue_a && s_future_test.p_queue_b);
+}
+
+static void tearDown(void) {
+  dispatch_queue_destroy(s_future_test.p_queue_b);
+  dispatch_queue_destroy(s_future_test.p_queue_a);
+  signal_free(&s_future_test.release);
+}
+
+TestRef future_get_tests(void) {
+  EMB_UNIT_TESTFIXTURES(fixtures){
+      new_TestFixture("Released futures return to the pool", released_futures_return_to_the_pool),
+      new_TestFixture("Wait times out until fulfilled", wait_times_out_until_fulfilled),
+      new_TestFixture("Async future is fulfilled by its work item",
+                      async_future_is_fulfilled_by_its_work_item),
+      new_TestFixture("Continuations chain across queues", continuations_chain_across_queues)};
+  EMB_UNIT_TESTCALLER(future_tests, "FutureTests", setUp, tearDown, fixtures);
+  return (TestRef)&future_tests;
+}
+
+#ifndef AGGREGATE_RUNNER
+int main() {
+  TestRunner_start();
+  {
+    TestRunner_runTest(future_get_tests());
+  }
+  TestRunner_end();
+  return 0;
+}
+#endif // AGGREGATE_RUNNER
@@ -0,0 +1,175 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cutils/dispatch_queue.h>
+#include <cutils/handle_table.h>
+#include <cutils/signal.h>
+#include <embUnit/embUnit.h>
+
+#define HANDLE_TABLE_TEST_SIZE (4)
+#define HANDLE_TABLE_CHURN_CYCLES (20000)
+
+HANDLE_TABLE_STORE_DECL(handle_table_test, HANDLE_TABLE_TEST_SIZE);
+HANDLE_TABLE_STORE_DEF(handle_table_test);
+
+DISPATCH_QUEUE_STORE_DECL(handle_table_churn_q, 4, 4096);
+DISPATCH_QUEUE_STORE_DEF(handle_table_churn_q);
+
+static handle_table_t *s_table;
+static uint32_t s_objects[HANDLE_TABLE_TEST_SIZE + 1];
+
+static void setUp(void) {
+  handle_table_create_params_t params;
+  HANDLE_TABLE_CREATE_PARAMS_INIT(params, handle_table_test);
+  s_table = handle_table_create(&params);
+}
+
+static void tearDown(void) {
+  handle_table_destroy(s_table);
+  s_table = 0;
+}
+
+static void handles_resolve_until_released(void) {
+  TEST_ASSERT(s_table);
+  handle_t h = handle_table_alloc(s_table, &s_objects[0]);
+  TEST_ASSERT(h != HANDLE_INVALID);
+  TEST_ASSERT(handle_table_lookup(s_table, h) == &s_objects[0]);
+  TEST_ASSERT(handle_table_release(s_table, h));
+  TEST_ASSERT(handle_table_lookup(s_table, h) == 0);
+  TEST_ASSERT_MESSAGE(!handle_table_release(s_table, h), "Double release must fail");
+}
+
+static void stale_handles_do_not_alias_reused_slots(void) {
+  handle_t stale[HANDLE_TABLE_TEST_SIZE];
+  for (uint32_t i = 0; i < HANDLE_TABLE_TEST_SIZE; i++) {
+    stale[i] = handle_table_alloc(s_table, &s_objects[i]);
+    TEST_ASSERT(stale[i] != HANDLE_INVALID);
+  }
+  for (uint32_t i = 0; i < HANDLE_TABLE_TEST_SIZE; i++) {
+    TEST_ASSERT(handle_table_release(s_table, stale[i]));
+  }
+  // Every slot is reused by a different object. None of the old handles may resolve to it.
+  handle_t fresh[HANDLE_TABLE_TEST_SIZE];
+  for (uint32_t i = 0; i < HANDLE_TABLE_TEST_SIZE; i++) {
+    fresh[i] = handle_table_alloc(s_table, &s_objects[HANDLE_TABLE_TEST_SIZE]);
+    TEST_ASSERT(fresh[i] != HANDLE_INVALID);
+  }
+  for (uint32_t i = 0; i < HANDLE_TABLE_TEST_SIZE; i++) {
+    TEST_ASSERT(!handle_table_is_valid(s_table, stale[i]));
+    TEST_ASSERT(!handle_table_release(s_table, stale[i]));
+    TEST_ASSERT(handle_table_lookup(s_table, fresh[i]) == &s_objects[HANDLE_TABLE_TEST_SIZE]);
+  }
+  TEST_ASSERT(!handle_table_is_valid(s_table, HANDLE_INVALID));
+  TEST_ASSERT(!handle_table_is_valid(s_table, HANDLE_MAKE(HANDLE_TABLE_TEST_SIZE, 1)));
+}
+
+static void table_reports_exhaustion(void) {
+  handle_t h[HANDLE_TABLE_TEST_SIZE];
+  for (uint32_t i = 0; i < HANDLE_TABLE_TEST_SIZE; i++) {
+    h[i] = handle_table_alloc(s_table, &s_objects[i]);
+    TEST_ASSERT(h[i] != HANDLE_INVALID);
+  }
+  TEST_ASSERT(handle_table_alloc(s_table, &s_objects[0]) == HANDLE_INVALID);
+  TEST_ASSERT(handle_table_release(s_table, h[2]));
+  TEST_ASSERT(handle_table_alloc(s_table, &s_objects[0]) != HANDLE_INVALID);
+}
+
+static void generations_survive_recreation(void) {
+  handle_t h = handle_table_alloc(s_table, &s_objects[0]);
+  TEST_ASSERT(h != HANDLE_INVALID);
+  handle_table_destroy(s_table);
+  setUp();
+  TEST_ASSERT(s_table);
+  TEST_ASSERT(!handle_table_is_valid(s_table, h));
+  for (uint32_t i = 0; i < HANDLE_TABLE_TEST_SIZE; i++) {
+    TEST_ASSERT(handle_table_alloc(s_table, &s_objects[i]) != h);
+  }
+}
+
+typedef struct {
+  signal_t done;
+  bool ok;
+} churn_data_t;
+
+static void churn_f(void *arg1, void *arg2) {
+  (void)arg2;
+  churn_data_t *p_data = (churn_data_t *)arg1;
+  for (uint32_t i = 0; i < HANDLE_TABLE_CHURN_CYCLES && p_data->ok; i++) {
+    handle_t h = handle_table_alloc(s_table, &s_objects[1]);
+    p_data->ok = (h != HANDLE_INVALID) && handle_table_release(s_table, h);
+  }
+  signal_send(&p_data->done);
+}
+
+static void lookups_are_consistent_under_churn(void) {
+  static churn_data_t data;
+  dispatch_queue_create_params_t params = {0};
+  handle_t live = handle_table_alloc(s_table, &s_objects[0]);
+  handle_t stale = handle_table_alloc(s_table, &s_objects[2]);
+  TEST_ASSERT(handle_table_release(s_table, stale));
+
+  DISPATCH_QUEUE_CREATE_PARAMS_INIT(
+      params, handle_table_churn_q, "handle_churn", CUTILS_TASK_PRIORITY_MEDIUM);
+  dispatch_queue_t *p_queue = dispatch_queue_create(&params);
+  TEST_ASSERT(p_queue);
+  data.ok = true;
+  signal_new(&data.done);
+  TEST_ASSERT(dispatch_async_f(p_queue, churn_f, &data, NULL));
+
+  bool consistent = true;
+  while (consistent && !signal_wait_timed(&data.done, NO_SLEEP)) {
+    consistent = (handle_table_lookup(s_table, live) == &s_objects[0]) &&
+                 (handle_table_lookup(s_table, stale) == 0);
+  }
+  if (!consistent) {
+    signal_wait(&data.done);
+  }
+  dispatch_queue_destroy(p_queue);
+  signal_free(&data.done);
+  TEST_ASSERT(data.ok);
+  TEST_ASSERT(consistent);
+}
+
+TestRef handle_table_get_tests(void) {
+  EMB_UNIT_TESTFIXTURES(fixtures){
+      new_TestFixture("Handles resolve until released", handles_resolve_until_released),
+      new_TestFixture("Stale handles do not alias reused slots",
+                      stale_handles_do_not_alias_reused_slots),
+      new_TestFixture("Table reports exhaustion", table_reports_exhaustion),
+      new_TestFixture("Generations survive table recreation", generations_survive_recreation),
+      new_TestFixture("Lookups are consistent under churn", lookups_are_consistent_under_churn)};
+  EMB_UNIT_TESTCALLER(handle_table_tests, "HandleTableTests", setUp, tearDown, fixtures);
+  return (TestRef)&handle_table_tests;
+}
+
+#ifndef AGGREGATE_RUNNER
+int main() {
+  TestRunner_start();
+  {
+    TestRunner_runTest(handle_table_get_tests());
+  }
+  TestRunner_end();
+  return 0;
+}
+#endif // AGGREGATE_RUNNER
@@ -0,0 +1,120 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cutils/dispatch_queue.h>
+#include <cutils/mem_report.h>
+#include <cutils/pool.h>
+#include <embUnit/embUnit.h>
+
+POOL_STORE_DECL(mem_report_test_pool, 8, 24, 8);
+POOL_STORE_DEF(mem_report_test_pool);
+
+DISPATCH_QUEUE_STORE_DECL(mem_report_test_dq, 4, 4096);
+DISPATCH_QUEUE_STORE_DEF(mem_report_test_dq);
+
+static const mem_report_record_t *find_record(mem_report_kind_e kind, const char *name) {
+  for (size_t i = 0; i < mem_report_record_count(); i++) {
+    const mem_report_record_t *p_record = mem_report_record_at(i);
+    if (p_record->kind == (uint32_t)kind && !strncmp(p_record->name, name, MEM_REPORT_NAME_LEN)) {
+      return p_record;
+    }
+  }
+  return NULL;
+}
+
+static void pool_store_is_registered(void) {
+  pool_create_params_t params;
+  const mem_report_record_t *p_record = find_record(MemReportPool, "mem_report_test_pool");
+  POOL_CREATE_INIT(params, mem_report_test_pool);
+  TEST_ASSERT_MESSAGE(p_record, "Pool store should be registered");
+  TEST_ASSERT_EQUAL_INT(MemReportPool, p_record->owner);
+  TEST_ASSERT_EQUAL_INT(params.num_of_elements, p_record->count);
+  TEST_ASSERT_EQUAL_INT(params.element_size_requested, p_record->element_size);
+  TEST_ASSERT_EQUAL_INT(sizeof(POOL_STORE(mem_report_test_pool)), p_record->size);
+
+  p_record = find_record(MemReportTsQueue, "pool_mem_report_test_pool");
+  TEST_ASSERT_MESSAGE(p_record, "The pool's free queue should be registered");
+  TEST_ASSERT_EQUAL_INT(MemReportPool, p_record->owner);
+  TEST_ASSERT_EQUAL_INT(params.queue_params.size, p_record->count);
+}
+
+static void composite_store_is_attributed_to_owner(void) {
+  dispatch_queue_create_params_t params;
+  const mem_report_record_t *p_queue = find_record(MemReportDispatchQueue, "mem_report_test_dq");
+  const mem_report_record_t *p_task =
+      find_record(MemReportTask, "dispatch_queue_mem_report_test_dq");
+  const mem_report_record_t *p_pool =
+      find_record(MemReportPool, "dispatch_queue_mem_report_test_dq");
+  DISPATCH_QUEUE_CREATE_PARAMS_INIT(
+      params, mem_report_test_dq, "mem_report_test_dq", CUTILS_TASK_PRIORITY_MEDIUM);
+  TEST_ASSERT(p_queue && p_task && p_pool);
+  TEST_ASSERT_EQUAL_INT(params.queue_params.size, p_queue->count);
+  TEST_ASSERT_EQUAL_INT(params.pool_params.num_of_elements, p_queue->count);
+  TEST_ASSERT_EQUAL_INT(MemReportDispatchQueue, p_task->owner);
+  TEST_ASSERT_EQUAL_INT(MemReportDispatchQueue, p_pool->owner);
+  TEST_ASSERT_EQUAL_INT(params.task_params.stack_size, p_task->element_size);
+  TEST_ASSERT(mem_report_subsystem_bytes(MemReportDispatchQueue) >=
+              (uint64_t)p_queue->size + p_task->size + p_pool->size);
+  TEST_ASSERT(mem_report_kind_bytes(MemReportTask) >= p_task->size);
+}
+
+static void count_record_f(const mem_report_record_t *p_record, void *ctx) {
+  size_t *p_count = (size_t *)ctx;
+  if (p_record->size) {
+    (*p_count)++;
+  }
+}
+
+static void foreach_visits_every_record(void) {
+  size_t visited = 0;
+  TEST_ASSERT_EQUAL_INT(mem_report_record_count(), mem_report_foreach(count_record_f, &visited));
+  TEST_ASSERT_EQUAL_INT(mem_report_record_count(), visited);
+  TEST_ASSERT(!mem_report_record_at(mem_report_record_count()));
+}
+
+static void setup(void) {}
+
+static void teardown(void) {}
+
+TestRef mem_report_get_tests(void) {
+  EMB_UNIT_TESTFIXTURES(fixture){
+      new_TestFixture("Pool store is registered", pool_store_is_registered),
+      new_TestFixture("Composite store is attributed to its owner",
+                      composite_store_is_attributed_to_owner),
+      new_TestFixture("Foreach visits every record", foreach_visits_every_record),
+  };
+  EMB_UNIT_TESTCALLER(mem_report_tests, "mem_report_tests", setup, teardown, fixture);
+  return (TestRef)&mem_report_tests;
+}
+
+#ifndef AGGREGATE_RUNNER
+int main() {
+  TestRunner_start();
+  {
+    TestRunner_runTest(mem_report_get_tests());
+  }
+  TestRunner_end();
+  return 0;
+}
+#endif // AGGREGATE_RUNNER
@@ -29,6 +29,10 @@
  * behavior). On the C11 platform and RTOS targets, these tests run normally.
  */
 
+#if defined(CUTILS_HAVE_PTHREAD_NP) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // sched_getcpu(), pthread_getname_np()
+#endif
+
 #include <cutils/event_flag.h>
 #include <cutils/mutex.h>
 #include <cutils/task.h>
@@ -193,6 +197,58 @@ static void basicPremption(void) {
 }
 #endif
 
+/* ---- TaskPlacement (1 test) ----
+ * Runs wherever the platform can pin and name threads.
+ */
+
+#ifdef CUTILS_HAVE_PTHREAD_NP
+
+TASK_STATIC_STORE_DECL(placement_tsk, 16 * 1024);
+TASK_STATIC_STORE_DEF(placement_tsk);
+
+typedef struct {
+  int cpu;
+  int policy;
+  char name[16];
+} task_placement_t;
+
+static void placement_thread_function(void *arg) {
+  task_placement_t *p_placement = (task_placement_t *)arg;
+  struct sched_param param;
+  p_placement->cpu = sched_getcpu();
+  pthread_getschedparam(pthread_self(), &p_placement->policy, &param);
+  pthread_getname_np(pthread_self(), p_placement->name, sizeof(p_placement->name));
+}
+
+static void taskPlacementTest(void) {
+  task_placement_t placement = {.cpu = -1, .policy = -1};
+  task_create_params_t params;
+  TASK_STATIC_INIT_CREATE_PARAMS(params,
+                                 placement_tsk,
+                                 (char *)"placement_test_task",
+                                 CUTILS_TASK_PRIORITY_MEDIUM,
+                                 placement_thread_function,
+                                 &placement);
+  params.affinity = 1;
+  params.sched_policy = TASK_SCHED_OTHER;
+  task_t *p_task = task_new_static(&params);
+  TEST_ASSERT(p_task);
+  task_start(p_task);
+  task_destroy_static(p_task);
+  TEST_ASSERT_EQUAL_INT(0, placement.cpu);
+  TEST_ASSERT_EQUAL_INT(SCHED_OTHER, placement.policy);
+  // The OS name is the label cut to 15 characters.
+  TEST_ASSERT_EQUAL_STRING("placement_test_", placement.name);
+
+  // No CPU in the mask exists, so creation fails instead of running the task unpinned.
+  params.affinity = (uint64_t)1 << 63;
+  TEST_ASSERT(!task_new_static(&params));
+}
+
+#else
+static void taskPlacementTest(void) {}
+#endif
+
 /* ---- TestRef exports ---- */
 
 TestRef os_mutex_get_tests(void) {
@@ -234,6 +290,12 @@ TestRef os_task_get_tests(void) {
 }
 #endif
 
+TestRef os_task_placement_get_tests(void) {
+  EMB_UNIT_TESTFIXTURES(fixtures){new_TestFixture("TaskPlacementTest", taskPlacementTest)};
+  EMB_UNIT_TESTCALLER(os_task_placement_tests, "os_task_placement_test", NULL, NULL, fixtures);
+  return (TestRef)&os_task_placement_tests;
+}
+
 #ifndef AGGREGATE_RUNNER
 int main() {
   TestRunner_start();
@@ -241,6 +303,7 @@ int main() {
     TestRunner_runTest(os_mutex_get_tests());
     TestRunner_runTest(os_event_flag_get_tests());
     TestRunner_runTest(os_task_get_tests());
+    TestRunner_runTest(os_task_placement_get_tests());
   }
   TestRunner_end();
   return 0;
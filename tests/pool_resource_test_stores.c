@@ -0,0 +1,55 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Pool storage for pool_resource_tests.cpp. Pools can only be defined from C, the C++ suite gets
+ * at them through the functions below.
+ */
+#include <cutils/pool.h>
+
+#define POOL_RESOURCE_TEST_ALIGN (16)
+
+POOL_STORE_DECL(pool_resource_small, 8, 32, POOL_RESOURCE_TEST_ALIGN);
+POOL_STORE_DECL(pool_resource_medium, 4, 128, POOL_RESOURCE_TEST_ALIGN);
+POOL_STORE_DECL(pool_resource_large, 2, 512, POOL_RESOURCE_TEST_ALIGN);
+POOL_STORE_DEF(pool_resource_small);
+POOL_STORE_DEF(pool_resource_medium);
+POOL_STORE_DEF(pool_resource_large);
+
+void pool_resource_test_pools_create(pool_t *pools[3]) {
+  pool_create_params_t params;
+  POOL_CREATE_INIT(params, pool_resource_small);
+  pools[0] = pool_create(&params);
+  POOL_CREATE_INIT(params, pool_resource_medium);
+  pools[1] = pool_create(&params);
+  POOL_CREATE_INIT(params, pool_resource_large);
+  pools[2] = pool_create(&params);
+}
+
+void pool_resource_test_pools_destroy(pool_t *pools[3]) {
+  for (int i = 0; i < 3; i++) {
+    pool_destroy(pools[i]);
+    pools[i] = NULL;
+  }
+}
@@ -0,0 +1,152 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cutils/pool_resource.hpp>
+#include <embUnit/embUnit.h>
+#include <new>
+#include <vector>
+
+extern "C" {
+void pool_resource_test_pools_create(pool_t *pools[3]);
+void pool_resource_test_pools_destroy(pool_t *pools[3]);
+}
+
+static pool_t *s_pools[3];
+
+static void setUp(void) { pool_resource_test_pools_create(s_pools); }
+
+static void tearDown(void) { pool_resource_test_pools_destroy(s_pools); }
+
+static void pool_resource_serves_from_pool_until_exhausted(void) {
+  cutils::pool_resource res(s_pools[0]);
+  void *blocks[8];
+  for (auto &p : blocks) {
+    p = res.allocate(32, 16);
+    TEST_ASSERT(p != nullptr);
+    TEST_ASSERT(pool_ops_owns(s_pools[0], p));
+  }
+
+  bool threw = false;
+  try {
+    (void)res.allocate(32, 16);
+  } catch (const std::bad_alloc &) {
+    threw = true;
+  }
+  TEST_ASSERT_MESSAGE(threw, "Exhausted pool should fall through to the null upstream");
+
+  res.deallocate(blocks[3], 32, 16);
+  void *p = res.allocate(16, 8);
+  TEST_ASSERT(p == blocks[3]);
+  for (auto &b : blocks) {
+    res.deallocate(b, 32, 16);
+  }
+}
+
+static void pool_resource_forwards_oversized_requests_upstream(void) {
+  cutils::pool_resource res(s_pools[0], std::pmr::new_delete_resource());
+  void *p = res.allocate(64, 8);
+  TEST_ASSERT(p != nullptr);
+  TEST_ASSERT(!pool_ops_owns(s_pools[0], p));
+  res.deallocate(p, 64, 8);
+}
+
+static void size_class_resource_picks_smallest_fitting_class(void) {
+  // Supplied out of order on purpose.
+  cutils::size_class_resource<3> res({s_pools[2], s_pools[0], s_pools[1]});
+  TEST_ASSERT_EQUAL_INT(512, (int)res.max_block_size());
+
+  void *p_small = res.allocate(24, 8);
+  void *p_medium = res.allocate(100, 16);
+  void *p_large = res.allocate(400, 16);
+  TEST_ASSERT(pool_ops_owns(s_pools[0], p_small));
+  TEST_ASSERT(pool_ops_owns(s_pools[1], p_medium));
+  TEST_ASSERT(pool_ops_owns(s_pools[2], p_large));
+  res.deallocate(p_small, 24, 8);
+  res.deallocate(p_medium, 100, 16);
+  res.deallocate(p_large, 400, 16);
+}
+
+static void size_class_resource_spills_into_larger_classes(void) {
+  cutils::size_class_resource<3> res({s_pools[0], s_pools[1], s_pools[2]});
+  std::vector<void *> blocks;
+  // 8 small + 4 medium + 2 large blocks can hold a small request.
+  for (int i = 0; i < 14; i++) {
+    void *p = res.allocate(32, 16);
+    TEST_ASSERT(p != nullptr);
+    blocks.push_back(p);
+  }
+  TEST_ASSERT(pool_ops_owns(s_pools[2], blocks.back()));
+
+  bool threw = false;
+  try {
+    (void)res.allocate(32, 16);
+  } catch (const std::bad_alloc &) {
+    threw = true;
+  }
+  TEST_ASSERT(threw);
+  for (void *p : blocks) {
+    res.deallocate(p, 32, 16);
+  }
+}
+
+static void size_class_resource_backs_pmr_containers(void) {
+  cutils::size_class_resource<3> res({s_pools[0], s_pools[1], s_pools[2]});
+  std::pmr::vector<uint32_t> v(&res);
+  for (uint32_t i = 0; i < 100; i++) {
+    v.push_back(i);
+  }
+  TEST_ASSERT(pool_ops_owns(s_pools[2], v.data()));
+  uint32_t sum = 0;
+  for (uint32_t x : v) {
+    sum += x;
+  }
+  TEST_ASSERT_EQUAL_INT(4950, (int)sum);
+}
+
+extern "C" TestRef pool_resource_get_tests() {
+  EMB_UNIT_TESTFIXTURES(fixtures){
+      new_TestFixture("pool_resource serves blocks from the pool until exhausted",
+                      pool_resource_serves_from_pool_until_exhausted),
+      new_TestFixture("pool_resource forwards oversized requests upstream",
+                      pool_resource_forwards_oversized_requests_upstream),
+      new_TestFixture("size_class_resource picks the smallest fitting class",
+                      size_class_resource_picks_smallest_fitting_class),
+      new_TestFixture("size_class_resource spills into larger classes",
+                      size_class_resource_spills_into_larger_classes),
+      new_TestFixture("size_class_resource backs pmr containers",
+                      size_class_resource_backs_pmr_containers)};
+  EMB_UNIT_TESTCALLER(pool_resource_test, "PoolResourceTests", setUp, tearDown, fixtures);
+  return (TestRef)&pool_resource_test;
+}
+
+#ifndef AGGREGATE_RUNNER
+int main() {
+  TestRunner_start();
+  {
+    TestRunner_runTest(pool_resource_get_tests());
+  }
+  TestRunner_end();
+  return 0;
+}
+#endif // AGGREGATE_RUNNER
@@ -94,6 +94,48 @@ static void pool_static_should_create_with_params_aligned_allocations_test3(void
   TEST_A_POOL_WITH_CREATE_PARAMS(pool_test3);
 }
 
+#ifdef CUTILS_TS_QUEUE_HAS_STATIC_INIT
+#define _pool_static_test_ALIGN (16)
+#define _pool_static_test_QUEUE_SIZE (8)
+POOL_STORE_DECL(pool_static_test, _pool_static_test_QUEUE_SIZE, sizeof(test_allocation_t),
+                _pool_static_test_ALIGN);
+POOL_STORE_DEF_STATIC(pool_static_test);
+
+static void pool_defined_statically_allocates_without_create(void) {
+  pool_t *p_pool = POOL_STATIC(pool_static_test);
+  void *allocs[_pool_static_test_QUEUE_SIZE];
+  for (uint32_t i = 0; i < _pool_static_test_QUEUE_SIZE; i++) {
+    allocs[i] = pool_alloc(p_pool);
+    TEST_ASSERT_MESSAGE(allocs[i], "Couldn't allocate from static pool");
+    TEST_ASSERT_MESSAGE(((size_t)allocs[i] & (_pool_static_test_ALIGN - 1)) == 0,
+                        "Allocation not aligned");
+    TEST_ASSERT(pool_owns(p_pool, allocs[i]));
+    pool_header_t *p_header =
+        (pool_header_t *)((uint8_t *)allocs[i] - p_pool->offset_data_from_header);
+    TEST_ASSERT_MESSAGE(POOL_ELEMENT_HEADER_SANITY == p_header->sanity,
+                        "Header sanity is not valid");
+    TEST_ASSERT_MESSAGE(POOL_ELEMENT_TRAILER_SANITY ==
+                            *((uint32_t *)((uint8_t *)allocs[i] + p_pool->element_size)),
+                        "Footer sanity does not match");
+    for (uint32_t j = 0; j < i; j++) {
+      TEST_ASSERT(allocs[i] != allocs[j]);
+    }
+  }
+  TEST_ASSERT_MESSAGE(!pool_alloc(p_pool), "Static pool should be exhausted");
+
+  pool_retain(p_pool, allocs[3]);
+  pool_free(p_pool, allocs[3]);
+  TEST_ASSERT(!pool_alloc(p_pool));
+  pool_free(p_pool, allocs[3]);
+  TEST_ASSERT(pool_alloc(p_pool) == allocs[3]);
+
+  for (uint32_t i = 0; i < _pool_static_test_QUEUE_SIZE; i++) {
+    pool_free(p_pool, allocs[i]);
+  }
+  TEST_ASSERT_EQUAL_INT(_pool_static_test_QUEUE_SIZE, (int)ts_queue_get_count(p_pool->q));
+}
+#endif
+
 typedef struct _ref_count_test_t {
   uint32_t total_count;
 } ref_count_test_t;
@@ -159,6 +201,32 @@ static void pool_test_ref_count(void) {
   pool_destroy(p_pool);
 }
 
+static void pool_free_batch_returns_unreferenced_blocks(void) {
+  pool_create_params_t params;
+  POOL_CREATE_INIT(params, pool_test2);
+  pool_t *p_pool = pool_create(&params);
+  TEST_ASSERT_MESSAGE(p_pool, "Couldn't create Static Pool");
+  void *allocs[_pool_test2_QUEUE_SIZE];
+  for (uint32_t i = 0; i < _pool_test2_QUEUE_SIZE; i++) {
+    allocs[i] = pool_alloc(p_pool);
+    TEST_ASSERT_NOT_NULL(allocs[i]);
+  }
+  void *p_retained = allocs[2];
+  pool_retain(p_pool, p_retained);
+  pool_set_destructor(p_pool, allocs[5], test_destructor_f, NULL);
+
+  pool_free_batch(p_pool, allocs, _pool_test2_QUEUE_SIZE);
+  TEST_ASSERT_EQUAL_INT(_pool_test2_QUEUE_SIZE - 1, (int)ts_queue_get_count(p_pool->q));
+  TEST_ASSERT_MESSAGE(s_test_data.total_count == (uint32_t)-1, "Destructor not called");
+  for (uint32_t i = 0; i < _pool_test2_QUEUE_SIZE - 1; i++) {
+    TEST_ASSERT(pool_alloc(p_pool) != p_retained);
+  }
+  TEST_ASSERT(!pool_alloc(p_pool));
+  pool_free(p_pool, p_retained);
+  TEST_ASSERT(pool_alloc(p_pool) == p_retained);
+  pool_destroy(p_pool);
+}
+
 static void setUp(void) { memset(&s_test_data, 0, sizeof(s_test_data)); }
 
 static void tearDown(void) {}
@@ -352,8 +420,15 @@ TestRef pool_get_tests() {
       new_TestFixture("Pool is created with proper alignments using create params 3",
                       pool_static_should_create_with_params_aligned_allocations_test3),
       new_TestFixture("Pool allocations can be reference counted", pool_test_ref_count),
+      new_TestFixture("pool_free_batch returns unreferenced blocks",
+                      pool_free_batch_returns_unreferenced_blocks),
       new_TestFixture("Pool allocations can be referenced counted across many threads",
-                      pool_multi_thread_alloc_test)};
+                      pool_multi_thread_alloc_test),
+#ifdef CUTILS_TS_QUEUE_HAS_STATIC_INIT
+      new_TestFixture("Pool defined statically allocates without pool_create",
+                      pool_defined_statically_allocates_without_create),
+#endif
+  };
   EMB_UNIT_TESTCALLER(pool_basic_test, "PoolBasicTests", setUp, tearDown, fixtures);
   return (TestRef)&pool_basic_test;
 }
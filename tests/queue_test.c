@@ -77,6 +77,29 @@ static void freeListCanAllocateAsManyAsAvailable(void) {
                         (int)s_fl_list->current_available);
 }
 
+FREE_LIST_STORE_DECL(tq_static_free_list, free_list_test_unit_t, 4);
+FREE_LIST_STORE_DEF_STATIC(tq_static_free_list);
+
+static void freeListDefinedStaticallyNeedsNoInit(void) {
+  free_list_t *p_list = FREE_LIST_STATIC(tq_static_free_list);
+  free_list_test_unit_t *items[4];
+  for (uint32_t i = 0; i < GetArraySize(items); i++) {
+    items[i] = (free_list_test_unit_t *)free_list_get(p_list);
+    TEST_ASSERT(items[i] >= &FREE_LIST_STORE(tq_static_free_list).store[0] &&
+                items[i] <= &FREE_LIST_STORE(tq_static_free_list).store[3]);
+    for (uint32_t j = 0; j < i; j++) {
+      TEST_ASSERT(items[i] != items[j]);
+    }
+  }
+  TEST_ASSERT(!free_list_get(p_list));
+  TEST_ASSERT(free_list_put(p_list, &items[2]->elem));
+  TEST_ASSERT(free_list_get(p_list) == &items[2]->elem);
+  for (uint32_t i = 0; i < GetArraySize(items); i++) {
+    TEST_ASSERT(free_list_put(p_list, &items[i]->elem));
+  }
+  TEST_ASSERT_EQUAL_INT(4, (int)p_list->current_available);
+}
+
 /* -------------- kqueue_test (4 tests) ---------- */
 
 static kqueue_t s_kqueue = {0};
@@ -136,6 +159,86 @@ static void tsQueueFailIfSizeNotPowerOfTwo(void) {
   TEST_ASSERT(!ts_queue_init(&params));
 }
 
+TS_QUEUE_STORE_DECL(ts_queue_batch_q, 8);
+TS_QUEUE_STORE_DEF(ts_queue_batch_q);
+
+static void tsQueueBatchesKeepFIFOOrder(void) {
+  ts_queue_create_params_t params = {0};
+  TS_QUEUE_STORE_CREATE_PARAMS_INIT(params, ts_queue_batch_q);
+  ts_queue_t *p_queue = ts_queue_init(&params);
+  TEST_ASSERT(p_queue);
+  uint32_t values[10];
+  void *items[10];
+  for (uint32_t i = 0; i < GetArraySize(values); i++) {
+    items[i] = &values[i];
+  }
+  TEST_ASSERT(ts_queue_enqueue(p_queue, &values[0], NO_SLEEP));
+  // Only 7 of the 9 fit behind the first item.
+  TEST_ASSERT_EQUAL_INT(7, (int)ts_queue_enqueue_batch(p_queue, &items[1], 9, NO_SLEEP));
+  TEST_ASSERT_EQUAL_INT(8, (int)ts_queue_get_count(p_queue));
+
+  void *out[10] = {0};
+  TEST_ASSERT_EQUAL_INT(3, (int)ts_queue_dequeue_batch(p_queue, out, 3, NO_SLEEP));
+  TEST_ASSERT_EQUAL_INT(5, (int)ts_queue_dequeue_batch(p_queue, &out[3], 10, NO_SLEEP));
+  for (uint32_t i = 0; i < 8; i++) {
+    TEST_ASSERT(out[i] == &values[i]);
+  }
+  TEST_ASSERT_EQUAL_INT(0, (int)ts_queue_dequeue_batch(p_queue, out, 10, 1));
+  ts_queue_destroy(p_queue);
+}
+
+TS_QUEUE_STORE_DECL(ts_queue_if_q, 4);
+TS_QUEUE_STORE_DEF(ts_queue_if_q);
+
+static bool tsQueueTakeOdd(void *p_item, void *ctx) {
+  (void)ctx;
+  return *(uint32_t *)p_item & 1;
+}
+
+static void tsQueueDequeueIfOnlyTakesAcceptedHead(void) {
+  ts_queue_create_params_t params = {0};
+  TS_QUEUE_STORE_CREATE_PARAMS_INIT(params, ts_queue_if_q);
+  ts_queue_t *p_queue = ts_queue_init(&params);
+  TEST_ASSERT(p_queue);
+  uint32_t values[3] = {1, 2, 3};
+  void *p_item = NULL;
+  TEST_ASSERT(!ts_queue_dequeue_if(p_queue, tsQueueTakeOdd, NULL, &p_item));
+  for (uint32_t i = 0; i < GetArraySize(values); i++) {
+    TEST_ASSERT(ts_queue_enqueue(p_queue, &values[i], NO_SLEEP));
+  }
+  TEST_ASSERT(ts_queue_dequeue_if(p_queue, tsQueueTakeOdd, NULL, &p_item));
+  TEST_ASSERT(p_item == &values[0]);
+  // The even head stays where it is, and so does everything behind it.
+  TEST_ASSERT(!ts_queue_dequeue_if(p_queue, tsQueueTakeOdd, NULL, &p_item));
+  TEST_ASSERT_EQUAL_INT(2, (int)ts_queue_get_count(p_queue));
+  for (uint32_t i = 1; i < GetArraySize(values); i++) {
+    TEST_ASSERT(ts_queue_dequeue(p_queue, &p_item, NO_SLEEP));
+    TEST_ASSERT(p_item == &values[i]);
+  }
+  ts_queue_destroy(p_queue);
+}
+
+#ifdef CUTILS_TS_QUEUE_HAS_STATIC_INIT
+TS_QUEUE_STORE_DECL(ts_queue_static_q, 4);
+TS_QUEUE_STORE_DEF_STATIC(ts_queue_static_q);
+
+static void tsQueueDefinedStaticallyNeedsNoInit(void) {
+  ts_queue_t *p_queue = TS_QUEUE_STATIC(ts_queue_static_q);
+  uint32_t values[4];
+  void *p_item = NULL;
+  TEST_ASSERT_EQUAL_INT(0, (int)ts_queue_get_count(p_queue));
+  for (uint32_t i = 0; i < GetArraySize(values); i++) {
+    TEST_ASSERT(ts_queue_enqueue(p_queue, &values[i], NO_SLEEP));
+  }
+  TEST_ASSERT(!ts_queue_enqueue(p_queue, &values[0], 1));
+  for (uint32_t i = 0; i < GetArraySize(values); i++) {
+    TEST_ASSERT(ts_queue_dequeue(p_queue, &p_item, NO_SLEEP));
+    TEST_ASSERT(p_item == &values[i]);
+  }
+  TEST_ASSERT(!ts_queue_dequeue(p_queue, &p_item, 1));
+}
+#endif
+
 /* --------------- ts_queue_test (task-aware, 6 total tests) ------ */
 
 #if defined(CUTILS_TASK_USES_THRD_CREATE) || defined(RTOS_TASK_IMPLEMENTED)
@@ -266,7 +369,9 @@ TestRef queue_free_list_get_tests(void) {
   EMB_UNIT_TESTFIXTURES(fixtures){
       new_TestFixture("Can create free list with appropriate size",
                       freeListCanCreateWithAppropriateSize),
-      new_TestFixture("Can allocate as many as available", freeListCanAllocateAsManyAsAvailable)};
+      new_TestFixture("Can allocate as many as available", freeListCanAllocateAsManyAsAvailable),
+      new_TestFixture("Statically defined free list needs no init",
+                      freeListDefinedStaticallyNeedsNoInit)};
   EMB_UNIT_TESTCALLER(
       queue_free_list_tests, "queue_free_list_test", free_list_setUp, free_list_tearDown, fixtures);
   return (TestRef)&queue_free_list_tests;
@@ -286,7 +391,14 @@ TestRef queue_kqueue_get_tests(void) {
 
 TestRef queue_ts_queue_simple_get_tests(void) {
   EMB_UNIT_TESTFIXTURES(fixtures){
-      new_TestFixture("Queue should fail if size not power of 2", tsQueueFailIfSizeNotPowerOfTwo)};
+      new_TestFixture("Queue should fail if size not power of 2", tsQueueFailIfSizeNotPowerOfTwo),
+      new_TestFixture("Batches keep FIFO order", tsQueueBatchesKeepFIFOOrder),
+      new_TestFixture("Dequeue if only takes an accepted head",
+                      tsQueueDequeueIfOnlyTakesAcceptedHead),
+#ifdef CUTILS_TS_QUEUE_HAS_STATIC_INIT
+      new_TestFixture("Statically defined queue needs no init", tsQueueDefinedStaticallyNeedsNoInit),
+#endif
+  };
   EMB_UNIT_TESTCALLER(
       queue_ts_queue_simple_tests, "queue_ts_queue_simple_test", NULL, NULL, fixtures);
   return (TestRef)&queue_ts_queue_simple_tests;
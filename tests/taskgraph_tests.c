@@ -0,0 +1,179 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <cutils/dispatch_queue.h>
+#include <cutils/taskgraph.h>
+#include <embUnit/embUnit.h>
+
+DISPATCH_QUEUE_STORE_DECL(tg_test_serial, 16, 4096);
+DISPATCH_QUEUE_STORE_DEF(tg_test_serial);
+DISPATCH_CONCURRENT_QUEUE_STORE_DECL(tg_test_cq, 2, 16, 4096);
+DISPATCH_CONCURRENT_QUEUE_STORE_DEF(tg_test_cq);
+TASKGRAPH_STORE_DECL(tg_test_graph, 8, 8);
+TASKGRAPH_STORE_DEF(tg_test_graph);
+
+#define TG_TEST_NODES (5)
+
+typedef struct {
+  dispatch_queue_t *p_serial;
+  dispatch_queue_t *p_cq;
+  taskgraph_t *p_graph;
+  atomic_uint clock;
+  atomic_uint runs[TG_TEST_NODES];
+  uint32_t stamp[TG_TEST_NODES];
+  signal_t release;
+  signal_t done;
+  uint32_t done_at;
+} taskgraph_test_data_t;
+
+static taskgraph_test_data_t s_tg_test;
+
+static void node_f(void *arg1, void *arg2) {
+  (void)arg1;
+  uint32_t index = (uint32_t)(uintptr_t)arg2;
+  task_sleep(1);
+  s_tg_test.stamp[index] = atomic_fetch_add(&s_tg_test.clock, 1);
+  atomic_fetch_add(&s_tg_test.runs[index], 1);
+}
+
+static void blocked_node_f(void *arg1, void *arg2) {
+  signal_wait(&s_tg_test.release);
+  node_f(arg1, arg2);
+}
+
+static void done_f(void *arg1, void *arg2) {
+  (void)arg1;
+  (void)arg2;
+  s_tg_test.done_at = atomic_fetch_add(&s_tg_test.clock, 1);
+  signal_send(&s_tg_test.done);
+}
+
+// A fans out to B and C, which join in D. E depends on nothing.
+static void build_diamond(dispatch_function_t root_fn) {
+  uint32_t a = taskgraph_add_node(s_tg_test.p_graph, s_tg_test.p_serial, root_fn, NULL, (void *)0);
+  uint32_t b = taskgraph_add_node(s_tg_test.p_graph, s_tg_test.p_cq, node_f, NULL, (void *)1);
+  uint32_t c = taskgraph_add_node(s_tg_test.p_graph, s_tg_test.p_cq, node_f, NULL, (void *)2);
+  uint32_t d = taskgraph_add_node(s_tg_test.p_graph, s_tg_test.p_serial, node_f, NULL, (void *)3);
+  uint32_t e = taskgraph_add_node(s_tg_test.p_graph, s_tg_test.p_cq, node_f, NULL, (void *)4);
+  TEST_ASSERT(e == 4);
+  TEST_ASSERT(taskgraph_add_edge(s_tg_test.p_graph, a, b));
+  TEST_ASSERT(taskgraph_add_edge(s_tg_test.p_graph, a, c));
+  TEST_ASSERT(taskgraph_add_edge(s_tg_test.p_graph, b, d));
+  TEST_ASSERT(taskgraph_add_edge(s_tg_test.p_graph, c, d));
+  TEST_ASSERT(!taskgraph_add_edge(s_tg_test.p_graph, d, TG_TEST_NODES));
+}
+
+static void check_diamond_order(void) {
+  TEST_ASSERT(s_tg_test.stamp[0] < s_tg_test.stamp[1]);
+  TEST_ASSERT(s_tg_test.stamp[0] < s_tg_test.stamp[2]);
+  TEST_ASSERT(s_tg_test.stamp[1] < s_tg_test.stamp[3]);
+  TEST_ASSERT(s_tg_test.stamp[2] < s_tg_test.stamp[3]);
+}
+
+static void graph_runs_nodes_after_their_predecessors(void) {
+  build_diamond(node_f);
+  for (uint32_t run = 1; run <= 3; run++) {
+    TEST_ASSERT(taskgraph_run(s_tg_test.p_graph));
+    for (uint32_t i = 0; i < TG_TEST_NODES; i++) {
+      TEST_ASSERT_EQUAL_INT(run, atomic_load(&s_tg_test.runs[i]));
+    }
+    check_diamond_order();
+  }
+}
+
+static void async_run_posts_completion_once_all_nodes_ran(void) {
+  build_diamond(blocked_node_f);
+  TEST_ASSERT(
+      taskgraph_run_async(s_tg_test.p_graph, s_tg_test.p_serial, done_f, NULL, NULL));
+  // The root is held, so the graph is still running.
+  TEST_ASSERT(!taskgraph_run(s_tg_test.p_graph));
+  TEST_ASSERT(!taskgraph_run_async(s_tg_test.p_graph, s_tg_test.p_serial, done_f, NULL, NULL));
+  signal_send(&s_tg_test.release);
+  TEST_ASSERT(signal_wait_timed(&s_tg_test.done, 2000));
+  for (uint32_t i = 0; i < TG_TEST_NODES; i++) {
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&s_tg_test.runs[i]));
+    TEST_ASSERT(s_tg_test.stamp[i] < s_tg_test.done_at);
+  }
+  check_diamond_order();
+}
+
+static void graph_with_a_cycle_does_not_run(void) {
+  uint32_t x = taskgraph_add_node(s_tg_test.p_graph, s_tg_test.p_serial, node_f, NULL, (void *)0);
+  uint32_t y = taskgraph_add_node(s_tg_test.p_graph, s_tg_test.p_serial, node_f, NULL, (void *)1);
+  TEST_ASSERT(taskgraph_add_edge(s_tg_test.p_graph, x, y));
+  TEST_ASSERT(taskgraph_run(s_tg_test.p_graph));
+  TEST_ASSERT(taskgraph_add_edge(s_tg_test.p_graph, y, x));
+  TEST_ASSERT(!taskgraph_run(s_tg_test.p_graph));
+  TEST_ASSERT_EQUAL_INT(1, atomic_load(&s_tg_test.runs[0]));
+  TEST_ASSERT_EQUAL_INT(1, atomic_load(&s_tg_test.runs[1]));
+}
+
+static void setUp(void) {
+  memset(&s_tg_test, 0, sizeof(s_tg_test));
+  TEST_ASSERT(signal_new(&s_tg_test.release));
+  TEST_ASSERT(signal_new(&s_tg_test.done));
+  dispatch_queue_create_params_t queue_params;
+  DISPATCH_QUEUE_CREATE_PARAMS_INIT(
+      queue_params, tg_test_serial, "tg_test_serial", CUTILS_TASK_PRIORITY_MEDIUM);
+  s_tg_test.p_serial = dispatch_queue_create(&queue_params);
+  dispatch_concurrent_queue_create_params_t cq_params;
+  DISPATCH_CONCURRENT_QUEUE_CREATE_PARAMS_INIT(
+      cq_params, tg_test_cq, "tg_test_cq", CUTILS_TASK_PRIORITY_MEDIUM);
+  s_tg_test.p_cq = dispatch_concurrent_queue_create(&cq_params);
+  taskgraph_create_params_t graph_params;
+  TASKGRAPH_CREATE_PARAMS_INIT(graph_params, tg_test_graph);
+  s_tg_test.p_graph = taskgraph_create(&graph_params);
+  TEST_ASSERT(s_tg_test.p_graph);
+}
+
+static void tearDown(void) {
+  taskgraph_destroy(s_tg_test.p_graph);
+  dispatch_queue_destroy(s_tg_test.p_cq);
+  dispatch_queue_destroy(s_tg_test.p_serial);
+  signal_free(&s_tg_test.release);
+  signal_free(&s_tg_test.done);
+}
+
+TestRef taskgraph_get_tests(void) {
+  EMB_UNIT_TESTFIXTURES(fixtures){
+      new_TestFixture("Graph runs nodes after their predecessors",
+                      graph_runs_nodes_after_their_predecessors),
+      new_TestFixture("Async run posts completion once all nodes ran",
+                      async_run_posts_completion_once_all_nodes_ran),
+      new_TestFixture("Graph with a cycle does not run", graph_with_a_cycle_does_not_run)};
+  EMB_UNIT_TESTCALLER(taskgraph_tests, "TaskGraphTests", setUp, tearDown, fixtures);
+  return (TestRef)&taskgraph_tests;
+}
+
+#ifndef AGGREGATE_RUNNER
+int main() {
+  TestRunner_start();
+  {
+    TestRunner_runTest(taskgraph_get_tests());
+  }
+  TestRunner_end();
+  return 0;
+}
+#endif // AGGREGATE_RUNNER
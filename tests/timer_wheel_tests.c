@@ -0,0 +1,337 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cutils/dispatch_queue.h>
+#include <cutils/timer_wheel.h>
+#include <embUnit/embUnit.h>
+
+TIMER_WHEEL_STORE_DECL(tw_test_wheel, 64, 4096);
+TIMER_WHEEL_STORE_DEF(tw_test_wheel);
+
+DISPATCH_QUEUE_STORE_DECL(tw_test_queue, 64, 4096);
+DISPATCH_QUEUE_STORE_DEF(tw_test_queue);
+
+DISPATCH_QUEUE_STORE_DECL(tw_test_cancel_queue, 4, 4096);
+DISPATCH_QUEUE_STORE_DEF(tw_test_cancel_queue);
+
+#define TW_TEST_MAX_FIRES (16)
+
+typedef struct {
+  timer_wheel_t *p_wheel;
+  dispatch_queue_t *p_queue;
+  signal_t signal;
+  signal_t release;
+  atomic_uint count;
+  uint32_t start_ms;
+  uint32_t order[TW_TEST_MAX_FIRES];
+  uint32_t elapsed[TW_TEST_MAX_FIRES];
+  timer_wheel_h h_cancel;
+  atomic_bool cancelled;
+} timer_wheel_test_data_t;
+
+static timer_wheel_test_data_t s_tw_test;
+
+// Runs on the dispatch queue, so the bookkeeping below is single threaded.
+static void record_f(void *arg1, void *arg2) {
+  timer_wheel_test_data_t *p_data = (timer_wheel_test_data_t *)arg1;
+  uint32_t index = atomic_load_explicit(&p_data->count, memory_order_relaxed);
+  if (index < TW_TEST_MAX_FIRES) {
+    p_data->order[index] = (uint32_t)(uintptr_t)arg2;
+    p_data->elapsed[index] = task_get_ms() - p_data->start_ms;
+  }
+  atomic_fetch_add_explicit(&p_data->count, 1, memory_order_release);
+  signal_send(&p_data->signal);
+}
+
+// The signal is a flag, so fires that land close together wake the test once. Count them instead.
+static bool wait_for_fires(uint32_t count, uint32_t timeout_ms) {
+  uint32_t start = task_get_ms();
+  while (atomic_load(&s_tw_test.count) < count && task_get_ms() - start < timeout_ms) {
+    signal_wait_timed(&s_tw_test.signal, 10);
+  }
+  return atomic_load(&s_tw_test.count) >= count;
+}
+
+static void blocked_f(void *arg1, void *arg2) {
+  (void)arg2;
+  signal_wait(&((timer_wheel_test_data_t *)arg1)->release);
+}
+
+static void noop_f(void *arg1, void *arg2) {
+  (void)arg1;
+  (void)arg2;
+}
+
+static void timers_fire_in_order_across_levels(void) {
+  // 300ms sits two levels up and 70ms one level up, so both have to cascade down.
+  const uint32_t delays[] = {300, 5, 70, 20};
+  const uint32_t expected_order[] = {1, 3, 2, 0};
+  s_tw_test.start_ms = task_get_ms();
+  for (uint32_t i = 0; i < GetArraySize(delays); i++) {
+    TEST_ASSERT(timer_wheel_arm(s_tw_test.p_wheel,
+                                s_tw_test.p_queue,
+                                delays[i],
+                                0,
+                                record_f,
+                                &s_tw_test,
+                                (void *)(uintptr_t)i));
+  }
+  TEST_ASSERT(wait_for_fires(GetArraySize(delays), 2000));
+  task_sleep(20);
+  TEST_ASSERT_EQUAL_INT(GetArraySize(delays), atomic_load(&s_tw_test.count));
+  for (uint32_t i = 0; i < GetArraySize(delays); i++) {
+    TEST_ASSERT_EQUAL_INT(expected_order[i], s_tw_test.order[i]);
+    TEST_ASSERT_MESSAGE(s_tw_test.elapsed[i] >= delays[expected_order[i]], "Timer fired early");
+  }
+}
+
+static void cancelled_timers_do_not_fire(void) {
+  timer_wheel_h entries[8];
+  s_tw_test.start_ms = task_get_ms();
+  for (uint32_t i = 0; i < GetArraySize(entries); i++) {
+    entries[i] = timer_wheel_arm(s_tw_test.p_wheel,
+                                 s_tw_test.p_queue,
+                                 10 + (i * 10),
+                                 0,
+                                 record_f,
+                                 &s_tw_test,
+                                 (void *)(uintptr_t)i);
+    TEST_ASSERT(entries[i]);
+  }
+  for (uint32_t i = 0; i < GetArraySize(entries); i += 2) {
+    TEST_ASSERT(timer_wheel_cancel(s_tw_test.p_wheel, entries[i]));
+    TEST_ASSERT(!timer_wheel_cancel(s_tw_test.p_wheel, entries[i]));
+  }
+  TEST_ASSERT(wait_for_fires(GetArraySize(entries) / 2, 1000));
+  task_sleep(50);
+  TEST_ASSERT_EQUAL_INT(GetArraySize(entries) / 2, atomic_load(&s_tw_test.count));
+  for (uint32_t i = 0; i < GetArraySize(entries) / 2; i++) {
+    TEST_ASSERT_EQUAL_INT((i * 2) + 1, s_tw_test.order[i]);
+  }
+}
+
+static void repeating_timer_reloads_until_cancelled(void) {
+  s_tw_test.start_ms = task_get_ms();
+  timer_wheel_h h_timer =
+      timer_wheel_arm(s_tw_test.p_wheel, s_tw_test.p_queue, 5, 10, record_f, &s_tw_test, NULL);
+  TEST_ASSERT(h_timer != TIMER_WHEEL_INVALID);
+  TEST_ASSERT(wait_for_fires(4, 1000));
+  TEST_ASSERT(timer_wheel_cancel(s_tw_test.p_wheel, h_timer));
+  task_sleep(20);
+  uint32_t count = atomic_load(&s_tw_test.count);
+  task_sleep(50);
+  TEST_ASSERT_EQUAL_INT(count, atomic_load(&s_tw_test.count));
+  // Reloads keep their phase: the n-th expiry is never earlier than 5 + 10 * n ms.
+  for (uint32_t i = 0; i < 4; i++) {
+    TEST_ASSERT(s_tw_test.elapsed[i] >= 5 + (10 * i));
+  }
+}
+
+static uint32_t expires_of(timer_wheel_h h_timer) {
+  mutex_lock(&s_tw_test.p_wheel->mtx, WAIT_FOREVER);
+  timer_wheel_entry_t *p_entry = handle_table_lookup(s_tw_test.p_wheel->p_handles, h_timer);
+  uint32_t retval = p_entry ? p_entry->expires : UINT32_MAX;
+  mutex_unlock(&s_tw_test.p_wheel->mtx);
+  return retval;
+}
+
+static void boundary_expiries_keep_their_phase(void) {
+  timer_wheel_t *p_wheel = s_tw_test.p_wheel;
+  timer_wheel_h h_timer = TIMER_WHEEL_INVALID;
+  // Aim the first expiry at a level 1 boundary, so it cascades straight into the due slot. The
+  // clock can move on while arming, so retry until it lands there.
+  for (uint32_t i = 0; i < 10 && h_timer == TIMER_WHEEL_INVALID; i++) {
+    mutex_lock(&p_wheel->mtx, WAIT_FOREVER);
+    uint32_t ahead = p_wheel->now + (task_get_ms() - p_wheel->now_ms) / CUTILS_TIMER_WHEEL_TICK_MS;
+    mutex_unlock(&p_wheel->mtx);
+    uint32_t delay = ((2 * TIMER_WHEEL_SLOTS) - (ahead & TIMER_WHEEL_SLOT_MASK));
+    h_timer = timer_wheel_arm(p_wheel,
+                              s_tw_test.p_queue,
+                              delay * CUTILS_TIMER_WHEEL_TICK_MS,
+                              TIMER_WHEEL_SLOTS * CUTILS_TIMER_WHEEL_TICK_MS,
+                              record_f,
+                              &s_tw_test,
+                              NULL);
+    TEST_ASSERT(h_timer != TIMER_WHEEL_INVALID);
+    if (expires_of(h_timer) & TIMER_WHEEL_SLOT_MASK) {
+      TEST_ASSERT(timer_wheel_cancel(p_wheel, h_timer));
+      h_timer = TIMER_WHEEL_INVALID;
+    }
+  }
+  TEST_ASSERT(h_timer != TIMER_WHEEL_INVALID);
+  TEST_ASSERT(wait_for_fires(2, 2000));
+  // Every reload is a whole number of periods after the first expiry.
+  uint32_t phase = expires_of(h_timer) & TIMER_WHEEL_SLOT_MASK;
+  TEST_ASSERT(timer_wheel_cancel(p_wheel, h_timer));
+  TEST_ASSERT_EQUAL_INT(0, phase);
+}
+
+static void stale_handles_do_not_cancel_reused_timers(void) {
+  s_tw_test.start_ms = task_get_ms();
+  timer_wheel_h h_cancelled =
+      timer_wheel_arm(s_tw_test.p_wheel, s_tw_test.p_queue, 20, 0, record_f, &s_tw_test, NULL);
+  TEST_ASSERT(timer_wheel_cancel(s_tw_test.p_wheel, h_cancelled));
+  // The freed entry is handed out again, but under a new handle.
+  timer_wheel_h h_rearmed = timer_wheel_arm(
+      s_tw_test.p_wheel, s_tw_test.p_queue, 20, 0, record_f, &s_tw_test, (void *)1);
+  TEST_ASSERT(h_rearmed != TIMER_WHEEL_INVALID && h_rearmed != h_cancelled);
+  TEST_ASSERT(!timer_wheel_cancel(s_tw_test.p_wheel, h_cancelled));
+  TEST_ASSERT(wait_for_fires(1, 1000));
+
+  // A one shot timer's handle goes stale when it fires.
+  timer_wheel_h h_next = timer_wheel_arm(
+      s_tw_test.p_wheel, s_tw_test.p_queue, 20, 0, record_f, &s_tw_test, (void *)2);
+  TEST_ASSERT(!timer_wheel_cancel(s_tw_test.p_wheel, h_rearmed));
+  TEST_ASSERT(wait_for_fires(2, 1000));
+  TEST_ASSERT(!timer_wheel_cancel(s_tw_test.p_wheel, h_next));
+  TEST_ASSERT_EQUAL_INT(1, s_tw_test.order[0]);
+  TEST_ASSERT_EQUAL_INT(2, s_tw_test.order[1]);
+  TEST_ASSERT_EQUAL_INT(0, s_tw_test.p_wheel->count);
+}
+
+static void refused_expiries_are_counted(void) {
+  dispatch_queue_set_overflow(s_tw_test.p_queue, DISPATCH_OVERFLOW_FAIL, 0);
+  TEST_ASSERT(dispatch_async_f(s_tw_test.p_queue, blocked_f, &s_tw_test, NULL));
+  while (dispatch_async_f(s_tw_test.p_queue, noop_f, NULL, NULL)) {
+  }
+  TEST_ASSERT(
+      timer_wheel_arm(s_tw_test.p_wheel, s_tw_test.p_queue, 5, 0, record_f, &s_tw_test, NULL));
+  uint32_t start = task_get_ms();
+  while (!atomic_load(&s_tw_test.p_wheel->refused) && task_get_ms() - start < 1000) {
+    task_sleep(5);
+  }
+  TEST_ASSERT_EQUAL_INT(1, atomic_load(&s_tw_test.p_wheel->refused));
+  TEST_ASSERT_EQUAL_INT(0, s_tw_test.p_wheel->count);
+  signal_send(&s_tw_test.release);
+  // The wheel still serves its other timers.
+  TEST_ASSERT(
+      timer_wheel_arm(s_tw_test.p_wheel, s_tw_test.p_queue, 5, 0, record_f, &s_tw_test, NULL));
+  TEST_ASSERT(wait_for_fires(1, 1000));
+}
+
+/* Cancels the timer in `h_cancel`, then posts a marker that has to run after its last expiry. */
+static void cancel_then_mark_f(void *arg1, void *arg2) {
+  (void)arg2;
+  timer_wheel_test_data_t *p_data = (timer_wheel_test_data_t *)arg1;
+  TEST_ASSERT(timer_wheel_cancel(p_data->p_wheel, p_data->h_cancel));
+  atomic_store(&p_data->cancelled, true);
+  TEST_ASSERT(dispatch_async_f(p_data->p_queue, record_f, p_data, (void *)1));
+}
+
+static void cancel_waits_for_expiries_in_flight(void) {
+  dispatch_queue_create_params_t params;
+  DISPATCH_QUEUE_CREATE_PARAMS_INIT(
+      params, tw_test_cancel_queue, "tw_test_cancel_queue", CUTILS_TASK_PRIORITY_MEDIUM);
+  dispatch_queue_t *p_cancel_queue = dispatch_queue_create(&params);
+  TEST_ASSERT(p_cancel_queue);
+  // Fill the target and make posts wait for room, so the wheel is stuck posting the first expiry.
+  dispatch_queue_set_overflow(s_tw_test.p_queue, DISPATCH_OVERFLOW_BLOCK, WAIT_FOREVER);
+  TEST_ASSERT(dispatch_async_f(s_tw_test.p_queue, blocked_f, &s_tw_test, NULL));
+  while (dispatch_async_ex(s_tw_test.p_queue, noop_f, NULL, NULL, DISPATCH_OVERFLOW_FAIL, 0)) {
+  }
+  s_tw_test.h_cancel =
+      timer_wheel_arm(s_tw_test.p_wheel, s_tw_test.p_queue, 1, 1, record_f, &s_tw_test, NULL);
+  TEST_ASSERT(s_tw_test.h_cancel != TIMER_WHEEL_INVALID);
+  uint32_t start = task_get_ms();
+  while (s_tw_test.p_wheel->posting != s_tw_test.h_cancel && task_get_ms() - start < 1000) {
+    task_sleep(5);
+  }
+  TEST_ASSERT(dispatch_async_f(p_cancel_queue, cancel_then_mark_f, &s_tw_test, NULL));
+  task_sleep(20);
+  // The cancel waits until the expiry in flight is posted.
+  bool cancelled_early = atomic_load(&s_tw_test.cancelled);
+  signal_send(&s_tw_test.release);
+  TEST_ASSERT(!cancelled_early);
+  TEST_ASSERT(wait_for_fires(2, 1000));
+  task_sleep(20);
+  TEST_ASSERT_EQUAL_INT(2, atomic_load(&s_tw_test.count));
+  TEST_ASSERT_EQUAL_INT(0, s_tw_test.order[0]);
+  TEST_ASSERT_EQUAL_INT(1, s_tw_test.order[1]);
+  dispatch_queue_destroy(p_cancel_queue);
+}
+
+static void wheel_runs_out_of_timers(void) {
+  timer_wheel_h entries[64];
+  for (uint32_t i = 0; i < GetArraySize(entries); i++) {
+    entries[i] = timer_wheel_arm(
+        s_tw_test.p_wheel, s_tw_test.p_queue, 60000, 0, record_f, &s_tw_test, NULL);
+    TEST_ASSERT(entries[i]);
+  }
+  TEST_ASSERT(!timer_wheel_arm(
+      s_tw_test.p_wheel, s_tw_test.p_queue, 60000, 0, record_f, &s_tw_test, NULL));
+  for (uint32_t i = 0; i < GetArraySize(entries); i++) {
+    TEST_ASSERT(timer_wheel_cancel(s_tw_test.p_wheel, entries[i]));
+  }
+  TEST_ASSERT_EQUAL_INT(0, s_tw_test.p_wheel->count);
+  TEST_ASSERT_EQUAL_INT(0, atomic_load(&s_tw_test.count));
+}
+
+static void setUp(void) {
+  memset(&s_tw_test, 0, sizeof(s_tw_test));
+  TEST_ASSERT(signal_new(&s_tw_test.signal));
+  TEST_ASSERT(signal_new(&s_tw_test.release));
+  timer_wheel_create_params_t wheel_params;
+  TIMER_WHEEL_CREATE_PARAMS_INIT(
+      wheel_params, tw_test_wheel, "tw_test_wheel", CUTILS_TASK_PRIORITY_HIGHEST);
+  s_tw_test.p_wheel = timer_wheel_create(&wheel_params);
+  dispatch_queue_create_params_t queue_params;
+  DISPATCH_QUEUE_CREATE_PARAMS_INIT(
+      queue_params, tw_test_queue, "tw_test_queue", CUTILS_TASK_PRIORITY_MEDIUM);
+  s_tw_test.p_queue = dispatch_queue_create(&queue_params);
+}
+
+static void tearDown(void) {
+  timer_wheel_destroy(s_tw_test.p_wheel);
+  dispatch_queue_destroy(s_tw_test.p_queue);
+  signal_free(&s_tw_test.signal);
+  signal_free(&s_tw_test.release);
+}
+
+TestRef timer_wheel_get_tests(void) {
+  EMB_UNIT_TESTFIXTURES(fixtures){
+      new_TestFixture("Timers fire in order across wheel levels",
+                      timers_fire_in_order_across_levels),
+      new_TestFixture("Cancelled timers do not fire", cancelled_timers_do_not_fire),
+      new_TestFixture("Repeating timer reloads until cancelled",
+                      repeating_timer_reloads_until_cancelled),
+      new_TestFixture("Boundary expiries keep their phase", boundary_expiries_keep_their_phase),
+      new_TestFixture("Stale handles do not cancel reused timers",
+                      stale_handles_do_not_cancel_reused_timers),
+      new_TestFixture("Refused expiries are counted", refused_expiries_are_counted),
+      new_TestFixture("Cancel waits for expiries in flight", cancel_waits_for_expiries_in_flight),
+      new_TestFixture("Wheel runs out of timers", wheel_runs_out_of_timers)};
+  EMB_UNIT_TESTCALLER(timer_wheel_tests, "TimerWheelTests", setUp, tearDown, fixtures);
+  return (TestRef)&timer_wheel_tests;
+}
+
+#ifndef AGGREGATE_RUNNER
+int main() {
+  TestRunner_start();
+  {
+    TestRunner_runTest(timer_wheel_get_tests());
+  }
+  TestRunner_end();
+  return 0;
+}
+#endif // AGGREGATE_RUNNER
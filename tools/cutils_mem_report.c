@@ -0,0 +1,239 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2026> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * @brief Host side reader for the `cutils_mem_records` section of a linked ELF image.
+ *
+ * Usage: cutils_mem_report [-v] <elf>
+ *
+ * Prints the static memory footprint of every cutils store linked into the image grouped by the
+ * owning subsystem. With -v every individual record is listed as well. Works on 32 and 64 bit ELF
+ * files of either byte order so it can be pointed at a cross compiled firmware image.
+ */
+
+#include <cutils/mem_report.h>
+#include <elf.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  const uint8_t *p_data;
+  size_t size;
+  bool is_64;
+  bool swap;
+} elf_image_t;
+
+static uint16_t rd16(const elf_image_t *p_img, const void *p) {
+  uint16_t v;
+  memcpy(&v, p, sizeof(v));
+  return p_img->swap ? (uint16_t)((v >> 8) | (v << 8)) : v;
+}
+
+static uint32_t rd32(const elf_image_t *p_img, const void *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return p_img->swap ? __builtin_bswap32(v) : v;
+}
+
+static uint64_t rd64(const elf_image_t *p_img, const void *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return p_img->swap ? __builtin_bswap64(v) : v;
+}
+
+static bool in_bounds(const elf_image_t *p_img, uint64_t off, uint64_t len) {
+  return (off <= p_img->size) && (len <= p_img->size - off);
+}
+
+typedef enum { ShName, ShOffset, ShSize } shdr_field_e;
+
+/* Read one field of section header `idx` regardless of ELF class. */
+static uint64_t shdr_field(const elf_image_t *p_img, uint64_t shoff, uint16_t shentsize,
+                          uint16_t idx, shdr_field_e field) {
+  const uint8_t *p_sh = p_img->p_data + shoff + (uint64_t)idx * shentsize;
+  if (p_img->is_64) {
+    const Elf64_Shdr *sh = (const Elf64_Shdr *)p_sh;
+    return field == ShName     ? rd32(p_img, &sh->sh_name)
+           : field == ShOffset ? rd64(p_img, &sh->sh_offset)
+                               : rd64(p_img, &sh->sh_size);
+  }
+  const Elf32_Shdr *sh = (const Elf32_Shdr *)p_sh;
+  return field == ShName     ? rd32(p_img, &sh->sh_name)
+         : field == ShOffset ? rd32(p_img, &sh->sh_offset)
+                             : rd32(p_img, &sh->sh_size);
+}
+
+/* Locate the record section, returning its file offset and size. */
+static bool find_section(const elf_image_t *p_img, uint64_t *p_off, uint64_t *p_size) {
+  const uint8_t *p = p_img->p_data;
+  uint64_t shoff;
+  uint16_t shentsize, shnum, shstrndx;
+  if (p_img->is_64) {
+    const Elf64_Ehdr *eh = (const Elf64_Ehdr *)p;
+    shoff = rd64(p_img, &eh->e_shoff);
+    shentsize = rd16(p_img, &eh->e_shentsize);
+    shnum = rd16(p_img, &eh->e_shnum);
+    shstrndx = rd16(p_img, &eh->e_shstrndx);
+  } else {
+    const Elf32_Ehdr *eh = (const Elf32_Ehdr *)p;
+    shoff = rd32(p_img, &eh->e_shoff);
+    shentsize = rd16(p_img, &eh->e_shentsize);
+    shnum = rd16(p_img, &eh->e_shnum);
+    shstrndx = rd16(p_img, &eh->e_shstrndx);
+  }
+  if (!in_bounds(p_img, shoff, (uint64_t)shentsize * shnum) || shstrndx >= shnum) {
+    return false;
+  }
+
+  uint64_t strtab_off = shdr_field(p_img, shoff, shentsize, shstrndx, ShOffset);
+  uint64_t strtab_size = shdr_field(p_img, shoff, shentsize, shstrndx, ShSize);
+  if (!in_bounds(p_img, strtab_off, strtab_size)) {
+    return false;
+  }
+  for (uint16_t i = 0; i < shnum; i++) {
+    uint64_t name = shdr_field(p_img, shoff, shentsize, i, ShName);
+    if (name >= strtab_size) {
+      continue;
+    }
+    const char *p_name = (const char *)(p + strtab_off + name);
+    if (strncmp(p_name, MEM_REPORT_SECTION, strtab_size - name) == 0) {
+      *p_off = shdr_field(p_img, shoff, shentsize, i, ShOffset);
+      *p_size = shdr_field(p_img, shoff, shentsize, i, ShSize);
+      return in_bounds(p_img, *p_off, *p_size);
+    }
+  }
+  return false;
+}
+
+static uint8_t *read_file(const char *path, size_t *p_size) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return NULL;
+  }
+  uint8_t *p_buf = NULL;
+  if (fseek(f, 0, SEEK_END) == 0) {
+    long len = ftell(f);
+    if (len > 0 && fseek(f, 0, SEEK_SET) == 0) {
+      p_buf = malloc((size_t)len);
+      if (p_buf && fread(p_buf, 1, (size_t)len, f) != (size_t)len) {
+        free(p_buf);
+        p_buf = NULL;
+      }
+      *p_size = (size_t)len;
+    }
+  }
+  fclose(f);
+  return p_buf;
+}
+
+int main(int argc, char *argv[]) {
+  bool verbose = false;
+  const char *path = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [-v] <elf>\n", argv[0]);
+    return 2;
+  }
+
+  elf_image_t img = {0};
+  uint8_t *p_buf = read_file(path, &img.size);
+  if (!p_buf) {
+    fprintf(stderr, "%s: could not read file\n", path);
+    return 1;
+  }
+  img.p_data = p_buf;
+
+  int retval = 1;
+  if (img.size < EI_NIDENT || memcmp(p_buf, ELFMAG, SELFMAG) != 0) {
+    fprintf(stderr, "%s: not an ELF file\n", path);
+    goto exit;
+  }
+  img.is_64 = (p_buf[EI_CLASS] == ELFCLASS64);
+  const uint16_t probe = 1;
+  const bool host_le = (*(const uint8_t *)&probe == 1);
+  img.swap = ((p_buf[EI_DATA] == ELFDATA2LSB) != host_le);
+  if (img.size < (img.is_64 ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr))) {
+    fprintf(stderr, "%s: truncated ELF header\n", path);
+    goto exit;
+  }
+
+  uint64_t off = 0, size = 0;
+  if (!find_section(&img, &off, &size)) {
+    fprintf(stderr, "%s: no %s section found\n", path, MEM_REPORT_SECTION);
+    goto exit;
+  }
+
+  uint64_t owner_bytes[MemReportKindCount] = {0};
+  uint64_t total = 0;
+  size_t num = (size_t)(size / sizeof(mem_report_record_t));
+  for (size_t i = 0; i < num; i++) {
+    const mem_report_record_t *p_rec =
+        (const mem_report_record_t *)(p_buf + off + i * sizeof(mem_report_record_t));
+    uint32_t kind = rd32(&img, &p_rec->kind);
+    uint32_t owner = rd32(&img, &p_rec->owner);
+    uint32_t bytes = rd32(&img, &p_rec->size);
+    char name[MEM_REPORT_NAME_LEN + 1] = {0};
+    memcpy(name, p_rec->name, MEM_REPORT_NAME_LEN);
+    if (owner < MemReportKindCount) {
+      owner_bytes[owner] += bytes;
+    }
+    total += bytes;
+    if (verbose) {
+      const char *kind_name =
+          kind < MemReportKindCount ? get_mem_report_kind_e_string((mem_report_kind_e)kind) : "?";
+      const char *owner_name =
+          owner < MemReportKindCount ? get_mem_report_kind_e_string((mem_report_kind_e)owner) : "?";
+      printf("%-24s %-24s %-40s %8u bytes (%u x %u)\n",
+             kind_name,
+             owner_name,
+             name,
+             bytes,
+             rd32(&img, &p_rec->count),
+             rd32(&img, &p_rec->element_size));
+    }
+  }
+
+  printf("%zu records\n", num);
+  for (uint32_t k = 0; k < MemReportKindCount; k++) {
+    if (owner_bytes[k]) {
+      printf("  %-24s %10llu bytes\n", get_mem_report_kind_e_string((mem_report_kind_e)k),
+             (unsigned long long)owner_bytes[k]);
+    }
+  }
+  printf("  %-24s %10llu bytes\n", "total", (unsigned long long)total);
+  retval = 0;
+
+exit:
+  free(p_buf);
+  return retval;
+}